@@ -0,0 +1,9 @@
+#include "backoff.h"
+
+uint32_t BackoffDelay(const BackoffPolicy &policy, uint8_t failures)
+{
+  uint8_t shift = min(max(failures, (uint8_t)1) - 1, 16);
+  uint64_t delay = min((uint64_t)policy.base << shift, (uint64_t)policy.limit);
+  int32_t jitter = delay / 4;
+  return delay + random(-jitter, jitter + 1);
+}
@@ -0,0 +1,24 @@
+/*
+    backoff.h
+
+    Exponential backoff with jitter, shared by the provider cooldowns and
+    the per symbol retry delays.
+*/
+
+#ifndef BACKOFF_H
+#define BACKOFF_H
+
+#include <Arduino.h>
+
+// Delays in a unit of the caller's choosing, milliseconds for timers, seconds for epoch times.
+struct BackoffPolicy
+{
+    uint32_t base;  // Delay after the first failure.
+    uint32_t limit; // Longest delay.
+};
+
+// Base doubled for each further failure, capped at limit, then spread by +-25% so
+// devices behind the same outage do not retry in step. In the policy's unit.
+uint32_t BackoffDelay(const BackoffPolicy &policy, uint8_t failures);
+
+#endif
@@ -0,0 +1,1011 @@
+#include "configLoader.h"
+#include "logger.h"
+#include "hashPrint.h"
+#include <algorithm>
+
+#define ARDUINOJSON_USE_LONG_LONG 1
+#include <ArduinoJson.h>
+
+// Largest single section, the symbol and alert rule lists are streamed and do not count.
+static const size_t sectionCapacity = 2048;
+static const size_t maxSymbolLength = 11;
+
+// Buffered reader counting lines as they are consumed.
+class LineStream : public Stream
+{
+public:
+  LineStream(Stream &source) : source(source) {}
+
+  int available() override
+  {
+    return Fill() ? length - position + source.available() : 0;
+  }
+
+  int read() override
+  {
+    if (!Fill())
+    {
+      return -1;
+    }
+    char c = buf[position++];
+    if (c == '\n')
+    {
+      line++;
+    }
+    if (tracking)
+    {
+      Scan(c);
+    }
+    return c;
+  }
+
+  int peek() override
+  {
+    return Fill() ? buf[position] : -1;
+  }
+
+  size_t readBytes(char *buffer, size_t count) override
+  {
+    size_t total = 0;
+    int c;
+    while (total < count && (c = read()) >= 0)
+    {
+      buffer[total++] = c;
+    }
+    return total;
+  }
+
+  size_t write(uint8_t) override
+  {
+    return 0;
+  }
+
+  int Line()
+  {
+    return line;
+  }
+
+  // Position on the next non blank character.
+  int SkipWhitespace()
+  {
+    int c;
+    while ((c = peek()) >= 0 && isspace(c))
+    {
+      read();
+    }
+    return c;
+  }
+
+  // A member name and the line it was read on.
+  struct KeyLine
+  {
+    char key[32];
+    int line;
+  };
+
+  // Record member names from here on, forgetting earlier ones, or stop recording.
+  void TrackKeys(bool enable)
+  {
+    if (enable)
+    {
+      keys.clear();
+    }
+    tracking = enable;
+    inString = false;
+    closedString = false;
+  }
+
+  // Member names in the order they were read.
+  const std::vector<KeyLine> &Keys()
+  {
+    return keys;
+  }
+
+private:
+  // A string followed by ':' is a member name.
+  void Scan(char c)
+  {
+    if (inString)
+    {
+      if (!escaped && c == '\\')
+      {
+        escaped = true;
+        return;
+      }
+      if (!escaped && c == '"')
+      {
+        inString = false;
+        closedString = true;
+        return;
+      }
+      escaped = false;
+      if (textLength < sizeof(text) - 1)
+      {
+        text[textLength++] = c;
+      }
+    }
+    else if (c == '"')
+    {
+      inString = true;
+      escaped = false;
+      textLength = 0;
+      textLine = line;
+    }
+    else if (c == ':' && closedString)
+    {
+      KeyLine key;
+      memcpy(key.key, text, textLength);
+      key.key[textLength] = 0;
+      key.line = textLine;
+      keys.push_back(key);
+      closedString = false;
+    }
+    else if (!isspace(c))
+    {
+      closedString = false;
+    }
+  }
+
+  bool Fill()
+  {
+    if (position == length)
+    {
+      length = source.readBytes(buf, sizeof(buf));
+      position = 0;
+    }
+    return position < length;
+  }
+
+  Stream &source;
+  char buf[256];
+  size_t length = 0;
+  size_t position = 0;
+  int line = 1;
+
+  std::vector<KeyLine> keys;
+  bool tracking = false;
+  bool inString = false;
+  bool escaped = false;
+  bool closedString = false;
+  char text[sizeof(KeyLine::key)];
+  size_t textLength = 0;
+  int textLine = 0;
+};
+
+class ConfigLoader
+{
+public:
+  ConfigLoader(Stream &source, Parameters *parameters, Time *time, ConfigDigest *digest) : stream(source), parameters(parameters), time(time), digest(digest) {}
+
+  bool Load();
+
+private:
+  typedef void (ConfigLoader::*SectionParser)(JsonVariantConst value);
+
+  struct Section
+  {
+    const char *name;
+    SectionParser parse;
+    bool required;
+  };
+
+  static const Section sections[];
+  static const size_t sectionCount;
+
+  void Error(const char *format, ...) __attribute__((format(printf, 2, 3)));
+  void Locate(JsonVariantConst object, const char *key);
+  bool ReadKey(char *key, size_t size);
+  bool Expect(char expected);
+  bool LoadSymbols();
+  bool LoadAlertRules();
+  bool SkipValue();
+
+  // Members of the current section, defaulted when absent and reported when invalid.
+  int Int(JsonVariantConst object, const char *key, int defaultValue, int minValue, int maxValue);
+  double Float(JsonVariantConst object, const char *key, double defaultValue, double minValue, double maxValue);
+  bool Bool(JsonVariantConst object, const char *key, bool defaultValue);
+  String Text(JsonVariantConst object, const char *key, const char *defaultValue, size_t maxLength = 128);
+  TimeRange Range(JsonVariantConst object, const char *key, const char *defaultValue);
+
+  void ParseWifiCredentials(JsonVariantConst value);
+  void ParseApi(JsonVariantConst value);
+  void ParseMarket(JsonVariantConst value);
+  void ParseDisplay(JsonVariantConst value);
+  void ParseMatrix(JsonVariantConst value);
+  void ParseSystem(JsonVariantConst value);
+  void ParseDemo(JsonVariantConst value);
+  void ParseCapture(JsonVariantConst value);
+  void ParseReplay(JsonVariantConst value);
+  void ParseStreaming(JsonVariantConst value);
+  void ParseLocalApi(JsonVariantConst value);
+  void ParseCache(JsonVariantConst value);
+  void ParseLogos(JsonVariantConst value);
+  void ParseAlerts(JsonVariantConst value);
+  void ParsePeers(JsonVariantConst value);
+  void ParseHistory(JsonVariantConst value);
+  void ParseLog(JsonVariantConst value);
+
+  LineStream stream;
+  Parameters *parameters;
+  Time *time;
+  ConfigDigest *digest;
+  const char *sectionName = "";
+  int sectionLine = 0;
+  JsonVariantConst sectionRoot;
+  int fieldLine = 0; // Line of the member the next Error() is about, 0 for the section.
+  int errors = 0;
+  bool fatal = false;
+};
+
+const ConfigLoader::Section ConfigLoader::sections[] = {
+    {"wifiCredentials", &ConfigLoader::ParseWifiCredentials, true},
+    {"api", &ConfigLoader::ParseApi, false},
+    {"market", &ConfigLoader::ParseMarket, false},
+    {"display", &ConfigLoader::ParseDisplay, false},
+    {"matrix", &ConfigLoader::ParseMatrix, false},
+    {"system", &ConfigLoader::ParseSystem, false},
+    {"demo", &ConfigLoader::ParseDemo, false},
+    {"capture", &ConfigLoader::ParseCapture, false},
+    {"replay", &ConfigLoader::ParseReplay, false},
+    {"streaming", &ConfigLoader::ParseStreaming, false},
+    {"localApi", &ConfigLoader::ParseLocalApi, false},
+    {"cache", &ConfigLoader::ParseCache, false},
+    {"logos", &ConfigLoader::ParseLogos, false},
+    {"alerts", &ConfigLoader::ParseAlerts, false},
+    {"peers", &ConfigLoader::ParsePeers, false},
+    {"history", &ConfigLoader::ParseHistory, false},
+    {"log", &ConfigLoader::ParseLog, false}};
+
+const size_t ConfigLoader::sectionCount = sizeof(ConfigLoader::sections) / sizeof(ConfigLoader::sections[0]);
+
+void ConfigLoader::Error(const char *format, ...)
+{
+  char message[96];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(message, sizeof(message), format, args);
+  va_end(args);
+
+  LOG_ERROR("CONFIG: line %d: %s%s%s", fieldLine > 0 ? fieldLine : sectionLine, sectionName, sectionName[0] ? ": " : "", message);
+  fieldLine = 0;
+  errors++;
+}
+
+// Count the objects holding key ahead of object, in the order their members were read.
+static bool CountMembers(JsonVariantConst node, JsonVariantConst object, const char *key, size_t *count)
+{
+  if (node.is<JsonObjectConst>())
+  {
+    for (JsonPairConst pair : node.as<JsonObjectConst>())
+    {
+      if (pair.key() == key)
+      {
+        if (node.as<JsonObjectConst>() == object.as<JsonObjectConst>())
+        {
+          return true;
+        }
+        (*count)++;
+      }
+      if (CountMembers(pair.value(), object, key, count))
+      {
+        return true;
+      }
+    }
+  }
+  else if (node.is<JsonArrayConst>())
+  {
+    for (JsonVariantConst item : node.as<JsonArrayConst>())
+    {
+      if (CountMembers(item, object, key, count))
+      {
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+// Point the next Error() at the line key was read on in object, the nth object of the
+// section holding key owns the nth occurrence of the name in the stream.
+void ConfigLoader::Locate(JsonVariantConst object, const char *key)
+{
+  size_t count = 0;
+  if (!CountMembers(sectionRoot, object, key, &count))
+  {
+    return;
+  }
+  for (const LineStream::KeyLine &seen : stream.Keys())
+  {
+    if (strncmp(seen.key, key, sizeof(seen.key) - 1) == 0 && count-- == 0)
+    {
+      fieldLine = seen.line;
+      return;
+    }
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Top level structure.
+///////////////////////////////////////////////////////////////////////////////
+
+bool ConfigLoader::Expect(char expected)
+{
+  if (stream.SkipWhitespace() != expected)
+  {
+    sectionLine = stream.Line();
+    Error("expected '%c'", expected);
+    fatal = true;
+    return false;
+  }
+  stream.read();
+  return true;
+}
+
+// Top level keys are plain identifiers, escapes are not expected.
+bool ConfigLoader::ReadKey(char *key, size_t size)
+{
+  if (!Expect('"'))
+  {
+    return false;
+  }
+
+  size_t length = 0;
+  int c;
+  while ((c = stream.read()) >= 0 && c != '"')
+  {
+    if (length + 1 < size)
+    {
+      key[length++] = c;
+    }
+  }
+  key[length] = 0;
+
+  return c == '"' && Expect(':');
+}
+
+bool ConfigLoader::SkipValue()
+{
+  StaticJsonDocument<16> discard;
+  StaticJsonDocument<16> nothing;
+  nothing.set(false);
+  DeserializationError error = deserializeJson(discard, stream, DeserializationOption::Filter(nothing));
+  if (error)
+  {
+    Error("%s", error.c_str());
+    fatal = true;
+    return false;
+  }
+  return true;
+}
+
+// One entry at a time, the list can be as long as the card allows.
+bool ConfigLoader::LoadSymbols()
+{
+  if (!Expect('['))
+  {
+    return false;
+  }
+
+  if (stream.SkipWhitespace() == ']')
+  {
+    stream.read();
+    return true;
+  }
+
+  StaticJsonDocument<JSON_STRING_SIZE(32) + 16> entry;
+  HashPrint hash;
+  while (1)
+  {
+    stream.SkipWhitespace();
+    sectionLine = stream.Line();
+
+    DeserializationError error = deserializeJson(entry, stream);
+    if (error)
+    {
+      Error("%s", error.c_str());
+      fatal = true;
+      return false;
+    }
+
+    const char *symbol = entry.as<const char *>();
+    if (symbol == NULL || strlen(symbol) == 0 || strlen(symbol) > maxSymbolLength)
+    {
+      Error("symbol must be a string of 1 to %u characters", maxSymbolLength);
+    }
+    else
+    {
+      SymbolData symbolData;
+      symbolData.symbol = symbol;
+      parameters->symbolData.push_back(symbolData);
+      hash.print(symbol);
+      hash.print(',');
+    }
+
+    int c = stream.SkipWhitespace();
+    stream.read();
+    if (c == ']')
+    {
+      if (digest != NULL)
+      {
+        digest->sections.push_back({"symbols", hash.hash});
+      }
+      return true;
+    }
+    if (c != ',')
+    {
+      sectionLine = stream.Line();
+      Error("expected ',' or ']'");
+      fatal = true;
+      return false;
+    }
+  }
+}
+
+// One rule object at a time like the symbols, hundreds of rules do not need a large document.
+// {"symbol": "NEM", "above": 45.5, "below": 38}, any of the alertKindText members.
+bool ConfigLoader::LoadAlertRules()
+{
+  if (!Expect('['))
+  {
+    return false;
+  }
+
+  if (stream.SkipWhitespace() == ']')
+  {
+    stream.read();
+    return true;
+  }
+
+  static const double minimum[alertKindCount] = {0.0001, 0.0001, 0.01, 0, 0};
+  static const double maximum[alertKindCount] = {1000000, 1000000, 1000, 100, 100};
+  StaticJsonDocument<JSON_OBJECT_SIZE(alertKindCount + 1) + 128> entry; // Keys and the symbol are copied.
+  HashPrint hash;
+  while (1)
+  {
+    stream.SkipWhitespace();
+    sectionLine = stream.Line();
+
+    stream.TrackKeys(true);
+    DeserializationError error = deserializeJson(entry, stream);
+    stream.TrackKeys(false);
+    if (error)
+    {
+      Error("%s", error.c_str());
+      fatal = true;
+      return false;
+    }
+    serializeJson(entry, hash);
+    sectionRoot = entry.as<JsonVariantConst>();
+
+    const char *symbol = entry["symbol"].as<const char *>();
+    if (symbol == NULL || strlen(symbol) == 0 || strlen(symbol) > maxSymbolLength)
+    {
+      Error("symbol must be a string of 1 to %u characters", maxSymbolLength);
+    }
+    else
+    {
+      size_t rules = 0;
+      for (size_t kind = 0; kind < alertKindCount; kind++)
+      {
+        double value = Float(entry.as<JsonVariantConst>(), alertKindText[kind], -1, minimum[kind], maximum[kind]);
+        if (value >= 0)
+        {
+          AlertRule rule;
+          rule.symbol = symbol;
+          rule.kind = AlertKind(kind);
+          rule.value = value;
+          parameters->alertRules.push_back(rule);
+          rules++;
+        }
+      }
+      if (rules == 0)
+      {
+        Error("%s has no rule", symbol);
+      }
+    }
+
+    int c = stream.SkipWhitespace();
+    stream.read();
+    if (c == ']')
+    {
+      if (digest != NULL)
+      {
+        digest->sections.push_back({"alertRules", hash.hash});
+      }
+      return true;
+    }
+    if (c != ',')
+    {
+      sectionLine = stream.Line();
+      Error("expected ',' or ']'");
+      fatal = true;
+      return false;
+    }
+  }
+}
+
+bool ConfigLoader::Load()
+{
+  bool seen[sectionCount] = {};
+  bool symbolsSeen = false;
+  DynamicJsonDocument doc(sectionCapacity);
+
+  if (!Expect('{'))
+  {
+    return false;
+  }
+
+  while (!fatal)
+  {
+    if (stream.SkipWhitespace() == '}')
+    {
+      break;
+    }
+
+    char key[24];
+    sectionName = "";
+    sectionLine = stream.Line();
+    if (!ReadKey(key, sizeof(key)))
+    {
+      break;
+    }
+
+    const Section *section = NULL;
+    for (size_t i = 0; i < sectionCount; i++)
+    {
+      if (strcmp(key, sections[i].name) == 0)
+      {
+        section = &sections[i];
+        seen[i] = true;
+      }
+    }
+
+    if (strcmp(key, "symbols") == 0)
+    {
+      sectionName = "symbols";
+      symbolsSeen = true;
+      LoadSymbols();
+    }
+    else if (strcmp(key, "alertRules") == 0)
+    {
+      sectionName = "alertRules";
+      LoadAlertRules();
+    }
+    else if (section != NULL)
+    {
+      sectionName = section->name;
+      stream.SkipWhitespace();
+      sectionLine = stream.Line();
+      doc.clear();
+      stream.TrackKeys(true);
+      DeserializationError error = deserializeJson(doc, stream);
+      stream.TrackKeys(false);
+      if (error == DeserializationError::NoMemory)
+      {
+        Error("section larger than %u bytes", sectionCapacity);
+        fatal = true;
+      }
+      else if (error)
+      {
+        Error("%s", error.c_str());
+        fatal = true;
+      }
+      else
+      {
+        sectionRoot = doc.as<JsonVariantConst>();
+        (this->*section->parse)(sectionRoot);
+        if (digest != NULL)
+        {
+          HashPrint hash;
+          serializeJson(doc, hash);
+          digest->sections.push_back({section->name, hash.hash});
+        }
+      }
+    }
+    else
+    {
+      sectionName = "";
+      LOG_WARN("CONFIG: line %d: unknown section \"%s\" ignored", sectionLine, key);
+      SkipValue();
+    }
+
+    if (fatal)
+    {
+      break;
+    }
+
+    int c = stream.SkipWhitespace();
+    if (c == ',')
+    {
+      stream.read();
+    }
+    else if (c != '}')
+    {
+      sectionName = "";
+      sectionLine = stream.Line();
+      Error("expected ',' or '}'");
+      fatal = true;
+    }
+  }
+
+  if (fatal)
+  {
+    return false;
+  }
+
+  // Absent sections take their defaults.
+  sectionLine = stream.Line();
+  StaticJsonDocument<16> empty;
+  empty.to<JsonObject>();
+  sectionRoot = empty.as<JsonVariantConst>();
+  for (size_t i = 0; i < sectionCount; i++)
+  {
+    if (!seen[i])
+    {
+      sectionName = sections[i].name;
+      if (sections[i].required)
+      {
+        Error("required section missing");
+        fatal = true;
+      }
+      (this->*sections[i].parse)(empty.as<JsonVariantConst>());
+    }
+  }
+
+  sectionName = "symbols";
+  if (!symbolsSeen || (parameters->symbolData.size() == 0 && parameters->api.mode != ApiMode::Demo))
+  {
+    Error("at least one symbol is required");
+    fatal = true;
+  }
+
+  // Pad the watchlist with synthetic symbols for load testing.
+  if (parameters->api.mode == ApiMode::Demo)
+  {
+    char symbol[8];
+    for (int i = parameters->symbolData.size(); i < parameters->demo.symbolCount; i++)
+    {
+      SymbolData sData;
+      sprintf(symbol, "DM%03u", i);
+      sData.symbol = symbol;
+      parameters->symbolData.push_back(sData);
+    }
+  }
+
+  LOG_INFO("CONFIG: %u symbols loaded, %d error(s).", parameters->symbolData.size(), errors);
+  return !fatal;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Field validation.
+///////////////////////////////////////////////////////////////////////////////
+
+int ConfigLoader::Int(JsonVariantConst object, const char *key, int defaultValue, int minValue, int maxValue)
+{
+  JsonVariantConst value = object[key];
+  if (value.isNull())
+  {
+    return defaultValue;
+  }
+  if (!value.is<int>() || value.as<int>() < minValue || value.as<int>() > maxValue)
+  {
+    Locate(object, key);
+    Error("%s must be an integer from %d to %d", key, minValue, maxValue);
+    return defaultValue;
+  }
+  return value.as<int>();
+}
+
+// Read as double, a price threshold keeps every digit it was written with.
+double ConfigLoader::Float(JsonVariantConst object, const char *key, double defaultValue, double minValue, double maxValue)
+{
+  JsonVariantConst value = object[key];
+  if (value.isNull())
+  {
+    return defaultValue;
+  }
+  if (!value.is<double>() || value.as<double>() < minValue || value.as<double>() > maxValue)
+  {
+    Locate(object, key);
+    Error("%s must be a number from %g to %g", key, minValue, maxValue);
+    return defaultValue;
+  }
+  return value.as<double>();
+}
+
+bool ConfigLoader::Bool(JsonVariantConst object, const char *key, bool defaultValue)
+{
+  JsonVariantConst value = object[key];
+  if (value.isNull())
+  {
+    return defaultValue;
+  }
+  if (!value.is<bool>())
+  {
+    Locate(object, key);
+    Error("%s must be true or false", key);
+    return defaultValue;
+  }
+  return value.as<bool>();
+}
+
+String ConfigLoader::Text(JsonVariantConst object, const char *key, const char *defaultValue, size_t maxLength)
+{
+  JsonVariantConst value = object[key];
+  if (value.isNull())
+  {
+    return defaultValue;
+  }
+  if (!value.is<const char *>() || strlen(value.as<const char *>()) > maxLength)
+  {
+    Locate(object, key);
+    Error("%s must be a string of at most %u characters", key, maxLength);
+    return defaultValue;
+  }
+  return value.as<const char *>();
+}
+
+TimeRange ConfigLoader::Range(JsonVariantConst object, const char *key, const char *defaultValue)
+{
+  TimeRange range;
+  String text = Text(object, key, defaultValue, 11);
+  if (!range.SetTimeRangeFromString(text) || range.startHour > 23 || range.endHour > 23 || range.startMinute > 59 || range.endMinute > 59)
+  {
+    Locate(object, key);
+    Error("%s must be formatted as HH:MM-HH:MM", key);
+    range.SetTimeRangeFromString(defaultValue);
+  }
+  return range;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Sections.
+///////////////////////////////////////////////////////////////////////////////
+
+void ConfigLoader::ParseWifiCredentials(JsonVariantConst value)
+{
+  for (JsonVariantConst credentials : value.as<JsonArrayConst>())
+  {
+    WifiCredentials wC;
+    wC.ssid = Text(credentials, "ssid", "", 32);
+    wC.password = Text(credentials, "password", "", 64);
+    if (wC.ssid.length() == 0)
+    {
+      Error("ssid is required");
+      continue;
+    }
+    parameters->wifiCredentials.push_back(wC);
+  }
+
+  if (parameters->wifiCredentials.size() == 0)
+  {
+    Error("at least one network is required");
+    fatal = true;
+  }
+}
+
+void ConfigLoader::ParseApi(JsonVariantConst value)
+{
+  String apiMode = Text(value, "mode", "");
+
+  parameters->api.mode =
+      apiMode.equalsIgnoreCase("DEMO")      ? ApiMode::Demo
+      : apiMode.equalsIgnoreCase("SANDBOX") ? ApiMode::Sandbox
+      : apiMode.equalsIgnoreCase("LIVE")    ? ApiMode::Live
+      : apiMode.equalsIgnoreCase("REPLAY")  ? ApiMode::Replay
+                                            : ApiMode::Unknown;
+  if (parameters->api.mode == ApiMode::Unknown)
+  {
+    Error("mode must be one of DEMO, SANDBOX, LIVE or REPLAY");
+  }
+
+  parameters->api.gzip = Bool(value, "gzip", true);
+
+  JsonVariantConst timeouts = value["timeouts"];
+  parameters->api.timeouts.dns = Int(timeouts, "dns", 3000, 100, 60000);
+  parameters->api.timeouts.connect = Int(timeouts, "connect", 5000, 100, 60000);
+  parameters->api.timeouts.tls = Int(timeouts, "tls", 8000, 1000, 60000);
+  parameters->api.timeouts.headers = Int(timeouts, "headers", 8000, 100, 60000);
+  parameters->api.timeouts.body = Int(timeouts, "body", 10000, 100, 120000);
+
+  // Providers by priority, a single provider directly under "api" is still accepted.
+  JsonArrayConst providers = value["providers"];
+  if (providers.isNull() && value["provider"].is<const char *>())
+  {
+    ProviderParameters pP;
+    pP.name = Text(value, "provider", "");
+    pP.priority = 1;
+    pP.key = Text(value, "key", "");
+    pP.maxRequestsPerDay = Int(value, "maxRequestsPerDay", 0, 0, 10000000);
+    pP.sandboxKey = Text(value, "sandboxKey", "");
+    pP.sandboxMaxRequestsPerDay = Int(value, "sandboxMaxRequestsPerDay", 0, 0, 10000000);
+    pP.batchSize = Int(value, "batchSize", 1, 1, 100);
+    parameters->api.providers.push_back(pP);
+  }
+  for (JsonVariantConst provider : providers)
+  {
+    ProviderParameters pP;
+    pP.name = Text(provider, "name", "");
+    pP.priority = Int(provider, "priority", parameters->api.providers.size() + 1, 0, 100);
+    pP.key = Text(provider, "key", "");
+    pP.maxRequestsPerDay = Int(provider, "maxRequestsPerDay", 0, 0, 10000000);
+    pP.sandboxKey = Text(provider, "sandboxKey", "");
+    pP.sandboxMaxRequestsPerDay = Int(provider, "sandboxMaxRequestsPerDay", 0, 0, 10000000);
+    pP.batchSize = Int(provider, "batchSize", 1, 1, 100);
+    if (pP.name.length() == 0)
+    {
+      Error("provider name is required");
+      continue;
+    }
+    parameters->api.providers.push_back(pP);
+  }
+
+  // A provider without a budget is never selected, the device would wait for it forever.
+  for (auto &pP : parameters->api.providers)
+  {
+    int budget = parameters->api.mode == ApiMode::Sandbox ? pP.sandboxMaxRequestsPerDay : pP.maxRequestsPerDay;
+    if (budget == 0 && (parameters->api.mode == ApiMode::Live || parameters->api.mode == ApiMode::Sandbox))
+    {
+      Error("%s needs %s above 0", pP.name.c_str(), parameters->api.mode == ApiMode::Sandbox ? "sandboxMaxRequestsPerDay" : "maxRequestsPerDay");
+    }
+  }
+  std::stable_sort(parameters->api.providers.begin(), parameters->api.providers.end(),
+                   [](const ProviderParameters &a, const ProviderParameters &b) { return a.priority < b.priority; });
+}
+
+void ConfigLoader::ParseMarket(JsonVariantConst value)
+{
+  parameters->market.fetchPreMarketData = Bool(value, "fetchPreMarketData", false);
+  parameters->market.fetchMarketData = Bool(value, "fetchMarketData", true);
+  parameters->market.fetchAfterMarketData = Bool(value, "fetchAfterMarketData", false);
+}
+
+void ConfigLoader::ParseDisplay(JsonVariantConst value)
+{
+  parameters->display.nextSymbolDelay = Int(value, "nextSymbolDelay", 1, 1, 3600);
+  parameters->display.tapeSpeed = Int(value, "tapeSpeed", 60, 10, 400);
+  parameters->display.priceFont = Text(value, "priceFont", "", 64);
+  parameters->display.thousandsSeparator = Text(value, "thousandsSeparator", "", 1)[0];
+  parameters->display.brightnessMax = Int(value, "brightnessMax", 255, 0, 255);
+  parameters->display.brightnessMin = Int(value, "brightnessMin", 32, 0, 255);
+  time->displayMaxBrightnessTimeRange = Range(value, "maxBrightnessHours", "08:00-20:00");
+}
+
+void ConfigLoader::ParseMatrix(JsonVariantConst value)
+{
+  parameters->matrix.holidayPattern = Text(value, "holidayPattern", "RAINBOW", 32);
+  parameters->matrix.weekendPattern = Text(value, "weekendPattern", "RAINBOW", 32);
+  parameters->matrix.preMarketPattern = Text(value, "preMarketPattern", "RANDOMREDGREEN", 32);
+  parameters->matrix.marketPattern = Text(value, "marketPattern", "TOP16", 32);
+  parameters->matrix.afterMarketPattern = Text(value, "afterMarketPattern", "RANDOMREDGREEN", 32);
+  parameters->matrix.closedPattern = Text(value, "closedPattern", "RAINBOW", 32);
+  parameters->matrix.brightnessMax = Int(value, "brightnessMax", 196, 0, 255);
+  parameters->matrix.brightnessMin = Int(value, "brightnessMin", 32, 0, 255);
+  time->matrixMaxBrightnessTimeRange = Range(value, "maxBrightnessHours", "08:00-20:00");
+}
+
+void ConfigLoader::ParseSystem(JsonVariantConst value)
+{
+  time->timeZone = Text(value, "timeZone", "EST", 32);
+}
+
+void ConfigLoader::ParseDemo(JsonVariantConst value)
+{
+  parameters->demo.seed = Int(value, "seed", 1, 0, INT32_MAX);
+  parameters->demo.volatility = Float(value, "volatility", 0.1, 0, 100);
+  parameters->demo.ticksPerSecond = Int(value, "ticksPerSecond", 1, 1, 100);
+  parameters->demo.symbolCount = Int(value, "symbolCount", 0, 0, 1000);
+}
+
+void ConfigLoader::ParseCapture(JsonVariantConst value)
+{
+  parameters->capture.enabled = Bool(value, "enabled", false);
+  parameters->capture.file = Text(value, "file", "/capture.qbr", 31);
+}
+
+void ConfigLoader::ParseReplay(JsonVariantConst value)
+{
+  parameters->replay.file = Text(value, "file", "/capture.qbr", 31);
+  parameters->replay.provider = Text(value, "provider", "IEXCLOUD", 16);
+  parameters->replay.speed = Float(value, "speed", 1.0, 0, 1000);
+  parameters->replay.loop = Bool(value, "loop", true);
+}
+
+void ConfigLoader::ParseStreaming(JsonVariantConst value)
+{
+  parameters->streaming.enabled = Bool(value, "enabled", false);
+  parameters->streaming.url = Text(value, "url", "", 256);
+  parameters->streaming.maxEventSize = Int(value, "maxEventSize", 8192, 512, 65536);
+  parameters->streaming.ingestPerSecond = Int(value, "ingestPerSecond", 10, 1, 100);
+}
+
+void ConfigLoader::ParseLocalApi(JsonVariantConst value)
+{
+  parameters->localApi.enabled = Bool(value, "enabled", false);
+  parameters->localApi.port = Int(value, "port", 80, 1, 65535);
+  parameters->localApi.maxClients = Int(value, "maxClients", 16, 1, 64);
+  parameters->localApi.metrics = Bool(value, "metrics", true);
+  parameters->localApi.configUpload = Bool(value, "configUpload", false);
+}
+
+void ConfigLoader::ParseCache(JsonVariantConst value)
+{
+  parameters->cache.enabled = Bool(value, "enabled", false);
+  parameters->cache.directory = Text(value, "directory", "/cache", 23);
+  parameters->cache.entries = Int(value, "entries", 32, 1, 256);
+}
+
+void ConfigLoader::ParseLogos(JsonVariantConst value)
+{
+  parameters->logos.enabled = Bool(value, "enabled", false);
+  parameters->logos.directory = Text(value, "directory", "/logos", 23);
+  parameters->logos.ramSlots = Int(value, "ramSlots", 4, 1, 16);
+}
+
+void ConfigLoader::ParseAlerts(JsonVariantConst value)
+{
+  parameters->alerts.enabled = Bool(value, "enabled", false);
+  parameters->alerts.hysteresisPercent = Float(value, "hysteresisPercent", 0.5, 0, 50);
+  parameters->alerts.flashSeconds = Int(value, "flashSeconds", 10, 0, 600);
+  parameters->alerts.logFile = Text(value, "logFile", "/alerts.log", 31);
+}
+
+void ConfigLoader::ParsePeers(JsonVariantConst value)
+{
+  parameters->peers.enabled = Bool(value, "enabled", false);
+  parameters->peers.group = Text(value, "group", "239.255.51.51", 15);
+  parameters->peers.port = Int(value, "port", 5151, 1, 65535);
+  parameters->peers.staleSeconds = Int(value, "staleSeconds", 600, 10, 86400);
+}
+
+void ConfigLoader::ParseHistory(JsonVariantConst value)
+{
+  parameters->history.points = Int(value, "points", 390, 0, 1440);
+  parameters->history.maxSymbols = Int(value, "maxSymbols", 32, 0, 1000);
+}
+
+void ConfigLoader::ParseLog(JsonVariantConst value)
+{
+  parameters->log.level = Text(value, "level", "INFO", 8);
+  parameters->log.sdMirror = Bool(value, "sdMirror", false);
+  parameters->log.sdMirrorMaxFileSize = Int(value, "sdMirrorMaxFileSize", 65536, 4096, 16777216);
+  parameters->log.sdMirrorFiles = Int(value, "sdMirrorFiles", 3, 2, 10);
+}
+
+bool LoadParameters(Stream &source, Parameters *parameters, Time *time, ConfigDigest *digest)
+{
+  ConfigLoader loader(source, parameters, time, digest);
+  return loader.Load();
+}
+
+uint32_t ConfigDigest::Get(const String &name) const
+{
+  for (auto &section : sections)
+  {
+    if (section.first == name)
+    {
+      return section.second;
+    }
+  }
+  return 0;
+}
+
+std::vector<String> ConfigDigest::Changed(const ConfigDigest &other) const
+{
+  std::vector<String> changed;
+  for (auto &section : sections)
+  {
+    if (other.Get(section.first) != section.second)
+    {
+      changed.push_back(section.first);
+    }
+  }
+  for (auto &section : other.sections)
+  {
+    if (Get(section.first) == 0)
+    {
+      changed.push_back(section.first); // Removed, back to defaults.
+    }
+  }
+  return changed;
+}
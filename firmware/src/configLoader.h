@@ -0,0 +1,35 @@
+/*
+    configLoader.h
+
+    Streaming parameters.json loader. The file is read straight from the
+    SD card one top level section at a time, each section parsed into a
+    small bounded document, and the symbol and alert rule lists one entry
+    at a time, so memory use does not grow with the watchlist.
+
+    Every field is type and range checked. Problems are logged with the
+    line they were found on, invalid values fall back to their default.
+*/
+
+#ifndef CONFIGLOADER_H
+#define CONFIGLOADER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "main.h"
+
+// Hash of each top level section as parsed, compared to tell which
+// sections a reload changed. Whitespace and key order inside a section
+// do not matter.
+struct ConfigDigest
+{
+    std::vector<std::pair<String, uint32_t>> sections;
+
+    uint32_t Get(const String &name) const;
+    std::vector<String> Changed(const ConfigDigest &other) const;
+};
+
+// Fills parameters and the configured parts of time. Returns false on a
+// syntax error or when a required section is missing or unusable.
+bool LoadParameters(Stream &source, Parameters *parameters, Time *time, ConfigDigest *digest = NULL);
+
+#endif
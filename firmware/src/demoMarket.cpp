@@ -0,0 +1,87 @@
+#include "demoMarket.h"
+#include "fixedPoint.h"
+
+void DemoMarket::Begin(uint32_t seed, float volatilityPercent, size_t symbolCount)
+{
+  state = seed == 0 ? 1 : seed;
+  volatility = volatilityPercent / 100;
+
+  walks.clear();
+  walks.reserve(symbolCount);
+
+  for (size_t i = 0; i < symbolCount; i++)
+  {
+    walks.push_back(NewWalk());
+  }
+}
+
+void DemoMarket::Remap(const std::vector<int> &sourceIndex)
+{
+  std::vector<Walk> remapped;
+  remapped.reserve(sourceIndex.size());
+  for (int source : sourceIndex)
+  {
+    remapped.push_back(source >= 0 && size_t(source) < walks.size() ? walks[source] : NewWalk());
+  }
+  walks.swap(remapped);
+}
+
+void DemoMarket::Step(size_t index, time_t now, Quote *quote)
+{
+  Walk &walk = walks[index];
+
+  walk.price *= 1 + volatility * NextGaussian();
+  walk.price = max(walk.price, 0.0001);
+  walk.week52High = max(walk.week52High, walk.price);
+  walk.week52Low = min(walk.week52Low, walk.price);
+
+  const uint8_t decimals = walk.decimals;
+  quote->fields = QuoteFieldAll & ~QuoteFieldCompanyName;
+  quote->decimals = decimals;
+  quote->currentPrice = FixedFromDouble(walk.price, decimals);
+  quote->openPrice = FixedFromDouble(walk.previousClose, decimals);
+  quote->change = quote->currentPrice - quote->openPrice;
+  quote->changePercent = quote->openPrice == 0 ? 0 : (int64_t)quote->change * 10000 / quote->openPrice;
+  quote->week52High = FixedFromDouble(walk.week52High, decimals);
+  quote->week52Low = FixedFromDouble(walk.week52Low, decimals);
+  quote->peRatio = walk.peRatio;
+  quote->latestUpdate = now;
+}
+
+DemoMarket::Walk DemoMarket::NewWalk()
+{
+  Walk walk;
+  // Log-uniform starting prices from $0.10 to $1000 cover sub-penny and large caps.
+  walk.price = pow(10, -1 + NextUniform() * 4);
+  walk.previousClose = walk.price;
+  walk.week52High = walk.price * (1.2 + NextUniform());
+  walk.week52Low = walk.price * (0.2 + NextUniform() * 0.6);
+  walk.peRatio = NextUniform() < 0.3 ? 0 : 500 + NextRandom() % 4000;
+  walk.decimals = FixedDecimalsForPrice(walk.price);
+  return walk;
+}
+
+// xorshift32, fast and reproducible across builds.
+uint32_t DemoMarket::NextRandom()
+{
+  state ^= state << 13;
+  state ^= state >> 17;
+  state ^= state << 5;
+  return state;
+}
+
+float DemoMarket::NextUniform()
+{
+  return (NextRandom() >> 8) * (1.0f / 16777216.0f);
+}
+
+// Irwin-Hall approximation, plenty for a demo and free of log/sqrt.
+float DemoMarket::NextGaussian()
+{
+  float sum = 0;
+  for (int i = 0; i < 12; i++)
+  {
+    sum += NextUniform();
+  }
+  return sum - 6;
+}
@@ -0,0 +1,53 @@
+/*
+    demoMarket.h
+
+    Synthetic market for Demo mode. Each symbol follows a seeded
+    multiplicative random walk, so a given seed always produces the same session.
+*/
+
+#ifndef DEMOMARKET_H
+#define DEMOMARKET_H
+
+#include <Arduino.h>
+#include <vector>
+#include "main.h"
+
+class DemoMarket
+{
+public:
+    void Begin(uint32_t seed, float volatilityPercent, size_t symbolCount);
+
+    // Advance the walk of one symbol by a tick and describe it as a quote.
+    void Step(size_t index, time_t now, Quote *quote);
+
+    // Follows a change of the symbol table: walk i takes the old walk
+    // sourceIndex[i], or starts a new one when that is -1.
+    void Remap(const std::vector<int> &sourceIndex);
+
+    size_t Size()
+    {
+        return walks.size();
+    }
+
+private:
+    struct Walk
+    {
+        double price;
+        double previousClose;
+        double week52High;
+        double week52Low;
+        int32_t peRatio;
+        uint8_t decimals;
+    };
+
+    Walk NewWalk();
+    uint32_t NextRandom();
+    float NextUniform();
+    float NextGaussian();
+
+    std::vector<Walk> walks;
+    uint32_t state = 1;
+    float volatility = 0;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#include "finnhubProvider.h"
+#include "fixedPoint.h"
+#include "logger.h"
+
+#define ARDUINOJSON_USE_LONG_LONG 1
+#include <ArduinoJson.h>
+
+String FinnhubProvider::BuildUrl(const String *symbols, size_t count)
+{
+  return "https://finnhub.io/api/v1/quote?symbol=" + symbols[0] + "&token=" + key;
+}
+
+// Response: {"c":current,"d":change,"dp":percent,"h":high,"l":low,"o":open,"pc":previous close,"t":epoch}
+bool FinnhubProvider::ParseQuotes(Stream &body, const String *symbols, size_t count, Quote *quotes, bool *found)
+{
+  StaticJsonDocument<JSON_OBJECT_SIZE(8) + 32> doc;
+  DeserializationError jsonError = deserializeJson(doc, body);
+
+  if (jsonError)
+  {
+    LOG_WARN("JSON: DeserializeJson() failed: %s", jsonError.c_str());
+    return false;
+  }
+
+  // Unknown symbols are answered with an all zero quote.
+  double price = doc["c"].as<double>();
+  found[0] = !(price == 0 && doc["t"].as<long long>() == 0);
+  if (!found[0])
+  {
+    return true;
+  }
+
+  Quote *quote = &quotes[0];
+  uint8_t decimals = FixedDecimalsForPrice(price);
+
+  // No company name, P/E or 52 week range, those keep their last known values.
+  quote->fields = QuoteFieldLatestPrice | QuoteFieldPreviousClose | QuoteFieldChange |
+                  QuoteFieldChangePercent | QuoteFieldLatestUpdate;
+  quote->decimals = decimals;
+  quote->currentPrice = FixedFromDouble(price, decimals);
+  quote->openPrice = FixedFromDouble(doc["pc"].as<double>(), decimals);
+  quote->change = FixedFromDouble(doc["d"].as<double>(), decimals);
+  quote->changePercent = FixedFromDouble(doc["dp"].as<double>(), 2);
+  quote->latestUpdate = doc["t"].as<long long>();
+
+  return true;
+}
+
+// https://finnhub.io/docs/api/company-profile2
+String FinnhubProvider::BuildLogoUrl(const String &symbol)
+{
+  return "https://finnhub.io/api/v1/stock/profile2?symbol=" + symbol + "&token=" + key;
+}
+
+// Response: the company profile, {"logo":"https://...",...}. Unknown symbols get an empty object.
+String FinnhubProvider::ParseLogoUrl(const String &body)
+{
+  StaticJsonDocument<JSON_OBJECT_SIZE(1)> filter;
+  filter["logo"] = true;
+
+  DynamicJsonDocument doc(JSON_OBJECT_SIZE(1) + 256);
+  DeserializationError jsonError = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+
+  if (jsonError)
+  {
+    LOG_WARN("JSON: DeserializeJson() failed: %s", jsonError.c_str());
+    return "";
+  }
+  return doc["logo"] | "";
+}
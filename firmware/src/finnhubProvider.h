@@ -0,0 +1,24 @@
+/*
+    finnhubProvider.h
+
+    Finnhub quote endpoint, one symbol per request.
+    API documentation: https://finnhub.io/docs/api/quote
+*/
+
+#ifndef FINNHUBPROVIDER_H
+#define FINNHUBPROVIDER_H
+
+#include "quoteProvider.h"
+
+class FinnhubProvider : public QuoteProvider
+{
+public:
+    using QuoteProvider::QuoteProvider;
+
+    String BuildUrl(const String *symbols, size_t count) override;
+    bool ParseQuotes(Stream &body, const String *symbols, size_t count, Quote *quotes, bool *found) override;
+    String BuildLogoUrl(const String &symbol) override;
+    String ParseLogoUrl(const String &body) override;
+};
+
+#endif
@@ -0,0 +1,122 @@
+#include "fixedPoint.h"
+#include <math.h>
+#include <string.h>
+
+static const int32_t pow10Table[fixedMaxDecimals + 1] = {1, 10, 100, 1000, 10000, 100000, 1000000};
+
+int32_t FixedPow10(uint8_t exponent)
+{
+  return pow10Table[exponent > fixedMaxDecimals ? fixedMaxDecimals : exponent];
+}
+
+int32_t FixedFromDouble(double value, uint8_t decimals)
+{
+  double scaled = round(value * FixedPow10(decimals));
+
+  if (scaled > INT32_MAX)
+  {
+    return INT32_MAX;
+  }
+  if (scaled < -INT32_MAX)
+  {
+    return -INT32_MAX;
+  }
+  return (int32_t)scaled;
+}
+
+int32_t FixedRescale(int32_t value, uint8_t fromDecimals, uint8_t toDecimals)
+{
+  if (toDecimals >= fromDecimals)
+  {
+    int64_t scaled = (int64_t)value * FixedPow10(toDecimals - fromDecimals);
+    return scaled > INT32_MAX ? INT32_MAX : scaled < -INT32_MAX ? -INT32_MAX : (int32_t)scaled;
+  }
+
+  int32_t divisor = FixedPow10(fromDecimals - toDecimals);
+  int32_t half = value < 0 ? -divisor / 2 : divisor / 2;
+  return (value + half) / divisor;
+}
+
+uint8_t FixedDecimalsForPrice(double price)
+{
+  return fabs(price) < 1.0 ? fixedSubDollarDecimals : fixedDefaultDecimals;
+}
+
+size_t FormatFixed(char *buf, size_t bufSize, int32_t value, uint8_t decimals, uint8_t precision, char thousandsSeparator)
+{
+  // Sign, 10 digits, 3 separators, point and padded decimals fit comfortably.
+  char tmp[32];
+  char *p = tmp + sizeof(tmp);
+
+  if (bufSize == 0)
+  {
+    return 0;
+  }
+
+  if (decimals > fixedMaxDecimals)
+  {
+    decimals = fixedMaxDecimals;
+  }
+  if (precision > fixedMaxDecimals)
+  {
+    precision = fixedMaxDecimals;
+  }
+
+  bool negative = value < 0;
+  uint32_t magnitude = negative ? 0u - (uint32_t)value : (uint32_t)value;
+
+  if (precision < decimals)
+  {
+    uint32_t divisor = pow10Table[decimals - precision];
+    magnitude = magnitude / divisor + (magnitude % divisor >= (divisor + 1) / 2 ? 1 : 0);
+    decimals = precision;
+  }
+
+  for (uint8_t i = decimals; i < precision; i++)
+  {
+    *--p = '0';
+  }
+
+  uint32_t integerPart = magnitude / pow10Table[decimals];
+  uint32_t fractionPart = magnitude % pow10Table[decimals];
+
+  for (uint8_t i = 0; i < decimals; i++)
+  {
+    *--p = '0' + fractionPart % 10;
+    fractionPart /= 10;
+  }
+
+  if (precision > 0)
+  {
+    *--p = '.';
+  }
+
+  int groupCount = 0;
+  do
+  {
+    if (thousandsSeparator && groupCount == 3)
+    {
+      *--p = thousandsSeparator;
+      groupCount = 0;
+    }
+    *--p = '0' + integerPart % 10;
+    integerPart /= 10;
+    groupCount++;
+  } while (integerPart);
+
+  if (negative)
+  {
+    *--p = '-';
+  }
+
+  size_t length = tmp + sizeof(tmp) - p;
+  if (length + 1 > bufSize)
+  {
+    buf[0] = 0;
+    return 0;
+  }
+
+  memcpy(buf, p, length);
+  buf[length] = 0;
+  return length;
+}
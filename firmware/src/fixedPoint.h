@@ -0,0 +1,33 @@
+/*
+    fixedPoint.h
+
+    Prices stored as scaled 32 bit integers and an allocation free
+    integer to decimal string formatter.
+
+    A value of 12345 with 2 decimals represents 123.45.
+*/
+
+#ifndef FIXEDPOINT_H
+#define FIXEDPOINT_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+const uint8_t fixedMaxDecimals = 6;
+
+// Price scale used for instruments trading below one dollar (OTC, penny stocks).
+const uint8_t fixedSubDollarDecimals = 4;
+const uint8_t fixedDefaultDecimals = 2;
+
+int32_t FixedPow10(uint8_t exponent);
+int32_t FixedFromDouble(double value, uint8_t decimals);
+int32_t FixedRescale(int32_t value, uint8_t fromDecimals, uint8_t toDecimals);
+uint8_t FixedDecimalsForPrice(double price);
+
+// Write value into buf with precision digits after the decimal point.
+// Extra decimals are rounded half away from zero, missing decimals are zero padded.
+// A non-zero thousandsSeparator is inserted between groups of integer digits.
+// Returns the string length, or 0 (and an empty string) if buf is too small.
+size_t FormatFixed(char *buf, size_t bufSize, int32_t value, uint8_t decimals, uint8_t precision, char thousandsSeparator = 0);
+
+#endif
@@ -0,0 +1,144 @@
+#include "fontAtlas.h"
+#include "logger.h"
+
+bool FontAtlas::Begin(fs::FS &fs, const char *fontName, int maxHeight, char thousandsSeparator, const char *charset)
+{
+  glyphs.clear();
+  coverage.clear();
+  height = 0;
+
+  String path = String(fontName) + ".vlw";
+  if (!fs.exists(path))
+  {
+    LOG_WARN("FONT: %s not found, using the built in font.", path.c_str());
+    return false;
+  }
+
+  // The glyphs are drawn white on black into a sprite, the green channel read back is the coverage.
+  TFT_eSprite cell(&tft);
+  cell.setColorDepth(16);
+  cell.loadFont(fontName, fs);
+  int cellHeight = cell.fontHeight();
+  if (cellHeight > maxHeight)
+  {
+    cell.unloadFont();
+    LOG_WARN("FONT: %s is %i px high, more than the %i px the price has, using the built in font.", path.c_str(), cellHeight, maxHeight);
+    return false;
+  }
+
+  String characters = charset;
+  if (thousandsSeparator != 0 && characters.indexOf(thousandsSeparator) < 0)
+  {
+    characters += thousandsSeparator;
+  }
+
+  for (const char *c = characters.c_str(); *c; c++)
+  {
+    char text[2] = {*c, 0};
+    int width = cell.textWidth(text);
+    if (width <= 0 || cell.createSprite(width, cellHeight) == NULL)
+    {
+      continue;
+    }
+    cell.fillSprite(TFT_BLACK);
+    cell.setTextColor(TFT_WHITE, TFT_BLACK);
+    cell.setTextDatum(TL_DATUM);
+    cell.drawString(text, 0, 0);
+
+    glyphs.push_back({*c, (uint16_t)width, (uint32_t)coverage.size()});
+    for (int y = 0; y < cellHeight; y++)
+    {
+      for (int x = 0; x < width; x++)
+      {
+        coverage.push_back(((cell.readPixel(x, y) >> 5) & 0x3F) * 255 / 63);
+      }
+    }
+    cell.deleteSprite();
+  }
+  cell.unloadFont();
+
+  if (glyphs.empty())
+  {
+    LOG_WARN("FONT: No glyphs rasterized from %s.", path.c_str());
+    return false;
+  }
+
+  height = cellHeight;
+  coverage.shrink_to_fit();
+  LOG_INFO("FONT: %s, %u glyphs, %u px high, %u bytes.", path.c_str(), glyphs.size(), height, coverage.size());
+  return true;
+}
+
+const FontAtlas::Glyph *FontAtlas::Find(char code)
+{
+  for (auto &glyph : glyphs)
+  {
+    if (glyph.code == code)
+    {
+      return &glyph;
+    }
+  }
+  return NULL;
+}
+
+int FontAtlas::TextWidth(const char *text)
+{
+  int width = 0;
+  for (const char *c = text; *c; c++)
+  {
+    const Glyph *glyph = Find(*c);
+    width += glyph ? glyph->width : 0;
+  }
+  return width;
+}
+
+void FontAtlas::Draw(const char *text, int x, int y, uint8_t datum, uint16_t color, uint16_t background, int padding)
+{
+  if (!Enabled())
+  {
+    return;
+  }
+
+  if (!paletteValid || color != paletteColor || background != paletteBackground)
+  {
+    for (int alpha = 0; alpha < 256; alpha++)
+    {
+      palette[alpha] = tft.alphaBlend(alpha, color, background);
+    }
+    paletteColor = color;
+    paletteBackground = background;
+    paletteValid = true;
+  }
+
+  int width = TextWidth(text);
+  int left = datum == TC_DATUM ? x - width / 2 : datum == TR_DATUM ? x - width : x;
+
+  // Background either side of the text, over what the padding covers.
+  if (padding > width)
+  {
+    int padLeft = datum == TC_DATUM ? x - padding / 2 : datum == TR_DATUM ? x - padding : x;
+    tft.fillRect(padLeft, y, left - padLeft, height, background);
+    tft.fillRect(left + width, y, padLeft + padding - left - width, height, background);
+  }
+
+  tft.setSwapBytes(true);
+  for (const char *c = text; *c; c++)
+  {
+    const Glyph *glyph = Find(*c);
+    if (glyph == NULL)
+    {
+      continue;
+    }
+
+    size_t pixels = glyph->width * height;
+    block.resize(pixels);
+    const uint8_t *source = &coverage[glyph->offset];
+    for (size_t i = 0; i < pixels; i++)
+    {
+      block[i] = palette[source[i]];
+    }
+    tft.pushImage(left, y, glyph->width, height, block.data());
+    left += glyph->width;
+  }
+  tft.setSwapBytes(false);
+}
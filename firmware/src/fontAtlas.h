@@ -0,0 +1,64 @@
+/*
+    fontAtlas.h
+
+    Anti-aliased font for the price field. A smooth (.vlw) font is read
+    from the SD card once at boot and the few glyphs a price needs are
+    rasterized into a RAM atlas as 8 bit coverage, one cell per glyph at
+    the full line height. Drawing maps the coverage through a 256 entry
+    colour table built for the foreground and background, and pushes one
+    block per glyph, the font file is never touched again.
+
+    Font files are made with the TFT_eSPI Processing sketch (Create_font).
+*/
+
+#ifndef FONTATLAS_H
+#define FONTATLAS_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <FS.h>
+#include <vector>
+
+class FontAtlas
+{
+public:
+    FontAtlas(TFT_eSPI &tft) : tft(tft) {}
+
+    // fontName is the path without the .vlw extension, e.g. "/fonts/PriceBold48". A font taller
+    // than maxHeight is refused, the built in font is used instead. thousandsSeparator, when not
+    // 0, is rasterized with the charset.
+    bool Begin(fs::FS &fs, const char *fontName, int maxHeight, char thousandsSeparator, const char *charset = "0123456789.,-+%");
+    bool Enabled() { return height > 0; }
+
+    int Height() { return height; }
+    int TextWidth(const char *text);
+
+    // Draws text at x, y for the TL_DATUM, TC_DATUM or TR_DATUM datum. The text is centred in
+    // padding wide background when wider than the text, as setTextPadding does.
+    // Characters missing from the atlas are skipped.
+    void Draw(const char *text, int x, int y, uint8_t datum, uint16_t color, uint16_t background, int padding = 0);
+
+private:
+    struct Glyph
+    {
+        char code;
+        uint16_t width; // Advance, the cell includes the side bearings.
+        uint32_t offset;
+    };
+
+    const Glyph *Find(char code);
+
+    TFT_eSPI &tft;
+    std::vector<Glyph> glyphs;
+    std::vector<uint8_t> coverage; // Cells back to back, row major.
+    std::vector<uint16_t> block;   // One coloured cell.
+    uint16_t palette[256];
+    uint16_t paletteColor = 0;
+    uint16_t paletteBackground = 0;
+    bool paletteValid = false;
+    int height = 0;
+};
+
+extern FontAtlas priceFont;
+
+#endif
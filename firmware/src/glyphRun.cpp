@@ -0,0 +1,69 @@
+#include "glyphRun.h"
+
+bool GlyphRunRenderer::Append(GlyphRun *run, const char *text, uint16_t color)
+{
+  scratch.setTextFont(0);
+  scratch.setTextSize(size);
+  int width = scratch.textWidth(text);
+  if (width <= 0)
+  {
+    return true;
+  }
+
+  // A one bit sprite is only needed for as long as the text is read back.
+  scratch.setColorDepth(1);
+  if (scratch.createSprite(width, Rows()) == NULL)
+  {
+    return false;
+  }
+  scratch.fillSprite(TFT_BLACK);
+  scratch.setTextColor(TFT_WHITE);
+  scratch.setTextDatum(TL_DATUM);
+  scratch.drawString(text, 0, 0);
+
+  run->spans.push_back({(uint16_t)run->columns.size(), color});
+  run->columns.reserve(run->columns.size() + width);
+  for (int x = 0; x < width; x++)
+  {
+    uint16_t bits = 0;
+    for (int y = 0; y < Rows(); y++)
+    {
+      if (scratch.readPixel(x, y) != TFT_BLACK)
+      {
+        bits |= 1 << y;
+      }
+    }
+    run->columns.push_back(bits);
+  }
+
+  scratch.deleteSprite();
+  return true;
+}
+
+void GlyphRunRenderer::AppendGap(GlyphRun *run, size_t width)
+{
+  run->columns.resize(run->columns.size() + width, 0);
+}
+
+void BlitGlyphRun(const GlyphRun &run, size_t first, size_t count, uint16_t *frame, size_t stride, int x, int top)
+{
+  size_t span = 0;
+  size_t end = min(first + count, run.columns.size());
+  for (size_t column = first; column < end; column++, x++)
+  {
+    while (span + 1 < run.spans.size() && run.spans[span + 1].first <= column)
+    {
+      span++;
+    }
+
+    uint16_t bits = run.columns[column];
+    uint16_t color = run.spans.empty() ? TFT_WHITE : run.spans[span].color;
+    for (int row = top; bits != 0; row++, bits >>= 1)
+    {
+      if (bits & 1)
+      {
+        frame[row * stride + x] = color;
+      }
+    }
+  }
+}
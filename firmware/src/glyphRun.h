@@ -0,0 +1,60 @@
+/*
+    glyphRun.h
+
+    Text rasterized once into a column bitmap, then copied into frame
+    buffers as often as needed without going through the font again.
+    A run holds one bit per pixel, a 16 pixel tall run costs two bytes
+    per column, and carries its colours as spans of columns.
+*/
+
+#ifndef GLYPHRUN_H
+#define GLYPHRUN_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <vector>
+
+struct GlyphSpan
+{
+    uint16_t first; // First column in this colour.
+    uint16_t color;
+};
+
+struct GlyphRun
+{
+    std::vector<uint16_t> columns; // Bit r set when row r is lit.
+    std::vector<GlyphSpan> spans;  // Ascending by first column.
+
+    size_t Width() const { return columns.size(); }
+    void Clear()
+    {
+        columns.clear();
+        spans.clear();
+    }
+};
+
+class GlyphRunRenderer
+{
+public:
+    static const uint8_t maxRows = 16;
+
+    GlyphRunRenderer(TFT_eSPI &tft) : scratch(&tft) {}
+
+    // Built in font at textSize, 8 * textSize rows tall.
+    void SetTextSize(uint8_t textSize) { size = min(textSize, (uint8_t)(maxRows / 8)); }
+    uint8_t Rows() { return 8 * size; }
+
+    // Appends text in color, returns false when the scratch bitmap could not be allocated.
+    bool Append(GlyphRun *run, const char *text, uint16_t color);
+    void AppendGap(GlyphRun *run, size_t width);
+
+private:
+    TFT_eSprite scratch;
+    uint8_t size = 1;
+};
+
+// Copies count columns of run starting at first into frame, a row major buffer of
+// stride pixels, at column x with the run's top row at row top. Unlit pixels are left as they are.
+void BlitGlyphRun(const GlyphRun &run, size_t first, size_t count, uint16_t *frame, size_t stride, int x, int top);
+
+#endif
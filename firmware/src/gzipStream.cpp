@@ -0,0 +1,163 @@
+#include "gzipStream.h"
+#include "logger.h"
+
+static const uint8_t gzipFlagHeaderCrc = 0x02;
+static const uint8_t gzipFlagExtra = 0x04;
+static const uint8_t gzipFlagName = 0x08;
+static const uint8_t gzipFlagComment = 0x10;
+
+GzipStream::GzipStream(Stream &source) : source(source)
+{
+}
+
+GzipStream::~GzipStream()
+{
+  free(inflator);
+  free(window);
+}
+
+int GzipStream::ReadSourceByte()
+{
+  if (inputOffset == inputLength)
+  {
+    inputLength = sourceEnded ? 0 : source.readBytes((char *)input, sizeof(input));
+    inputOffset = 0;
+    if (inputLength == 0)
+    {
+      sourceEnded = true;
+      return -1;
+    }
+  }
+  return input[inputOffset++];
+}
+
+bool GzipStream::Begin()
+{
+  inflator = (tinfl_decompressor *)malloc(sizeof(tinfl_decompressor));
+  window = (uint8_t *)malloc(TINFL_LZ_DICT_SIZE);
+  if (inflator == NULL || window == NULL)
+  {
+    LOG_WARN("GZIP: Out of memory for the inflater.");
+    failed = done = true;
+    return false;
+  }
+  tinfl_init(inflator);
+
+  // Magic, method deflate, flags, then mtime, extra flags and OS which are not needed.
+  uint8_t header[10];
+  for (auto &b : header)
+  {
+    int c = ReadSourceByte();
+    if (c < 0)
+    {
+      failed = done = true;
+      return false;
+    }
+    b = c;
+  }
+  if (header[0] != 0x1f || header[1] != 0x8b || header[2] != 8)
+  {
+    LOG_WARN("GZIP: Not a gzip stream.");
+    failed = done = true;
+    return false;
+  }
+
+  uint8_t flags = header[3];
+  if (flags & gzipFlagExtra)
+  {
+    int length = ReadSourceByte();
+    length |= ReadSourceByte() << 8;
+    while (length-- > 0 && ReadSourceByte() >= 0)
+    {
+    }
+  }
+  if (flags & gzipFlagName)
+  {
+    while (ReadSourceByte() > 0)
+    {
+    }
+  }
+  if (flags & gzipFlagComment)
+  {
+    while (ReadSourceByte() > 0)
+    {
+    }
+  }
+  if (flags & gzipFlagHeaderCrc)
+  {
+    ReadSourceByte();
+    ReadSourceByte();
+  }
+
+  return !sourceEnded;
+}
+
+// Inflate until some output is ready or the stream ends.
+bool GzipStream::Fill()
+{
+  while (readable == 0 && !done)
+  {
+    if (inputOffset == inputLength && !sourceEnded)
+    {
+      inputLength = source.readBytes((char *)input, sizeof(input));
+      inputOffset = 0;
+      sourceEnded = inputLength == 0;
+    }
+
+    // Output runs up to the end of the circular window, the inflater wraps it.
+    size_t inputSize = inputLength - inputOffset;
+    size_t outputSize = TINFL_LZ_DICT_SIZE - windowPosition;
+    tinfl_status status = tinfl_decompress(inflator, input + inputOffset, &inputSize, window, window + windowPosition, &outputSize,
+                                           sourceEnded ? 0 : TINFL_FLAG_HAS_MORE_INPUT);
+    inputOffset += inputSize;
+
+    readPosition = windowPosition;
+    readable = outputSize;
+    windowPosition = (windowPosition + outputSize) & (TINFL_LZ_DICT_SIZE - 1);
+
+    if (status == TINFL_STATUS_DONE)
+    {
+      done = true;
+    }
+    else if (status < TINFL_STATUS_DONE || (status == TINFL_STATUS_NEEDS_MORE_INPUT && sourceEnded))
+    {
+      LOG_WARN("GZIP: Inflate failed, status %d.", status);
+      failed = done = true;
+    }
+  }
+  return readable > 0;
+}
+
+int GzipStream::available()
+{
+  return Fill() ? readable : 0;
+}
+
+int GzipStream::read()
+{
+  if (!Fill())
+  {
+    return -1;
+  }
+  readable--;
+  return window[readPosition++];
+}
+
+int GzipStream::peek()
+{
+  return Fill() ? window[readPosition] : -1;
+}
+
+size_t GzipStream::readBytes(char *buffer, size_t length)
+{
+  size_t total = 0;
+  while (total < length && Fill())
+  {
+    size_t count = min(length - total, readable);
+    memcpy(buffer + total, window + readPosition, count);
+    readPosition += count;
+    readable -= count;
+    total += count;
+  }
+  return total;
+}
@@ -0,0 +1,64 @@
+/*
+    gzipStream.h
+
+    Read side Stream that inflates a gzip body as it is read, so a
+    compressed response can feed the JSON parser straight off the socket.
+
+    Uses the inflater in the ESP32 ROM (miniz tinfl). The server picks the
+    deflate window, so a full 32 KB history window is allocated per stream,
+    plus about 11 KB of decompressor state, both freed with the stream.
+*/
+
+#ifndef GZIPSTREAM_H
+#define GZIPSTREAM_H
+
+#include <Arduino.h>
+#if __has_include(<esp32/rom/miniz.h>)
+#include <esp32/rom/miniz.h>
+#else
+#include <rom/miniz.h>
+#endif
+
+class GzipStream : public Stream
+{
+public:
+    GzipStream(Stream &source);
+    ~GzipStream();
+
+    // Allocate and consume the gzip header. False when out of memory or not gzip.
+    bool Begin();
+
+    // The compressed data was corrupt or ended early.
+    bool Failed()
+    {
+        return failed;
+    }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(char *buffer, size_t length) override;
+    size_t write(uint8_t) override
+    {
+        return 0;
+    }
+
+private:
+    bool Fill();
+    int ReadSourceByte();
+
+    Stream &source;
+    tinfl_decompressor *inflator = NULL;
+    uint8_t *window = NULL;
+    size_t windowPosition = 0; // Next byte the inflater writes.
+    size_t readPosition = 0;   // Next inflated byte handed out.
+    size_t readable = 0;
+    uint8_t input[512];
+    size_t inputOffset = 0;
+    size_t inputLength = 0;
+    bool sourceEnded = false;
+    bool done = false;
+    bool failed = false;
+};
+
+#endif
@@ -0,0 +1,25 @@
+/*
+    hashPrint.h
+
+    FNV-1a over everything printed to it, a content hash without keeping
+    the content.
+*/
+
+#ifndef HASHPRINT_H
+#define HASHPRINT_H
+
+#include <Arduino.h>
+
+class HashPrint : public Print
+{
+public:
+    size_t write(uint8_t c) override
+    {
+        hash = (hash ^ c) * 16777619u;
+        return 1;
+    }
+
+    uint32_t hash = 2166136261u;
+};
+
+#endif
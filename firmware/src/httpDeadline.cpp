@@ -0,0 +1,146 @@
+#include "httpDeadline.h"
+#include <lwip/dns.h>
+#include <lwip/sockets.h>
+
+String HostFromUrl(const String &url)
+{
+  int hostStart = url.indexOf("://");
+  hostStart = hostStart < 0 ? 0 : hostStart + 3;
+  int hostEnd = hostStart;
+  while (hostEnd < (int)url.length() && url[hostEnd] != '/' && url[hostEnd] != ':' && url[hostEnd] != '?')
+  {
+    hostEnd++;
+  }
+  return url.substring(hostStart, hostEnd);
+}
+
+// Only one lookup is waited on at a time. A late answer to an abandoned
+// lookup carries an old sequence number and is ignored.
+static SemaphoreHandle_t dnsDone = NULL;
+static std::atomic<uint32_t> dnsSequence(0);
+static std::atomic<bool> dnsFound(false);
+
+static void OnDnsFound(const char *name, const ip_addr_t *address, void *arg)
+{
+  if ((uint32_t)(uintptr_t)arg == dnsSequence.load())
+  {
+    dnsFound = address != NULL;
+    xSemaphoreGive(dnsDone);
+  }
+}
+
+bool ResolveHost(const char *host, uint32_t timeoutMs, bool *timedOut)
+{
+  *timedOut = false;
+  IPAddress literal;
+  if (literal.fromString(host))
+  {
+    return true;
+  }
+
+  if (dnsDone == NULL)
+  {
+    dnsDone = xSemaphoreCreateBinary();
+  }
+  xSemaphoreTake(dnsDone, 0); // Drop a stale give.
+
+  uint32_t sequence = ++dnsSequence;
+  ip_addr_t address;
+  err_t error = dns_gethostbyname(host, &address, OnDnsFound, (void *)(uintptr_t)sequence);
+  if (error == ERR_OK)
+  {
+    return true; // Cached.
+  }
+  if (error != ERR_INPROGRESS)
+  {
+    return false;
+  }
+
+  bool answered = xSemaphoreTake(dnsDone, pdMS_TO_TICKS(timeoutMs)) == pdTRUE;
+  dnsSequence++; // Abandon the lookup when it timed out.
+  *timedOut = !answered;
+  return answered && dnsFound;
+}
+
+void SocketWatch::Begin()
+{
+  mutex = xSemaphoreCreateMutex();
+}
+
+void SocketWatch::Attach(WiFiClient &watched, bool watchedSecure)
+{
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  client = &watched;
+  secure = watchedSecure;
+  xSemaphoreGive(mutex);
+}
+
+void SocketWatch::Detach()
+{
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  client = NULL;
+  xSemaphoreGive(mutex);
+}
+
+bool SocketWatch::Abort()
+{
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  int socket = client == NULL ? -1 : secure ? static_cast<WatchedClientSecure *>(client)->Socket() : client->fd();
+  bool aborted = socket >= 0 && shutdown(socket, SHUT_RDWR) == 0;
+  xSemaphoreGive(mutex);
+  return aborted;
+}
+
+void SocketWatch::Reset()
+{
+  client = NULL;
+  waiting = false;
+}
+
+bool DeadlineStream::Wait()
+{
+  while (source.available() == 0)
+  {
+    if (Cancelled() || !source.connected())
+    {
+      return false;
+    }
+    if ((long)(millis() - deadline) >= 0)
+    {
+      expired = true;
+      return false;
+    }
+    vTaskDelay(pdMS_TO_TICKS(2));
+  }
+  return !Cancelled();
+}
+
+int DeadlineStream::available()
+{
+  return Cancelled() || expired ? 0 : source.available();
+}
+
+// A TLS read can still block inside the session after available(), it is watched like the wait.
+int DeadlineStream::read()
+{
+  WatchedCall call(watch);
+  return Wait() ? source.read() : -1;
+}
+
+int DeadlineStream::peek()
+{
+  WatchedCall call(watch);
+  return Wait() ? source.peek() : -1;
+}
+
+size_t DeadlineStream::readBytes(char *buffer, size_t length)
+{
+  WatchedCall call(watch);
+  size_t total = 0;
+  while (total < length && Wait())
+  {
+    size_t chunk = min((size_t)source.available(), length - total);
+    total += source.readBytes(buffer + total, chunk);
+  }
+  return total;
+}
@@ -0,0 +1,131 @@
+/*
+    httpDeadline.h
+
+    Pieces for HTTP requests with a bounded worst case. The host is
+    resolved ahead of the client with a bounded wait, connect and TLS use
+    the client's own timeouts, and the body is read through a
+    DeadlineStream which ends the body early when its deadline passes or
+    the request is cancelled.
+
+    A SocketWatch lets a supervising task shut down the socket of a request
+    that is stuck inside the network stack. The blocked call returns with an
+    error and the owning task unwinds normally, releasing its own locks.
+*/
+
+#ifndef HTTPDEADLINE_H
+#define HTTPDEADLINE_H
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <WiFiClientSecure.h>
+#include <atomic>
+
+// Host part of scheme://host[:port]/path.
+String HostFromUrl(const String &url);
+
+// Resolves host within timeoutMs. The answer lands in the lwIP cache, where
+// the client's own lookup finds it without waiting again.
+bool ResolveHost(const char *host, uint32_t timeoutMs, bool *timedOut);
+
+// WiFiClientSecure with the socket under its TLS session exposed, for SocketWatch.
+class WatchedClientSecure : public WiFiClientSecure
+{
+public:
+    int Socket() const
+    {
+        return sslclient->socket;
+    }
+};
+
+class SocketWatch
+{
+public:
+    void Begin();
+
+    // The client of the request in progress, detached before it goes out of scope.
+    void Attach(WiFiClient &client, bool secure);
+    void Detach();
+
+    // Around each call that blocks on the network. In between, the owning task holds no lock
+    // other than the SymbolTableLock, so it can be deleted without leaving another lock taken.
+    void Enter()
+    {
+        waiting.store(true);
+    }
+    void Leave()
+    {
+        waiting.store(false);
+    }
+    bool Waiting() const
+    {
+        return waiting.load();
+    }
+
+    // Shut the attached socket down, a blocked connect, handshake or read returns with an error.
+    // False when no client is attached or its socket is not open yet.
+    bool Abort();
+
+    // After the owning task was deleted, while it was Waiting().
+    void Reset();
+
+private:
+    SemaphoreHandle_t mutex = NULL;
+    WiFiClient *client = NULL;
+    bool secure = false;
+    std::atomic<bool> waiting{false};
+};
+
+// Enter for the lifetime of the object, nothing without a watch.
+class WatchedCall
+{
+public:
+    WatchedCall(SocketWatch *watch) : watch(watch)
+    {
+        if (watch != NULL)
+        {
+            watch->Enter();
+        }
+    }
+    ~WatchedCall()
+    {
+        if (watch != NULL)
+        {
+            watch->Leave();
+        }
+    }
+
+private:
+    SocketWatch *watch;
+};
+
+class DeadlineStream : public Stream
+{
+public:
+    DeadlineStream(WiFiClient &source, uint32_t timeoutMs, const std::atomic<bool> &cancel, SocketWatch *watch = NULL)
+        : source(source), deadline(millis() + timeoutMs), cancel(cancel), watch(watch) {}
+
+    bool Expired() { return expired; }
+    bool Cancelled() { return cancel.load(std::memory_order_relaxed); }
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(char *buffer, size_t length) override;
+
+    size_t write(uint8_t) override
+    {
+        return 0;
+    }
+
+private:
+    // Wait for data, false at the end of the body, the deadline or a cancel.
+    bool Wait();
+
+    WiFiClient &source;
+    unsigned long deadline;
+    const std::atomic<bool> &cancel;
+    SocketWatch *watch;
+    bool expired = false;
+};
+
+#endif
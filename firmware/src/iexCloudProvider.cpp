@@ -0,0 +1,231 @@
+#include "iexCloudProvider.h"
+#include "fixedPoint.h"
+#include "logger.h"
+
+#define ARDUINOJSON_USE_LONG_LONG 1
+#include <ArduinoJson.h>
+
+struct IexField
+{
+  uint16_t field;
+  const char *name;
+};
+
+static const IexField iexFields[] = {
+    {QuoteFieldCompanyName, "companyName"},
+    {QuoteFieldLatestPrice, "latestPrice"},
+    {QuoteFieldPreviousClose, "previousClose"},
+    {QuoteFieldChange, "change"},
+    {QuoteFieldChangePercent, "changePercent"},
+    {QuoteFieldPeRatio, "peRatio"},
+    {QuoteFieldWeek52High, "week52High"},
+    {QuoteFieldWeek52Low, "week52Low"},
+    {QuoteFieldLatestUpdate, "latestUpdate"}};
+
+// Filtered quote object: one member per field, their keys and the company name.
+constexpr size_t IexQuoteCapacity(uint16_t fields)
+{
+  return JSON_OBJECT_SIZE(QuoteFieldCount(fields)) + QuoteFieldCount(fields) * 16 + ((fields & QuoteFieldCompanyName) ? 96 : 0);
+}
+
+static const uint16_t iexMaxFields = quoteFieldsSymbolScreen | quoteFieldsMatrix | quoteFieldsChart | quoteFieldsShared;
+
+static void SetQuoteFilter(JsonObject filter, uint16_t fields)
+{
+  for (auto &iexField : iexFields)
+  {
+    if (fields & iexField.field)
+    {
+      filter[iexField.name] = true;
+    }
+  }
+}
+
+static void QuoteFromJson(JsonObject object, uint16_t fields, Quote *quote)
+{
+  // Scale is chosen per instrument so sub-penny quotes keep their precision.
+  uint8_t decimals = FixedDecimalsForPrice(object["latestPrice"].as<double>());
+
+  quote->fields = fields;
+  quote->decimals = decimals;
+  quote->companyName = object["companyName"].as<String>();
+  quote->currentPrice = FixedFromDouble(object["latestPrice"].as<double>(), decimals);
+  quote->openPrice = FixedFromDouble(object["previousClose"].as<double>(), decimals);
+  quote->change = FixedFromDouble(object["change"].as<double>(), decimals);
+  quote->changePercent = FixedFromDouble(object["changePercent"].as<double>() * 100, 2);
+  quote->week52High = FixedFromDouble(object["week52High"].as<double>(), decimals);
+  quote->week52Low = FixedFromDouble(object["week52Low"].as<double>(), decimals);
+  quote->latestUpdate = object["latestUpdate"].as<long long>() / 1000; // convert milliseconds to seconds
+
+  // Null when not applicable, shown as N/A.
+  quote->peRatio = object["peRatio"].is<float>() ? FixedFromDouble(object["peRatio"].as<double>(), 2) : 0;
+}
+
+String IexCloudProvider::BuildUrl(const String *symbols, size_t count)
+{
+  String url = sandbox ? "https://sandbox.iexapis.com/stable/" : "https://cloud.iexapis.com/stable/";
+
+  if (count == 1)
+  {
+    url += "stock/" + symbols[0] + "/quote?token=" + key;
+  }
+  else
+  {
+    url += "stock/market/batch?types=quote&symbols=";
+    for (size_t i = 0; i < count; i++)
+    {
+      if (i > 0)
+      {
+        url += ",";
+      }
+      url += symbols[i];
+    }
+    url += "&token=" + key;
+  }
+
+  // Only the members the device uses, the full quote has about sixty.
+  if (fields != QuoteFieldAll)
+  {
+    url += "&filter=";
+    bool first = true;
+    for (auto &iexField : iexFields)
+    {
+      if (fields & iexField.field)
+      {
+        url += first ? "" : ",";
+        url += iexField.name;
+        first = false;
+      }
+    }
+  }
+
+  return url;
+}
+
+bool IexCloudProvider::ParseQuotes(Stream &body, const String *symbols, size_t count, Quote *quotes, bool *found)
+{
+  StaticJsonDocument<JSON_OBJECT_SIZE(1) + JSON_OBJECT_SIZE(QuoteFieldCount(iexMaxFields)) + 256> filter;
+
+  if (count == 1)
+  {
+    SetQuoteFilter(filter.to<JsonObject>(), fields);
+  }
+  else
+  {
+    SetQuoteFilter(filter["*"]["quote"].to<JsonObject>(), fields);
+  }
+
+  // Batch responses are keyed by symbol: {"AAPL":{"quote":{...}}, ...}
+  DynamicJsonDocument doc(count * (IexQuoteCapacity(fields) + JSON_OBJECT_SIZE(2) + 16) + JSON_OBJECT_SIZE(count));
+  DeserializationError jsonError = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+
+  if (jsonError)
+  {
+    LOG_WARN("JSON: DeserializeJson() failed: %s", jsonError.c_str());
+    return false;
+  }
+
+  for (size_t i = 0; i < count; i++)
+  {
+    JsonObject object = count == 1 ? doc.as<JsonObject>() : doc[symbols[i]]["quote"].as<JsonObject>();
+    found[i] = !object.isNull() && !object["latestPrice"].isNull();
+    if (found[i])
+    {
+      QuoteFromJson(object, fields, &quotes[i]);
+    }
+  }
+
+  return true;
+}
+
+// https://iexcloud.io/docs/api/#sse-streaming
+String IexCloudProvider::BuildStreamUrl(const String *symbols, size_t count)
+{
+  String url = sandbox ? "https://sandbox-sse.iexapis.com/stable/stocksUS?symbols="
+                       : "https://cloud-sse.iexapis.com/stable/stocksUS?symbols=";
+  for (size_t i = 0; i < count; i++)
+  {
+    if (i > 0)
+    {
+      url += ",";
+    }
+    url += symbols[i];
+  }
+  url += "&token=" + key;
+  return url;
+}
+
+// Each event carries an array of quote objects, each with its symbol.
+bool IexCloudProvider::ParseStreamEvent(const String &data, const StreamQuoteHandler &handler)
+{
+  StaticJsonDocument<JSON_ARRAY_SIZE(1) + JSON_OBJECT_SIZE(QuoteFieldCount(iexMaxFields) + 1) + 256> filter;
+  JsonObject elementFilter = filter[0].to<JsonObject>();
+  SetQuoteFilter(elementFilter, fields);
+  elementFilter["symbol"] = true;
+
+  // Filtered output is always smaller than the raw event.
+  DynamicJsonDocument doc(data.length() + 512);
+  DeserializationError jsonError = deserializeJson(doc, data, DeserializationOption::Filter(filter));
+
+  if (jsonError)
+  {
+    LOG_WARN("JSON: DeserializeJson() failed: %s", jsonError.c_str());
+    return false;
+  }
+
+  Quote quote;
+  for (JsonObject object : doc.as<JsonArray>())
+  {
+    const char *symbol = object["symbol"].as<const char *>();
+    if (symbol != NULL && !object["latestPrice"].isNull())
+    {
+      QuoteFromJson(object, fields, &quote);
+      handler(symbol, quote);
+    }
+  }
+
+  return true;
+}
+
+FetchResult IexCloudProvider::MapError(int httpCode, const String &body)
+{
+  // Check for endpoint error messages. https://iexcloud.io/docs/api/#error-codes
+  if (body.equalsIgnoreCase("Unknown symbol"))
+  {
+    return FetchResult::UnknownSymbol;
+  }
+  else if (body.equalsIgnoreCase("Forbidden"))
+  {
+    return FetchResult::Forbidden;
+  }
+  else if (body.equalsIgnoreCase("The API key provided is not valid."))
+  {
+    return FetchResult::InvalidKey;
+  }
+
+  return MapHttpCode(httpCode);
+}
+
+// https://iexcloud.io/docs/api/#logo
+String IexCloudProvider::BuildLogoUrl(const String &symbol)
+{
+  String url = sandbox ? "https://sandbox.iexapis.com/stable/" : "https://cloud.iexapis.com/stable/";
+  return url + "stock/" + symbol + "/logo?token=" + key;
+}
+
+// Response: {"url":"https://..."}, the url is empty when there is no logo.
+String IexCloudProvider::ParseLogoUrl(const String &body)
+{
+  StaticJsonDocument<JSON_OBJECT_SIZE(1)> filter;
+  filter["url"] = true;
+
+  DynamicJsonDocument doc(JSON_OBJECT_SIZE(1) + 256);
+  DeserializationError jsonError = deserializeJson(doc, body, DeserializationOption::Filter(filter));
+
+  if (jsonError)
+  {
+    LOG_WARN("JSON: DeserializeJson() failed: %s", jsonError.c_str());
+    return "";
+  }
+  return doc["url"] | "";
+}
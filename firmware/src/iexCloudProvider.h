@@ -0,0 +1,33 @@
+/*
+    iexCloudProvider.h
+
+    IEX Cloud quote endpoint, single symbol or batched.
+    API documentation: https://iexcloud.io/docs/api/#quote
+*/
+
+#ifndef IEXCLOUDPROVIDER_H
+#define IEXCLOUDPROVIDER_H
+
+#include "quoteProvider.h"
+
+class IexCloudProvider : public QuoteProvider
+{
+public:
+    using QuoteProvider::QuoteProvider;
+
+    String BuildUrl(const String *symbols, size_t count) override;
+    bool ParseQuotes(Stream &body, const String *symbols, size_t count, Quote *quotes, bool *found) override;
+    FetchResult MapError(int httpCode, const String &body) override;
+    String BuildStreamUrl(const String *symbols, size_t count) override;
+    bool ParseStreamEvent(const String &data, const StreamQuoteHandler &handler) override;
+    String BuildLogoUrl(const String &symbol) override;
+    String ParseLogoUrl(const String &body) override;
+
+    size_t MaxBatchSize() override
+    {
+        // The batch endpoint accepts up to 100 symbols.
+        return min(batchSize, 100);
+    }
+};
+
+#endif
@@ -0,0 +1,192 @@
+#include "intradayChart.h"
+#include "lttb.h"
+#include "fixedPoint.h"
+#include "layout.h"
+
+static const int titleHeight = frameLayout.titleHeight;
+static const int chartLeft = 1;
+static const int chartTop = frameLayout.centerTop;
+static const int chartWidth = screen.width - 2;
+static const int chartHeight = frameLayout.centerHeight - 1; // Leaves a row above the indicator row line.
+static const int bandHeight = 24;                            // 23 KB at 16 bits on the 480 wide panel.
+static const int margin = 6;        // Keeps the extremes off the frame.
+static const uint16_t gridColor = 0x2104;
+
+void IntradayChart::Open()
+{
+  active = true;
+  bandCreated = band.createSprite(chartWidth, bandHeight) != NULL;
+  tft.fillRect(1, 1, tft.width() - 2, titleHeight - 1, TFT_BLACK); // Also clears the symbol box divider.
+  tft.fillRect(chartLeft, chartTop, chartWidth, chartHeight, TFT_BLACK);
+}
+
+void IntradayChart::Close()
+{
+  active = false;
+  if (bandCreated)
+  {
+    band.deleteSprite();
+    bandCreated = false;
+  }
+  samples.clear();
+  samples.shrink_to_fit();
+  polyline.clear();
+  polyline.shrink_to_fit();
+}
+
+void IntradayChart::Draw(const String &symbol, const std::vector<HistoryPoint> &history, uint8_t decimals, int32_t reference)
+{
+  DrawTitle(symbol, history, decimals);
+
+  if (history.size() < 2)
+  {
+    polyline.clear();
+    tft.fillRect(chartLeft, chartTop, chartWidth, chartHeight, TFT_BLACK);
+    tft.setTextSize(2);
+    tft.setTextPadding(0);
+    tft.setTextDatum(MC_DATUM);
+    tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
+    tft.drawString("No history yet", chartLeft + chartWidth / 2, chartTop + chartHeight / 2);
+    return;
+  }
+
+  BuildPolyline(history, reference);
+  Render(history.back().price >= reference ? TFT_GREEN : TFT_RED);
+
+  // Range labels on top of the pushed bands.
+  char buf[16];
+  tft.setTextSize(1);
+  tft.setTextPadding(0);
+  tft.setTextColor(TFT_DARKGREY);
+  tft.setTextDatum(TL_DATUM);
+  FormatFixed(buf, sizeof(buf), high, decimals, decimals);
+  tft.drawString(buf, chartLeft + 2, chartTop + 2);
+  tft.setTextDatum(BL_DATUM);
+  FormatFixed(buf, sizeof(buf), low, decimals, decimals);
+  tft.drawString(buf, chartLeft + 2, chartTop + chartHeight - 2);
+}
+
+void IntradayChart::DrawTitle(const String &symbol, const std::vector<HistoryPoint> &history, uint8_t decimals)
+{
+  char buf[32];
+  tft.setTextFont(0);
+  tft.setTextSize(3);
+  tft.setTextDatum(ML_DATUM);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  tft.setTextPadding(tft.textWidth("12345"));
+  tft.drawString(symbol, 8, titleHeight / 2);
+
+  // Time span of the chart, and the latest price.
+  tft.setTextSize(2);
+  tft.setTextDatum(MR_DATUM);
+  tft.setTextPadding(tft.textWidth("00:00-00:00 12345.78"));
+  if (history.size() > 0)
+  {
+    time_t first = history.front().epoch;
+    time_t last = history.back().epoch;
+    struct tm firstTime, lastTime;
+    localtime_r(&first, &firstTime);
+    localtime_r(&last, &lastTime);
+    char price[16];
+    FormatFixed(price, sizeof(price), history.back().price, decimals, decimals);
+    snprintf(buf, sizeof(buf), "%02u:%02u-%02u:%02u %s", firstTime.tm_hour, firstTime.tm_min, lastTime.tm_hour, lastTime.tm_min, price);
+    tft.drawString(buf, tft.width() - 8, titleHeight / 2);
+  }
+  else
+  {
+    tft.drawString("", tft.width() - 8, titleHeight / 2);
+  }
+}
+
+// Downsamples to one point per column and maps it to chart coordinates.
+void IntradayChart::BuildPolyline(const std::vector<HistoryPoint> &history, int32_t reference)
+{
+  samples.clear();
+  LttbDownsample(history.data(), history.size(), chartWidth, &samples);
+
+  low = high = samples[0].price;
+  for (auto &sample : samples)
+  {
+    low = min(low, sample.price);
+    high = max(high, sample.price);
+  }
+
+  // The reference line is included when it is close, so a move through it is visible.
+  int32_t range = max(high - low, (int32_t)1);
+  int32_t scaleLow = low;
+  int32_t scaleHigh = high;
+  if (reference != 0 && reference > low - range / 2 && reference < high + range / 2)
+  {
+    scaleLow = min(scaleLow, reference);
+    scaleHigh = max(scaleHigh, reference);
+  }
+  int64_t scaleRange = max(scaleHigh - scaleLow, (int32_t)1);
+
+  uint32_t firstEpoch = samples.front().epoch;
+  uint32_t span = max(samples.back().epoch - firstEpoch, (uint32_t)1);
+  auto toY = [&](int32_t price) {
+    return int16_t(margin + (int64_t)(scaleHigh - price) * (chartHeight - 1 - 2 * margin) / scaleRange);
+  };
+
+  polyline.resize(samples.size());
+  for (size_t i = 0; i < samples.size(); i++)
+  {
+    polyline[i].x = int16_t((uint64_t)(samples[i].epoch - firstEpoch) * (chartWidth - 1) / span);
+    polyline[i].y = toY(samples[i].price);
+  }
+  referenceY = reference >= scaleLow && reference <= scaleHigh && reference != 0 ? toY(reference) : -1;
+}
+
+// Draws each band off screen then pushes it, only segments crossing the band are drawn.
+void IntradayChart::Render(uint16_t color)
+{
+  for (int top = 0; top < chartHeight; top += bandHeight)
+  {
+    int height = min(bandHeight, chartHeight - top);
+    TFT_eSPI &canvas = bandCreated ? (TFT_eSPI &)band : tft;
+    int offsetX = bandCreated ? 0 : chartLeft;
+    int offsetY = bandCreated ? -top : chartTop;
+
+    if (bandCreated)
+    {
+      band.fillSprite(TFT_BLACK);
+    }
+    else
+    {
+      tft.fillRect(chartLeft, chartTop + top, chartWidth, height, TFT_BLACK);
+    }
+
+    // Quarter grid, and the dashed reference line.
+    for (int grid = 1; grid < 4; grid++)
+    {
+      int y = grid * chartHeight / 4;
+      if (y >= top && y < top + height)
+      {
+        canvas.drawFastHLine(offsetX, y + offsetY, chartWidth, gridColor);
+      }
+    }
+    if (referenceY >= top && referenceY < top + height)
+    {
+      for (int x = 0; x < chartWidth; x += 6)
+      {
+        canvas.drawFastHLine(x + offsetX, referenceY + offsetY, 3, TFT_DARKGREY);
+      }
+    }
+
+    for (size_t i = 1; i < polyline.size(); i++)
+    {
+      const Vertex &a = polyline[i - 1];
+      const Vertex &b = polyline[i];
+      if (max(a.y, b.y) < top || min(a.y, b.y) >= top + height)
+      {
+        continue;
+      }
+      canvas.drawLine(a.x + offsetX, a.y + offsetY, b.x + offsetX, b.y + offsetY, color);
+    }
+
+    if (bandCreated)
+    {
+      band.pushSprite(chartLeft, chartTop + top);
+    }
+  }
+}
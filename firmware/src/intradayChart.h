@@ -0,0 +1,55 @@
+/*
+    intradayChart.h
+
+    Intraday price chart of one symbol, drawn from the locally collected
+    minute history between the symbol row and the indicator row. The
+    history is downsampled to one point per pixel column (see lttb.h) and
+    mapped to a screen polyline once per update. The polyline is rendered
+    into a band sprite, one horizontal band at a time, so the chart is
+    pushed without flicker for the RAM of a single band.
+*/
+
+#ifndef INTRADAYCHART_H
+#define INTRADAYCHART_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <vector>
+#include "quoteHistory.h"
+
+class IntradayChart
+{
+public:
+    IntradayChart(TFT_eSPI &tft) : tft(tft), band(&tft) {}
+
+    void Open();
+    void Close();
+    bool Active() { return active; }
+
+    // History oldest first, as copied from quoteHistory. Reference is the previous close,
+    // drawn as a dashed line and deciding the line colour.
+    void Draw(const String &symbol, const std::vector<HistoryPoint> &history, uint8_t decimals, int32_t reference);
+
+private:
+    struct Vertex
+    {
+        int16_t x;
+        int16_t y;
+    };
+
+    void DrawTitle(const String &symbol, const std::vector<HistoryPoint> &history, uint8_t decimals);
+    void BuildPolyline(const std::vector<HistoryPoint> &history, int32_t reference);
+    void Render(uint16_t color);
+
+    TFT_eSPI &tft;
+    TFT_eSprite band;
+    bool bandCreated = false;
+    bool active = false;
+    std::vector<HistoryPoint> samples; // Reused between updates.
+    std::vector<Vertex> polyline;
+    int16_t referenceY = -1;
+    int32_t low = 0;
+    int32_t high = 0;
+};
+
+#endif
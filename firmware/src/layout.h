@@ -0,0 +1,159 @@
+/*
+    layout.h
+
+    Screen regions, positions and text sizes for the configured panel,
+    computed at compile time from the 320x240 reference design. Positions
+    scale per axis, text sizes of the built in font with the smaller axis.
+    Another panel or rotation is a rebuild with no runtime layout cost,
+    and the static_asserts below reject a panel the design does not fit.
+
+    The panel profile is TFT_WIDTH x TFT_HEIGHT (platformio.ini), the panel
+    in its native orientation, turned by displayRotation as setRotation() does.
+*/
+
+#ifndef LAYOUT_H
+#define LAYOUT_H
+
+#include <stdint.h>
+
+const uint8_t displayRotation = 1; // Landscape.
+
+struct ScreenSize
+{
+    int width; // After rotation.
+    int height;
+
+    constexpr int X(int reference) const { return reference * width / 320; }
+    constexpr int Y(int reference) const { return reference * height / 240; }
+    constexpr int Smaller() const { return width * 240 < height * 320 ? width * 240 : height * 320; }
+    constexpr uint8_t Text(int reference) const
+    {
+        return reference * Smaller() / (320 * 240) > 0 ? reference * Smaller() / (320 * 240) : 1;
+    }
+};
+
+constexpr ScreenSize screen = {displayRotation % 2 ? TFT_HEIGHT : TFT_WIDTH, displayRotation % 2 ? TFT_WIDTH : TFT_HEIGHT};
+
+// Built in font cell, scaled by the text size.
+constexpr int GlyphWidth(int textSize) { return 6 * textSize; }
+constexpr int GlyphHeight(int textSize) { return 8 * textSize; }
+
+// Frame shared by every page: symbol row, center area, indicator row.
+struct FrameLayout
+{
+    int titleHeight;    // Symbol row, the line below it.
+    int footerTop;      // Line above the indicator row.
+    int symbolBoxWidth; // Divider in the symbol row.
+    int centerTop;
+    int centerHeight;
+    int bannerHeight;   // Fault banner at the top of the center area.
+    uint8_t bannerTextSize;
+};
+
+constexpr FrameLayout frameLayout = {screen.Y(35), screen.Y(205), screen.X(100),
+                                     screen.Y(35) + 1, screen.Y(205) - screen.Y(35) - 1, screen.Y(18), screen.Text(2)};
+
+// Single symbol quote page.
+struct QuoteLayout
+{
+    int symbolX; // Centre of the symbol box.
+    int symbolY;
+    uint8_t symbolTextSize;
+    int nameX;
+    int nameY;
+    uint8_t nameTextSize;
+    int nameChars; // Longer names are cut and end in dots.
+    int logoX;     // Square company logo at the right end of the name area.
+    int logoY;
+    int logoSize;
+    int priceY;
+    uint8_t priceTextSize;
+    int changeY;
+    uint8_t changeTextSize;
+    int changeX;  // Centre of the change.
+    int percentX; // Centre of the change percent.
+    int rangeY;   // 52 week range bar.
+    int rangeMargin;
+    int rangeMarkerWidth;
+    int rangeMarkerHeight;
+    uint8_t labelTextSize;
+    int labelY;
+    int valueY;
+    int peX;
+    int stateX; // Centre of the market state, two lines or one at stateY.
+    int stateY;
+    int stateClearWidth;
+    int updateX;
+    int messageY; // Invalid symbol.
+};
+
+constexpr QuoteLayout quoteLayout = {
+    screen.X(52), screen.Y(7), screen.Text(3),
+    screen.X(115), screen.Y(12), screen.Text(2),
+    (screen.width - 2 - (frameLayout.titleHeight - 3) - screen.X(115) - screen.X(3)) / GlyphWidth(screen.Text(2)),
+    screen.width - 2 - (frameLayout.titleHeight - 3), 2, frameLayout.titleHeight - 3,
+    screen.Y(55), screen.Text(6),
+    screen.Y(113), screen.Text(3), screen.X(90), screen.X(230),
+    screen.Y(143), screen.X(20), screen.X(5), screen.Y(10),
+    screen.Text(2), screen.Y(160), screen.Y(182), screen.X(50), screen.X(150), screen.Y(171), screen.X(120), screen.X(260),
+    screen.Y(65)};
+
+// Ticker tape page, a band across the middle of the center area.
+struct TapeLayout
+{
+    uint8_t textSize; // Glyph runs hold 16 rows, size 2 at most.
+    int bandHeight;
+    int bandTop;
+    int textTop; // In the band.
+};
+
+constexpr uint8_t tapeTextSize = screen.Text(2) < 2 ? screen.Text(2) : 2;
+constexpr int tapeBandHeight = GlyphHeight(tapeTextSize) + screen.Y(8);
+constexpr TapeLayout tapeLayout = {tapeTextSize, tapeBandHeight,
+                                   frameLayout.centerTop + (frameLayout.centerHeight - tapeBandHeight) / 2,
+                                   (tapeBandHeight - GlyphHeight(tapeTextSize)) / 2};
+
+// Symbol browser rows, symbol then as much of the name as fits.
+struct BrowserLayout
+{
+    uint8_t textSize;
+    int symbolX;
+    int nameX;
+    int nameChars;
+};
+
+constexpr BrowserLayout browserLayout = {screen.Text(2), screen.X(8), screen.X(96),
+                                         (screen.width - screen.X(96) - screen.X(8)) / GlyphWidth(screen.Text(2))};
+
+// Status indicators in the bottom row.
+struct IndicatorLayout
+{
+    int y;
+    uint8_t textSize;
+    int sdX; // Centres.
+    int wifiX;
+    int apiX;
+    int lockX;
+    int requestX;
+    int timeX;
+};
+
+constexpr IndicatorLayout indicatorLayout = {screen.Y(217), screen.Text(2), screen.X(25), screen.X(75), screen.X(130),
+                                             screen.X(165), screen.X(190), screen.X(275)};
+
+// The design has to fit the panel, checked for every build.
+static_assert(GlyphWidth(quoteLayout.symbolTextSize) * 5 <= frameLayout.symbolBoxWidth, "Symbol does not fit its box.");
+static_assert(quoteLayout.symbolY + GlyphHeight(quoteLayout.symbolTextSize) <= frameLayout.titleHeight, "Symbol row too low.");
+static_assert(GlyphWidth(quoteLayout.priceTextSize) * 8 <= screen.width, "Price does not fit the width.");
+static_assert(quoteLayout.priceY + GlyphHeight(quoteLayout.priceTextSize) <= quoteLayout.changeY, "Price overlaps the change.");
+static_assert(quoteLayout.changeY + GlyphHeight(quoteLayout.changeTextSize) <= quoteLayout.rangeY, "Change overlaps the range bar.");
+static_assert(quoteLayout.rangeY + quoteLayout.rangeMarkerHeight <= quoteLayout.labelY, "Range bar overlaps the labels.");
+static_assert(quoteLayout.valueY + GlyphHeight(quoteLayout.labelTextSize) <= frameLayout.footerTop, "Values overlap the indicator row.");
+static_assert(GlyphHeight(frameLayout.bannerTextSize) <= frameLayout.bannerHeight, "Banner text taller than the banner.");
+static_assert(tapeLayout.bandTop - 2 > frameLayout.centerTop && tapeLayout.bandHeight + 4 <= frameLayout.centerHeight, "Tape band does not fit the center area.");
+static_assert(browserLayout.nameChars >= 8, "No room for the names in the symbol browser.");
+static_assert(indicatorLayout.y + GlyphHeight(indicatorLayout.textSize) <= screen.height, "Indicators below the screen.");
+static_assert(quoteLayout.nameChars >= 8, "No room for the company name.");
+static_assert(quoteLayout.nameX + GlyphWidth(quoteLayout.nameTextSize) * quoteLayout.nameChars <= quoteLayout.logoX, "Name overlaps the logo.");
+
+#endif
@@ -0,0 +1,671 @@
+#include "localApi.h"
+#include <ESPAsyncWebServer.h>
+#include <atomic>
+#include <memory>
+#include <vector>
+#include "main.h"
+#include "fixedPoint.h"
+#include "quoteHistory.h"
+#include "logger.h"
+#include "metrics.h"
+#include "sdLock.h"
+#include <SD.h>
+
+struct QuoteRecord
+{
+  char symbol[12];
+  char companyName[40];
+  char error[24];
+  uint8_t decimals;
+  bool isValid;
+  int32_t openPrice;
+  int32_t currentPrice;
+  int32_t change;
+  int32_t changePercent;
+  int32_t peRatio;
+  int32_t week52High;
+  int32_t week52Low;
+  unsigned long long latestUpdate;
+  uint32_t version;
+};
+
+// Copy of the symbol table at one quote generation, shared by every response reading it.
+struct QuoteSnapshot
+{
+  uint32_t generation;
+  MarketState marketState;
+  std::vector<QuoteRecord> records;
+};
+
+static AsyncWebServer *server = NULL;
+static std::shared_ptr<const QuoteSnapshot> latestSnapshot;
+static std::atomic<int> activeResponses(0);
+static int maxActiveResponses;
+
+///////////////////////////////////////////////////////////////////////////////
+// Snapshot.
+///////////////////////////////////////////////////////////////////////////////
+
+// Only called from the AsyncTCP task, so latestSnapshot needs no lock of its own.
+static std::shared_ptr<const QuoteSnapshot> GetSnapshot()
+{
+  MarketState currentMarketState = marketState;
+  if (latestSnapshot && latestSnapshot->generation == quoteGeneration && latestSnapshot->marketState == currentMarketState)
+  {
+    return latestSnapshot;
+  }
+
+  std::shared_ptr<QuoteSnapshot> snapshot = std::make_shared<QuoteSnapshot>();
+  snapshot->marketState = currentMarketState;
+
+  SymbolLock lock;
+  snapshot->records.resize(parameters.symbolData.size()); // Grows when symbols are added on the device.
+  snapshot->generation = quoteGeneration;
+  for (size_t i = 0; i < parameters.symbolData.size(); i++)
+  {
+    const SymbolData &symbolData = parameters.symbolData[i];
+    QuoteRecord &record = snapshot->records[i];
+    strlcpy(record.symbol, symbolData.symbol.c_str(), sizeof(record.symbol));
+    strlcpy(record.companyName, symbolData.companyName.c_str(), sizeof(record.companyName));
+    strlcpy(record.error, symbolData.errorString.c_str(), sizeof(record.error));
+    record.decimals = symbolData.decimals;
+    record.isValid = symbolData.isValid;
+    record.openPrice = symbolData.openPrice;
+    record.currentPrice = symbolData.currentPrice;
+    record.change = symbolData.change;
+    record.changePercent = symbolData.changePercent;
+    record.peRatio = symbolData.peRatio;
+    record.week52High = symbolData.week52High;
+    record.week52Low = symbolData.week52Low;
+    record.latestUpdate = symbolData.latestUpdate;
+    record.version = symbolData.version;
+  }
+
+  latestSnapshot = snapshot;
+  return latestSnapshot;
+}
+
+static const QuoteRecord *FindRecord(const QuoteSnapshot &snapshot, const String &symbol)
+{
+  for (const QuoteRecord &record : snapshot.records)
+  {
+    if (symbol.equalsIgnoreCase(record.symbol))
+    {
+      return &record;
+    }
+  }
+  return NULL;
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Serialization.
+///////////////////////////////////////////////////////////////////////////////
+
+// Appends to a fixed buffer, output past the end is dropped and flagged.
+class JsonBuffer
+{
+public:
+  JsonBuffer(char *buf, size_t size) : buf(buf), size(size) { buf[0] = 0; }
+
+  void Raw(const char *text)
+  {
+    while (*text)
+    {
+      Put(*text++);
+    }
+  }
+
+  void Escaped(const char *text)
+  {
+    Put('"');
+    for (; *text; text++)
+    {
+      if (*text == '"' || *text == '\\')
+      {
+        Put('\\');
+        Put(*text);
+      }
+      else if ((uint8_t)*text >= 0x20)
+      {
+        Put(*text);
+      }
+    }
+    Put('"');
+  }
+
+  void Fixed(int32_t value, uint8_t decimals, uint8_t precision)
+  {
+    char number[24];
+    FormatFixed(number, sizeof(number), value, decimals, precision);
+    Raw(number);
+  }
+
+  void Unsigned(unsigned long long value)
+  {
+    char number[24];
+    snprintf(number, sizeof(number), "%llu", value);
+    Raw(number);
+  }
+
+  size_t Length() { return overflow ? 0 : length; }
+
+private:
+  void Put(char c)
+  {
+    if (length + 1 < size)
+    {
+      buf[length++] = c;
+      buf[length] = 0;
+    }
+    else
+    {
+      overflow = true;
+    }
+  }
+
+  char *buf;
+  size_t size;
+  size_t length = 0;
+  bool overflow = false;
+};
+
+// Longest WriteRecord output: every text escaped throughout, every number at its widest.
+static constexpr size_t EscapedLength(size_t fieldSize)
+{
+  return 2 * (fieldSize - 1) + 2;
+}
+const size_t maxFixedLength = 12; // "-2147.483648", an int32 with a point and sign.
+const size_t maxRecordLength = sizeof("{\"symbol\":,\"companyName\":,\"valid\":false,\"error\":,\"price\":,\"previousClose\":,"
+                                      "\"change\":,\"changePercent\":,\"peRatio\":,\"week52High\":,\"week52Low\":,"
+                                      "\"latestUpdate\":,\"version\":}") - 1 +
+                               EscapedLength(sizeof(QuoteRecord::symbol)) + EscapedLength(sizeof(QuoteRecord::companyName)) +
+                               EscapedLength(sizeof(QuoteRecord::error)) + 7 * maxFixedLength + 20 + 10;
+const size_t maxPieceLength = maxRecordLength + 1; // A record and its separating comma.
+static_assert(maxPieceLength >= sizeof(",[,]") - 1 + 10 + maxFixedLength, "A history point must fit one piece.");
+
+static void WriteRecord(JsonBuffer &json, const QuoteRecord &record)
+{
+  json.Raw("{\"symbol\":");
+  json.Escaped(record.symbol);
+  json.Raw(",\"companyName\":");
+  json.Escaped(record.companyName);
+  json.Raw(",\"valid\":");
+  json.Raw(record.isValid ? "true" : "false");
+  if (record.error[0])
+  {
+    json.Raw(",\"error\":");
+    json.Escaped(record.error);
+  }
+  json.Raw(",\"price\":");
+  json.Fixed(record.currentPrice, record.decimals, record.decimals);
+  json.Raw(",\"previousClose\":");
+  json.Fixed(record.openPrice, record.decimals, record.decimals);
+  json.Raw(",\"change\":");
+  json.Fixed(record.change, record.decimals, record.decimals);
+  json.Raw(",\"changePercent\":");
+  json.Fixed(record.changePercent, 2, 2);
+  json.Raw(",\"peRatio\":");
+  json.Fixed(record.peRatio, 2, 2);
+  json.Raw(",\"week52High\":");
+  json.Fixed(record.week52High, record.decimals, record.decimals);
+  json.Raw(",\"week52Low\":");
+  json.Fixed(record.week52Low, record.decimals, record.decimals);
+  json.Raw(",\"latestUpdate\":");
+  json.Unsigned(record.latestUpdate);
+  json.Raw(",\"version\":");
+  json.Unsigned(record.version);
+  json.Raw("}");
+}
+
+// Produces a chunked response one piece at a time, straight into the
+// server's send buffer. Pieces are rendered on demand, the full body is never held.
+class ChunkedWriter
+{
+public:
+  virtual ~ChunkedWriter()
+  {
+    activeResponses--;
+  }
+
+  size_t Fill(uint8_t *out, size_t maxLength)
+  {
+    size_t written = 0;
+    while (written < maxLength)
+    {
+      if (pendingOffset == pendingLength)
+      {
+        JsonBuffer json(pending, sizeof(pending));
+        if (!Render(nextPiece, json))
+        {
+          break;
+        }
+        nextPiece++;
+        pendingLength = json.Length();
+        pendingOffset = 0;
+        continue;
+      }
+
+      size_t length = min(pendingLength - pendingOffset, maxLength - written);
+      memcpy(out + written, pending + pendingOffset, length);
+      pendingOffset += length;
+      written += length;
+    }
+    return written;
+  }
+
+protected:
+  // Render piece index, returns false past the last piece.
+  virtual bool Render(size_t index, JsonBuffer &json) = 0;
+
+private:
+  char pending[maxPieceLength + 1];
+  size_t pendingLength = 0;
+  size_t pendingOffset = 0;
+  size_t nextPiece = 0;
+};
+
+class QuotesWriter : public ChunkedWriter
+{
+public:
+  QuotesWriter(std::shared_ptr<const QuoteSnapshot> snapshot) : snapshot(snapshot) {}
+
+protected:
+  bool Render(size_t index, JsonBuffer &json) override
+  {
+    size_t count = snapshot->records.size();
+    if (index == 0)
+    {
+      json.Raw("{\"generation\":");
+      json.Unsigned(snapshot->generation);
+      json.Raw(",\"market\":");
+      json.Escaped(marketStateDesciptionTop[int(snapshot->marketState)]);
+      json.Raw(",\"quotes\":[");
+    }
+    else if (index <= count)
+    {
+      if (index > 1)
+      {
+        json.Raw(",");
+      }
+      WriteRecord(json, snapshot->records[index - 1]);
+    }
+    else if (index == count + 1)
+    {
+      json.Raw("]}");
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+private:
+  std::shared_ptr<const QuoteSnapshot> snapshot;
+};
+
+class HistoryWriter : public ChunkedWriter
+{
+public:
+  HistoryWriter(const char *symbol, uint8_t decimals, std::vector<HistoryPoint> &&points) : decimals(decimals), points(points)
+  {
+    strlcpy(this->symbol, symbol, sizeof(this->symbol));
+  }
+
+protected:
+  bool Render(size_t index, JsonBuffer &json) override
+  {
+    if (index == 0)
+    {
+      json.Raw("{\"symbol\":");
+      json.Escaped(symbol);
+      json.Raw(",\"interval\":60,\"points\":[");
+    }
+    else if (index <= points.size())
+    {
+      const HistoryPoint &point = points[index - 1];
+      json.Raw(index > 1 ? ",[" : "[");
+      json.Unsigned(point.epoch);
+      json.Raw(",");
+      json.Fixed(point.price, decimals, decimals);
+      json.Raw("]");
+    }
+    else if (index == points.size() + 1)
+    {
+      json.Raw("]}");
+    }
+    else
+    {
+      return false;
+    }
+    return true;
+  }
+
+private:
+  char symbol[12];
+  uint8_t decimals;
+  std::vector<HistoryPoint> points;
+};
+
+static void SendChunked(AsyncWebServerRequest *request, ChunkedWriter *writer, const char *etag)
+{
+  std::shared_ptr<ChunkedWriter> shared(writer);
+  AsyncWebServerResponse *response = request->beginChunkedResponse("application/json",
+                                                                    [shared](uint8_t *buffer, size_t maxLength, size_t) -> size_t { return shared->Fill(buffer, maxLength); });
+  response->addHeader("Access-Control-Allow-Origin", "*");
+  if (etag)
+  {
+    response->addHeader("ETag", etag);
+    response->addHeader("Cache-Control", "no-cache");
+  }
+  request->send(response);
+}
+
+static void WriteBinaryHeader(uint8_t *header, const QuoteSnapshot &snapshot)
+{
+  uint16_t count = snapshot.records.size();
+  memcpy(header, "QBQ1", 4);
+  memcpy(header + 4, &snapshot.generation, 4);
+  header[8] = uint8_t(snapshot.marketState);
+  header[9] = 0;
+  memcpy(header + 10, &count, 2);
+}
+
+static void WriteBinaryRecord(QuoteBinaryRecord *binary, const QuoteRecord &record)
+{
+  memset(binary, 0, sizeof(*binary));
+  strncpy(binary->symbol, record.symbol, sizeof(binary->symbol));
+  binary->decimals = record.decimals;
+  binary->flags = (record.isValid ? 0x01 : 0) | (record.error[0] ? 0x02 : 0);
+  binary->openPrice = record.openPrice;
+  binary->currentPrice = record.currentPrice;
+  binary->change = record.change;
+  binary->changePercent = record.changePercent;
+  binary->peRatio = record.peRatio;
+  binary->week52High = record.week52High;
+  binary->week52Low = record.week52Low;
+  binary->latestUpdate = record.latestUpdate;
+  binary->version = record.version;
+}
+
+static const size_t binaryHeaderSize = 12;
+
+// Fixed size records, any byte offset maps straight to a header or record byte.
+static size_t FillBinary(const QuoteSnapshot &snapshot, uint8_t *buffer, size_t maxLength, size_t index)
+{
+  size_t written = 0;
+  while (written < maxLength)
+  {
+    size_t offset = index + written;
+    size_t length;
+
+    if (offset < binaryHeaderSize)
+    {
+      uint8_t header[binaryHeaderSize];
+      WriteBinaryHeader(header, snapshot);
+      length = min(binaryHeaderSize - offset, maxLength - written);
+      memcpy(buffer + written, header + offset, length);
+    }
+    else
+    {
+      size_t recordIndex = (offset - binaryHeaderSize) / sizeof(QuoteBinaryRecord);
+      size_t recordOffset = (offset - binaryHeaderSize) % sizeof(QuoteBinaryRecord);
+      if (recordIndex >= snapshot.records.size())
+      {
+        break;
+      }
+      QuoteBinaryRecord record;
+      WriteBinaryRecord(&record, snapshot.records[recordIndex]);
+      length = min(sizeof(record) - recordOffset, maxLength - written);
+      memcpy(buffer + written, (uint8_t *)&record + recordOffset, length);
+    }
+
+    written += length;
+  }
+  return written;
+}
+
+// Holds the snapshot and the response slot until the server has sent the last byte.
+class BinaryWriter
+{
+public:
+  BinaryWriter(std::shared_ptr<const QuoteSnapshot> snapshot) : snapshot(snapshot) {}
+
+  ~BinaryWriter()
+  {
+    activeResponses--;
+  }
+
+  size_t Fill(uint8_t *buffer, size_t maxLength, size_t index)
+  {
+    return FillBinary(*snapshot, buffer, maxLength, index);
+  }
+
+private:
+  std::shared_ptr<const QuoteSnapshot> snapshot;
+};
+
+///////////////////////////////////////////////////////////////////////////////
+// Handlers.
+///////////////////////////////////////////////////////////////////////////////
+
+// Returns false (and answers 503) when too many responses are in flight.
+static bool AdmitRequest(AsyncWebServerRequest *request)
+{
+  if (activeResponses >= maxActiveResponses)
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 10000, "LOCALAPI: Busy, rejecting request for %s", request->url().c_str());
+    request->send(503, "text/plain", "Busy");
+    return false;
+  }
+  return true;
+}
+
+// Answers 304 when the client already holds this generation.
+static bool NotModified(AsyncWebServerRequest *request, const char *etag)
+{
+  if (request->hasHeader("If-None-Match") && request->getHeader("If-None-Match")->value() == etag)
+  {
+    request->send(304);
+    return true;
+  }
+  return false;
+}
+
+static void MakeEtag(char *etag, size_t size, const QuoteSnapshot &snapshot)
+{
+  snprintf(etag, size, "\"%u-%u\"", snapshot.generation, unsigned(snapshot.marketState));
+}
+
+static void HandleQuotes(AsyncWebServerRequest *request)
+{
+  std::shared_ptr<const QuoteSnapshot> snapshot = GetSnapshot();
+  char etag[24];
+  MakeEtag(etag, sizeof(etag), *snapshot);
+
+  if (NotModified(request, etag) || !AdmitRequest(request))
+  {
+    return;
+  }
+
+  activeResponses++;
+  SendChunked(request, new QuotesWriter(snapshot), etag);
+}
+
+static void HandleQuotesBinary(AsyncWebServerRequest *request)
+{
+  std::shared_ptr<const QuoteSnapshot> snapshot = GetSnapshot();
+  char etag[24];
+  MakeEtag(etag, sizeof(etag), *snapshot);
+
+  if (NotModified(request, etag) || !AdmitRequest(request))
+  {
+    return;
+  }
+
+  size_t length = binaryHeaderSize + snapshot->records.size() * sizeof(QuoteBinaryRecord);
+
+  activeResponses++;
+  std::shared_ptr<BinaryWriter> writer(new BinaryWriter(snapshot));
+  AsyncWebServerResponse *response = request->beginResponse("application/octet-stream", length,
+                                                            [writer](uint8_t *buffer, size_t maxLength, size_t index) -> size_t { return writer->Fill(buffer, maxLength, index); });
+  response->addHeader("Access-Control-Allow-Origin", "*");
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
+
+static void HandleQuote(AsyncWebServerRequest *request)
+{
+  if (!request->hasParam("symbol"))
+  {
+    request->send(400, "text/plain", "Missing symbol");
+    return;
+  }
+
+  std::shared_ptr<const QuoteSnapshot> snapshot = GetSnapshot();
+  const QuoteRecord *record = FindRecord(*snapshot, request->getParam("symbol")->value());
+  if (record == NULL)
+  {
+    request->send(404, "text/plain", "Unknown symbol");
+    return;
+  }
+
+  char etag[24];
+  MakeEtag(etag, sizeof(etag), *snapshot);
+  if (NotModified(request, etag))
+  {
+    return;
+  }
+
+  char body[maxRecordLength + 1];
+  JsonBuffer json(body, sizeof(body));
+  WriteRecord(json, *record);
+
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", body);
+  response->addHeader("Access-Control-Allow-Origin", "*");
+  response->addHeader("ETag", etag);
+  response->addHeader("Cache-Control", "no-cache");
+  request->send(response);
+}
+
+static void HandleHistory(AsyncWebServerRequest *request)
+{
+  if (!request->hasParam("symbol"))
+  {
+    request->send(400, "text/plain", "Missing symbol");
+    return;
+  }
+
+  std::shared_ptr<const QuoteSnapshot> snapshot = GetSnapshot();
+  const QuoteRecord *record = FindRecord(*snapshot, request->getParam("symbol")->value());
+  if (record == NULL)
+  {
+    request->send(404, "text/plain", "Unknown symbol");
+    return;
+  }
+
+  if (!AdmitRequest(request))
+  {
+    return;
+  }
+
+  std::vector<HistoryPoint> points;
+  uint8_t decimals;
+  {
+    SymbolLock lock;
+    decimals = quoteHistory.Copy(record - snapshot->records.data(), &points);
+  }
+
+  activeResponses++;
+  SendChunked(request, new HistoryWriter(record->symbol, decimals, std::move(points)), NULL);
+}
+
+static void HandleMarket(AsyncWebServerRequest *request)
+{
+  std::shared_ptr<const QuoteSnapshot> snapshot = GetSnapshot();
+  char body[96];
+  snprintf(body, sizeof(body), "{\"market\":\"%s\",\"generation\":%u,\"symbols\":%u}",
+           marketStateDesciptionTop[int(snapshot->marketState)], snapshot->generation, unsigned(snapshot->records.size()));
+
+  AsyncWebServerResponse *response = request->beginResponse(200, "application/json", body);
+  response->addHeader("Access-Control-Allow-Origin", "*");
+  request->send(response);
+}
+
+static void HandleMetrics(AsyncWebServerRequest *request)
+{
+  AsyncResponseStream *response = request->beginResponseStream("text/plain; version=0.0.4");
+  MetricsWrite(*response);
+  request->send(response);
+}
+
+// Upload is written to a part file and renamed when complete, the reload never sees half a file.
+static const char *uploadPartFilePath = "/parameters.part";
+static const size_t maxConfigUpload = 256 * 1024;
+static File uploadFile;
+static int uploadStatus = 0;
+
+static void HandleConfigBody(AsyncWebServerRequest *request, uint8_t *data, size_t length, size_t index, size_t total)
+{
+  SdLock lock;
+  if (index == 0)
+  {
+    uploadStatus = total > maxConfigUpload ? 413 : 202;
+    if (uploadStatus == 202)
+    {
+      uploadFile = SD.open(uploadPartFilePath, FILE_WRITE);
+      uploadStatus = uploadFile ? 202 : 500;
+    }
+  }
+
+  if (uploadStatus == 202 && uploadFile.write(data, length) != length)
+  {
+    uploadStatus = 500;
+  }
+
+  if (index + length == total && uploadFile)
+  {
+    uploadFile.close();
+    SD.remove(parametersUploadFilePath);
+    if (uploadStatus != 202 || !SD.rename(uploadPartFilePath, parametersUploadFilePath))
+    {
+      SD.remove(uploadPartFilePath);
+      uploadStatus = uploadStatus == 202 ? 500 : uploadStatus;
+    }
+  }
+}
+
+static void HandleConfig(AsyncWebServerRequest *request)
+{
+  const char *body = uploadStatus == 202   ? "{\"status\":\"accepted\"}"
+                     : uploadStatus == 413 ? "{\"status\":\"too large\"}"
+                                           : "{\"status\":\"not stored\"}";
+  request->send(uploadStatus ? uploadStatus : 400, "application/json", body);
+  LOG_INFO("LOCALAPI: Configuration upload answered %d.", uploadStatus ? uploadStatus : 400);
+  uploadStatus = 0;
+}
+
+void LocalApiBegin(uint16_t port, int maxClients, bool metrics, bool configUpload)
+{
+  maxActiveResponses = max(maxClients, 1);
+
+  server = new AsyncWebServer(port);
+  server->on("/api/quotes", HTTP_GET, HandleQuotes);
+  server->on("/api/quotes.bin", HTTP_GET, HandleQuotesBinary);
+  server->on("/api/quote", HTTP_GET, HandleQuote);
+  server->on("/api/history", HTTP_GET, HandleHistory);
+  server->on("/api/market", HTTP_GET, HandleMarket);
+  if (metrics)
+  {
+    server->on("/metrics", HTTP_GET, HandleMetrics);
+  }
+  if (configUpload)
+  {
+    server->on("/api/config", HTTP_POST, HandleConfig, NULL, HandleConfigBody);
+  }
+  server->onNotFound([](AsyncWebServerRequest *request) { request->send(404, "text/plain", "Not found"); });
+  server->begin();
+
+  LOG_INFO("LOCALAPI: Serving quotes on port %u", port);
+}
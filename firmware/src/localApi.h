@@ -0,0 +1,47 @@
+/*
+    localApi.h
+
+    Asynchronous HTTP server sharing the cached quotes with other devices
+    on the LAN, so they do not each spend their own API quota.
+
+    GET /api/quotes       Symbol table as JSON.
+    GET /api/quotes.bin   Symbol table as packed little endian records (see QuoteBinaryRecord).
+    GET /api/quote        ?symbol= a single symbol as JSON.
+    GET /api/history      ?symbol= the locally collected one minute prices as JSON.
+    GET /api/market       Market state and quote generation.
+    GET /metrics          Prometheus text format (see metrics.h), when enabled.
+    POST /api/config      Replacement parameters.json, when enabled. Answered with 202, the
+                          file is validated and applied by the reload in loop().
+
+    Quote responses carry an ETag, a matching If-None-Match is answered with 304.
+    Requests are served by the AsyncTCP task and read an immutable snapshot
+    of the symbol table, the display loop is never blocked by a client.
+*/
+
+#ifndef LOCALAPI_H
+#define LOCALAPI_H
+
+#include <Arduino.h>
+
+// Binary response: "QBQ1", generation (u32), market state (u8), reserved (u8),
+// record count (u16), then one record per symbol.
+struct __attribute__((packed)) QuoteBinaryRecord
+{
+    char symbol[12]; // Zero padded.
+    uint8_t decimals;
+    uint8_t flags; // Bit 0 valid, bit 1 error.
+    uint16_t reserved;
+    int32_t openPrice;
+    int32_t currentPrice;
+    int32_t change;
+    int32_t changePercent; // Hundredths of a percent.
+    int32_t peRatio;       // Hundredths.
+    int32_t week52High;
+    int32_t week52Low;
+    uint64_t latestUpdate;
+    uint32_t version;
+};
+
+void LocalApiBegin(uint16_t port, int maxClients, bool metrics, bool configUpload);
+
+#endif
@@ -0,0 +1,391 @@
+#include "logger.h"
+#include <atomic>
+#include <SD.h>
+#include "sdLock.h"
+#include "taskConfig.h"
+
+// Bounded multi producer queue (Vyukov), the drain task is the only consumer.
+// Each slot's sequence tells producers and the consumer whose turn it is.
+struct LogSlot
+{
+  std::atomic<uint32_t> sequence;
+  uint8_t level;
+  uint32_t timestamp;
+  char text[logMessageLength];
+};
+
+static LogSlot slots[logRingSlots];
+static std::atomic<uint32_t> enqueuePosition(0);
+static uint32_t dequeuePosition = 0;
+
+static std::atomic<uint32_t> writtenCount(0);
+static std::atomic<uint32_t> droppedCount(0);
+static std::atomic<uint32_t> collapsedCount(0);
+
+static volatile int runtimeLevel = LOG_LEVEL;
+
+// Only ever appended to, an entry is complete before the count covers it, so tasks logging
+// meanwhile read the table without a lock.
+static char secrets[logMaxSecrets][72];
+static std::atomic<int> secretCount(0);
+
+static char mirrorPath[32];
+static size_t mirrorMaxFileSize;
+static int mirrorMaxFiles;
+static volatile bool mirrorEnabled = false;
+static File mirrorFile;
+
+static const char levelLetters[] = {'-', 'E', 'W', 'I', 'D'};
+static const char *const levelNames[] = {"NONE", "ERROR", "WARN", "INFO", "DEBUG"};
+
+///////////////////////////////////////////////////////////////////////////////
+// Producer side.
+///////////////////////////////////////////////////////////////////////////////
+
+// Replace length characters at position with asterisks, shrinking long secrets to three.
+static void Mask(char *position, size_t length)
+{
+  if (length <= 3)
+  {
+    memset(position, '*', length);
+    return;
+  }
+
+  memmove(position + 3, position + length, strlen(position + length) + 1);
+  memcpy(position, "***", 3);
+}
+
+static void Redact(char *text)
+{
+  for (int i = 0; i < secretCount; i++)
+  {
+    size_t length = strlen(secrets[i]);
+    char *found;
+    while ((found = strstr(text, secrets[i])) != NULL)
+    {
+      Mask(found, length);
+    }
+  }
+
+  // API tokens in query strings, whatever their value.
+  char *token = text;
+  while ((token = strstr(token, "token=")) != NULL)
+  {
+    token += 6;
+    size_t length = strcspn(token, "& \"");
+    if (length > 0)
+    {
+      Mask(token, length);
+    }
+  }
+}
+
+// Mask the start of a secret left at the end of a cut message, Redact() only finds whole ones.
+static void MaskCutSecret(char *text)
+{
+  size_t textLength = strlen(text);
+  for (int i = 0; i < secretCount; i++)
+  {
+    for (size_t length = min(strlen(secrets[i]) - 1, textLength); length > 0; length--)
+    {
+      if (strncmp(text + textLength - length, secrets[i], length) == 0)
+      {
+        Mask(text + textLength - length, length);
+        textLength = strlen(text);
+        break;
+      }
+    }
+  }
+}
+
+static void Enqueue(int level, const char *text)
+{
+  uint32_t position = enqueuePosition.load(std::memory_order_relaxed);
+  LogSlot *slot;
+
+  while (1)
+  {
+    slot = &slots[position & (logRingSlots - 1)];
+    uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+    int32_t difference = (int32_t)(sequence - position);
+
+    if (difference == 0)
+    {
+      if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+      {
+        break;
+      }
+    }
+    else if (difference < 0)
+    {
+      droppedCount.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    else
+    {
+      position = enqueuePosition.load(std::memory_order_relaxed);
+    }
+  }
+
+  slot->level = level;
+  slot->timestamp = millis();
+  strlcpy(slot->text, text, logMessageLength);
+  slot->sequence.store(position + 1, std::memory_order_release);
+  writtenCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+static void WriteV(int level, uint32_t suppressed, const char *format, va_list args)
+{
+  if (level > runtimeLevel)
+  {
+    return;
+  }
+
+  // Formatted with room for a whole secret past the end, redacted, then cut to the slot size. A
+  // token value cut by the buffer runs to the end and is masked to there.
+  char text[logMessageLength + sizeof(secrets[0])];
+  int length = vsnprintf(text, sizeof(text), format, args);
+  if (length < 0)
+  {
+    return;
+  }
+  if (length >= (int)sizeof(text))
+  {
+    MaskCutSecret(text);
+  }
+  Redact(text);
+  text[logMessageLength - 1] = 0;
+
+  length = strlen(text);
+  if (suppressed > 0 && length < logMessageLength - 1)
+  {
+    snprintf(text + length, logMessageLength - length, " (%u suppressed)", suppressed);
+  }
+
+  Enqueue(level, text);
+}
+
+void LogWrite(int level, const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  WriteV(level, 0, format, args);
+  va_end(args);
+}
+
+void LogWriteSuppressed(int level, uint32_t suppressed, const char *format, ...)
+{
+  va_list args;
+  va_start(args, format);
+  WriteV(level, suppressed, format, args);
+  va_end(args);
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Consumer side.
+///////////////////////////////////////////////////////////////////////////////
+
+static bool Dequeue(uint8_t *level, uint32_t *timestamp, char *text)
+{
+  LogSlot *slot = &slots[dequeuePosition & (logRingSlots - 1)];
+  uint32_t sequence = slot->sequence.load(std::memory_order_acquire);
+
+  if ((int32_t)(sequence - (dequeuePosition + 1)) < 0)
+  {
+    return false;
+  }
+
+  *level = slot->level;
+  *timestamp = slot->timestamp;
+  memcpy(text, slot->text, logMessageLength);
+  slot->sequence.store(dequeuePosition + logRingSlots, std::memory_order_release);
+  dequeuePosition++;
+  return true;
+}
+
+static void RotateMirror()
+{
+  char from[40];
+  char to[40];
+
+  mirrorFile.close();
+
+  snprintf(to, sizeof(to), "%s.%d", mirrorPath, mirrorMaxFiles - 1);
+  SD.remove(to);
+  for (int i = mirrorMaxFiles - 2; i >= 1; i--)
+  {
+    snprintf(from, sizeof(from), "%s.%d", mirrorPath, i);
+    snprintf(to, sizeof(to), "%s.%d", mirrorPath, i + 1);
+    SD.rename(from, to);
+  }
+  snprintf(to, sizeof(to), "%s.1", mirrorPath);
+  SD.rename(mirrorPath, to);
+
+  mirrorFile = SD.open(mirrorPath, FILE_APPEND);
+}
+
+static void Emit(const char *line, size_t length)
+{
+  Serial.write((const uint8_t *)line, length);
+
+  if (mirrorEnabled)
+  {
+    SdLock lock;
+    if (!mirrorFile)
+    {
+      mirrorFile = SD.open(mirrorPath, FILE_APPEND);
+    }
+    if (mirrorFile)
+    {
+      mirrorFile.write((const uint8_t *)line, length);
+      if (mirrorFile.size() > mirrorMaxFileSize)
+      {
+        RotateMirror();
+      }
+    }
+  }
+}
+
+static void EmitMessage(uint8_t level, uint32_t timestamp, const char *text)
+{
+  char line[logMessageLength + 16];
+  int length = snprintf(line, sizeof(line), "[%8u] %c %s\n", timestamp, levelLetters[level], text);
+  Emit(line, min(length, (int)sizeof(line) - 1));
+}
+
+static void LogTask(void *)
+{
+  static char text[logMessageLength];
+  static char previousText[logMessageLength] = "";
+  uint8_t previousLevel = 0;
+  uint8_t level;
+  uint32_t timestamp;
+  uint32_t repeats = 0;
+  unsigned long lastEmit = 0;
+
+  while (1)
+  {
+    bool emitted = false;
+
+    while (Dequeue(&level, &timestamp, text))
+    {
+      // Fold identical consecutive messages into a single repeat count.
+      if (level == previousLevel && strcmp(text, previousText) == 0)
+      {
+        repeats++;
+        collapsedCount.fetch_add(1, std::memory_order_relaxed);
+        continue;
+      }
+
+      if (repeats > 0)
+      {
+        char note[48];
+        snprintf(note, sizeof(note), "LOG: last message repeated %u times", repeats);
+        EmitMessage(previousLevel, timestamp, note);
+        repeats = 0;
+      }
+
+      EmitMessage(level, timestamp, text);
+      memcpy(previousText, text, logMessageLength);
+      previousLevel = level;
+      lastEmit = millis();
+      emitted = true;
+    }
+
+    if (repeats > 0 && millis() - lastEmit > 5000)
+    {
+      char note[48];
+      snprintf(note, sizeof(note), "LOG: last message repeated %u times", repeats);
+      EmitMessage(previousLevel, millis(), note);
+      repeats = 0;
+      previousText[0] = 0;
+    }
+
+    if (emitted && mirrorEnabled && mirrorFile)
+    {
+      SdLock lock;
+      mirrorFile.flush();
+    }
+
+    vTaskDelay(pdMS_TO_TICKS(20));
+  }
+}
+
+///////////////////////////////////////////////////////////////////////////////
+// Configuration.
+///////////////////////////////////////////////////////////////////////////////
+
+void LogBegin(int level)
+{
+  for (int i = 0; i < logRingSlots; i++)
+  {
+    slots[i].sequence.store(i, std::memory_order_relaxed);
+  }
+  runtimeLevel = level;
+
+  // Low priority on the protocol core, the display loop never waits on the UART.
+  StartTask(LogTask, logTaskConfig);
+}
+
+void LogSetLevel(int level)
+{
+  runtimeLevel = level;
+}
+
+void LogAddSecret(const char *secret)
+{
+  // Short strings would mask unrelated text.
+  if (strlen(secret) < 4)
+  {
+    return;
+  }
+  int count = secretCount;
+  for (int i = 0; i < count; i++)
+  {
+    if (strcmp(secrets[i], secret) == 0)
+    {
+      return;
+    }
+  }
+  if (count >= logMaxSecrets)
+  {
+    LOG_ERROR("LOG: More than %i secrets, the rest are not redacted.", logMaxSecrets);
+    return;
+  }
+  if (strlen(secret) >= sizeof(secrets[0]))
+  {
+    LOG_ERROR("LOG: A secret of %u characters is too long to redact.", strlen(secret));
+    return;
+  }
+  strcpy(secrets[count], secret);
+  secretCount = count + 1;
+}
+
+void LogEnableSdMirror(const char *path, size_t maxFileSize, int maxFiles)
+{
+  strlcpy(mirrorPath, path, sizeof(mirrorPath));
+  mirrorMaxFileSize = maxFileSize;
+  mirrorMaxFiles = max(maxFiles, 2);
+  mirrorEnabled = true;
+}
+
+LogStats LogGetStats()
+{
+  LogStats stats;
+  stats.written = writtenCount.load(std::memory_order_relaxed);
+  stats.dropped = droppedCount.load(std::memory_order_relaxed);
+  stats.collapsed = collapsedCount.load(std::memory_order_relaxed);
+  return stats;
+}
+
+int LogLevelFromString(const String &level)
+{
+  for (int i = LOG_LEVEL_NONE; i <= LOG_LEVEL_DEBUG; i++)
+  {
+    if (level.equalsIgnoreCase(levelNames[i]))
+    {
+      return i;
+    }
+  }
+  return LOG_LEVEL;
+}
@@ -0,0 +1,109 @@
+/*
+    logger.h
+
+    Leveled logging. Messages are formatted by the caller, redacted, and
+    pushed into a lock free ring buffer. A low priority task drains the
+    buffer to Serial and optionally mirrors it to a rotating file on the SD card.
+
+    Levels above LOG_LEVEL are stripped at compile time (set with -DLOG_LEVEL=n).
+*/
+
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <Arduino.h>
+
+#define LOG_LEVEL_NONE 0
+#define LOG_LEVEL_ERROR 1
+#define LOG_LEVEL_WARN 2
+#define LOG_LEVEL_INFO 3
+#define LOG_LEVEL_DEBUG 4
+
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_INFO
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) LogWrite(LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define LOG_ERROR(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_WARN
+#define LOG_WARN(...) LogWrite(LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define LOG_WARN(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define LOG_INFO(...) LogWrite(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define LOG_INFO(...) do {} while (0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) LogWrite(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define LOG_DEBUG(...) do {} while (0)
+#endif
+
+// Log from a call site at most once per intervalMs, e.g. inside loop().
+// Suppressed calls are counted and reported with the next message that passes.
+#define LOG_RATE_LIMITED(level, intervalMs, ...)                                  \
+  do                                                                              \
+  {                                                                               \
+    static LogRateLimiter logRateLimiter_;                                        \
+    if ((level) <= LOG_LEVEL && logRateLimiter_.Allow(intervalMs))                \
+    {                                                                             \
+      LogWriteSuppressed((level), logRateLimiter_.TakeSuppressed(), __VA_ARGS__); \
+    }                                                                             \
+  } while (0)
+
+const int logMessageLength = 120; // Longer messages are truncated.
+const int logRingSlots = 32;      // Must be a power of two.
+const int logMaxSecrets = 16; // Keys and passwords, those of a reload are added to the boot ones.
+
+struct LogStats
+{
+  uint32_t written;
+  uint32_t dropped; // Ring buffer full.
+  uint32_t collapsed; // Identical consecutive messages folded into a repeat count.
+};
+
+class LogRateLimiter
+{
+public:
+  bool Allow(unsigned long intervalMs)
+  {
+    unsigned long now = millis();
+    if (last != 0 && now - last < intervalMs)
+    {
+      suppressed++;
+      return false;
+    }
+    last = now == 0 ? 1 : now;
+    return true;
+  }
+
+  uint32_t TakeSuppressed()
+  {
+    uint32_t count = suppressed;
+    suppressed = 0;
+    return count;
+  }
+
+private:
+  unsigned long last = 0;
+  uint32_t suppressed = 0;
+};
+
+void LogBegin(int runtimeLevel = LOG_LEVEL);
+void LogSetLevel(int runtimeLevel);
+void LogAddSecret(const char *secret);
+void LogEnableSdMirror(const char *path, size_t maxFileSize, int maxFiles);
+void LogWrite(int level, const char *format, ...) __attribute__((format(printf, 2, 3)));
+void LogWriteSuppressed(int level, uint32_t suppressed, const char *format, ...) __attribute__((format(printf, 3, 4)));
+LogStats LogGetStats();
+int LogLevelFromString(const String &level);
+
+#endif
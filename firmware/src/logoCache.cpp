@@ -0,0 +1,312 @@
+#include "logoCache.h"
+#include <SD.h>
+#include <PNGdec.h>
+#include <algorithm>
+#include <memory>
+#include "sdLock.h"
+#include "logger.h"
+
+static const char logoMagic[4] = {'Q', 'B', 'L', '1'};
+static const uint32_t missingRetrySeconds = 7 * 24 * 3600; // Providers add logos for new listings.
+
+// Box filter from the decoded lines into the square, one output row is summed at a time.
+struct FitState
+{
+  PNG *png;
+  int sourceWidth;
+  int sourceHeight;
+  int width; // Fitted, centred in the square.
+  int height;
+  int left;
+  int top;
+  int size;
+  int row;
+  std::vector<uint16_t> line;
+  std::vector<uint32_t> sums; // Red, green, blue per output column.
+  std::vector<uint16_t> counts;
+  uint16_t *pixels;
+};
+
+static void FlushRow(FitState *state)
+{
+  uint16_t *out = state->pixels + (state->top + state->row) * state->size + state->left;
+  for (int x = 0; x < state->width; x++)
+  {
+    uint16_t count = state->counts[x];
+    if (count > 0)
+    {
+      out[x] = (state->sums[x * 3] / count) << 11 | (state->sums[x * 3 + 1] / count) << 5 | state->sums[x * 3 + 2] / count;
+    }
+  }
+  std::fill(state->sums.begin(), state->sums.end(), 0);
+  std::fill(state->counts.begin(), state->counts.end(), 0);
+}
+
+static int FitLine(PNGDRAW *draw)
+{
+  FitState *state = (FitState *)draw->pUser;
+  state->png->getLineAsRGB565(draw, state->line.data(), PNG_RGB565_LITTLE_ENDIAN, 0); // Transparency over black.
+
+  int row = draw->y * state->height / state->sourceHeight;
+  if (row != state->row)
+  {
+    FlushRow(state);
+    state->row = row;
+  }
+
+  for (int x = 0; x < draw->iWidth; x++)
+  {
+    int column = x * state->width / state->sourceWidth;
+    uint16_t color = state->line[x];
+    state->sums[column * 3] += color >> 11;
+    state->sums[column * 3 + 1] += (color >> 5) & 0x3F;
+    state->sums[column * 3 + 2] += color & 0x1F;
+    state->counts[column]++;
+  }
+  return 1;
+}
+
+bool LogoCache::Begin(const char *logoDirectory, uint16_t logoSize, size_t ramSlots)
+{
+  SdLock lock;
+
+  directory = logoDirectory;
+  size = logoSize;
+  slots.resize(ramSlots);
+
+  if (!SD.exists(directory.c_str()) && !SD.mkdir(directory.c_str()))
+  {
+    LOG_ERROR("LOGO: Failed to create %s", directory.c_str());
+    return false;
+  }
+
+  String indexPath = directory + "/index.bin";
+  File file = SD.open(indexPath);
+  char magic[4];
+  size_t stored = 0;
+
+  if (file && file.read((uint8_t *)magic, 4) == 4 && memcmp(magic, logoMagic, 4) == 0)
+  {
+    LogoRecord record;
+    while (file.read((uint8_t *)&record, sizeof(record)) == sizeof(record))
+    {
+      record.symbol[sizeof(record.symbol) - 1] = 0;
+      records.push_back(record);
+      stored += record.size == size;
+    }
+    file.close();
+  }
+  else
+  {
+    // Missing or from another version, every logo is fetched again.
+    file.close();
+    file = SD.open(indexPath, FILE_WRITE);
+    if (!file)
+    {
+      LOG_ERROR("LOGO: Failed to create %s", indexPath.c_str());
+      return false;
+    }
+    file.write((const uint8_t *)logoMagic, 4);
+    file.close();
+  }
+
+  enabled = true;
+  LOG_INFO("LOGO: %u of %u logos at %u px in %s", stored, records.size(), size, directory.c_str());
+  return true;
+}
+
+int LogoCache::Find(const String &symbol)
+{
+  for (size_t i = 0; i < records.size(); i++)
+  {
+    if (symbol == records[i].symbol)
+    {
+      return i;
+    }
+  }
+  return -1;
+}
+
+int LogoCache::FindOrAdd(const String &symbol)
+{
+  int index = Find(symbol);
+  if (index < 0)
+  {
+    LogoRecord record = {};
+    strncpy(record.symbol, symbol.c_str(), sizeof(record.symbol) - 1);
+    records.push_back(record);
+    index = records.size() - 1;
+  }
+  return index;
+}
+
+bool LogoCache::Wanted(const String &symbol, uint32_t now)
+{
+  if (!enabled || symbol.length() >= sizeof(LogoRecord::symbol))
+  {
+    return false;
+  }
+
+  SdLock lock;
+  int index = Find(symbol);
+  if (index < 0)
+  {
+    return true;
+  }
+  const LogoRecord &record = records[index];
+  return record.size == 0 ? now - record.checkedAt > missingRetrySeconds : record.size != size;
+}
+
+bool LogoCache::StorePng(const String &symbol, std::vector<uint8_t> &png, uint32_t now)
+{
+  if (!enabled || symbol.length() >= sizeof(LogoRecord::symbol))
+  {
+    return false;
+  }
+
+  // The decoder is large, it only exists while a logo is converted.
+  std::unique_ptr<PNG> decoder(new PNG());
+  if (decoder->openRAM(png.data(), png.size(), FitLine) != PNG_SUCCESS)
+  {
+    LOG_WARN("LOGO: %s is not a PNG the decoder supports.", symbol.c_str());
+    return false;
+  }
+
+  // Shrunk to fit the square with its aspect ratio kept, never enlarged.
+  FitState state;
+  state.png = decoder.get();
+  state.sourceWidth = decoder->getWidth();
+  state.sourceHeight = decoder->getHeight();
+  int longest = max(state.sourceWidth, state.sourceHeight);
+  state.width = longest > size ? max(state.sourceWidth * size / longest, 1) : state.sourceWidth;
+  state.height = longest > size ? max(state.sourceHeight * size / longest, 1) : state.sourceHeight;
+  state.left = (size - state.width) / 2;
+  state.top = (size - state.height) / 2;
+  state.size = size;
+  state.row = 0;
+  state.line.resize(state.sourceWidth);
+  state.sums.assign(state.width * 3, 0);
+  state.counts.assign(state.width, 0);
+  std::vector<uint16_t> pixels(size * size, TFT_BLACK);
+  state.pixels = pixels.data();
+
+  unsigned long start = millis();
+  int result = decoder->decode(&state, 0);
+  FlushRow(&state);
+  decoder->close();
+  decoder.reset();
+
+  if (result != PNG_SUCCESS)
+  {
+    LOG_WARN("LOGO: Decoding %s failed: %i", symbol.c_str(), result);
+    return false;
+  }
+
+  SdLock lock;
+  int index = FindOrAdd(symbol);
+  File file = SD.open(BlobPath(index), FILE_WRITE);
+  size_t bytes = pixels.size() * sizeof(uint16_t);
+  bool written = file && file.write((const uint8_t *)pixels.data(), bytes) == bytes;
+  file.close();
+  if (!written)
+  {
+    LOG_ERROR("LOGO: Failed to write %s", BlobPath(index).c_str());
+    return false;
+  }
+
+  records[index].size = size;
+  records[index].checkedAt = now;
+  WriteRecord(index);
+  version++;
+  LOG_INFO("LOGO: %s stored, %ix%i from %ix%i in %lu ms.", symbol.c_str(), state.width, state.height,
+           state.sourceWidth, state.sourceHeight, millis() - start);
+  return true;
+}
+
+void LogoCache::MarkMissing(const String &symbol, uint32_t now)
+{
+  if (!enabled || symbol.length() >= sizeof(LogoRecord::symbol))
+  {
+    return;
+  }
+
+  SdLock lock;
+  int index = FindOrAdd(symbol);
+  records[index].size = 0;
+  records[index].checkedAt = now;
+  WriteRecord(index);
+  LOG_INFO("LOGO: No logo for %s.", symbol.c_str());
+}
+
+bool LogoCache::Draw(const String &symbol, int x, int y)
+{
+  if (!enabled)
+  {
+    return false;
+  }
+
+  auto slot = std::find_if(slots.begin(), slots.end(), [&](const RamSlot &slot) { return slot.symbol == symbol; });
+  if (slot == slots.end())
+  {
+    std::vector<uint16_t> pixels;
+    if (!Load(symbol, &pixels))
+    {
+      return false;
+    }
+
+    // The least recently drawn logo makes room.
+    slot = std::min_element(slots.begin(), slots.end(), [](const RamSlot &a, const RamSlot &b) { return a.lastUsed < b.lastUsed; });
+    slot->symbol = symbol;
+    slot->pixels.swap(pixels);
+  }
+  slot->lastUsed = ++useCounter;
+
+  tft.setSwapBytes(true);
+  tft.pushImage(x, y, size, size, slot->pixels.data());
+  tft.setSwapBytes(false);
+  return true;
+}
+
+bool LogoCache::Load(const String &symbol, std::vector<uint16_t> *pixels)
+{
+  SdLock lock;
+
+  int index = Find(symbol);
+  if (index < 0 || records[index].size != size)
+  {
+    return false;
+  }
+
+  size_t bytes = size * size * sizeof(uint16_t);
+  File file = SD.open(BlobPath(index));
+  if (!file || file.size() != bytes)
+  {
+    file.close();
+    return false;
+  }
+
+  pixels->resize(size * size);
+  bool loaded = file.read((uint8_t *)pixels->data(), bytes) == bytes;
+  file.close();
+  return loaded;
+}
+
+void LogoCache::WriteRecord(size_t index)
+{
+  File file = SD.open(directory + "/index.bin", "r+");
+  if (!file || !file.seek(sizeof(logoMagic) + index * sizeof(LogoRecord)))
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 60000, "LOGO: Failed to update index in %s", directory.c_str());
+    file.close();
+    return;
+  }
+  file.write((const uint8_t *)&records[index], sizeof(LogoRecord));
+  file.close();
+}
+
+String LogoCache::BlobPath(size_t index)
+{
+  char name[16];
+  snprintf(name, sizeof(name), "/%u.565", index);
+  return directory + name;
+}
@@ -0,0 +1,81 @@
+/*
+    logoCache.h
+
+    Company logos, decoded once and kept on the SD card as raw RGB565.
+    The fetch task downloads a logo, decodes the PNG, fits it into the
+    size x size square and writes the pixels to the card, so showing a
+    logo is one file read and one pushImage with no decoding on the
+    render path. The most recently drawn logos also stay in RAM.
+
+    Index file: "QBL1", then one LogoRecord per symbol looked up, rewritten
+    record by record as they change. Pixels of record n are in n.565, size
+    x size native endian RGB565. Symbols without a logo are recorded too,
+    and asked for again after a week.
+*/
+
+#ifndef LOGOCACHE_H
+#define LOGOCACHE_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <vector>
+#include <atomic>
+
+struct __attribute__((packed)) LogoRecord
+{
+    char symbol[12];    // NUL padded.
+    uint16_t size;      // Edge in pixels, 0 when the symbol has no logo.
+    uint16_t reserved;
+    uint32_t checkedAt; // Epoch of the last download.
+};
+
+class LogoCache
+{
+public:
+    LogoCache(TFT_eSPI &tft) : tft(tft) {}
+
+    bool Begin(const char *directory, uint16_t size, size_t ramSlots);
+    bool Enabled() { return enabled; }
+
+    // True when symbol has no logo at the current size and was not found missing lately.
+    bool Wanted(const String &symbol, uint32_t now);
+
+    // Decodes a PNG and stores it fitted to the square. False when it can not be decoded.
+    bool StorePng(const String &symbol, std::vector<uint8_t> &png, uint32_t now);
+
+    // The provider has no logo for symbol.
+    void MarkMissing(const String &symbol, uint32_t now);
+
+    // Draws the logo with its top left corner at x, y. False, with nothing drawn, when there is none.
+    bool Draw(const String &symbol, int x, int y);
+
+    // Changes when a logo is stored, the one on screen may have arrived.
+    uint32_t Version() { return version; }
+
+private:
+    struct RamSlot
+    {
+        String symbol;
+        std::vector<uint16_t> pixels;
+        uint32_t lastUsed = 0;
+    };
+
+    int Find(const String &symbol);
+    int FindOrAdd(const String &symbol);
+    bool Load(const String &symbol, std::vector<uint16_t> *pixels);
+    void WriteRecord(size_t index);
+    String BlobPath(size_t index);
+
+    TFT_eSPI &tft;
+    bool enabled = false;
+    String directory;
+    uint16_t size = 0;
+    std::vector<LogoRecord> records; // Guarded by the SdLock.
+    std::vector<RamSlot> slots;      // Display loop only.
+    uint32_t useCounter = 0;
+    std::atomic<uint32_t> version{0};
+};
+
+extern LogoCache logoCache;
+
+#endif
@@ -0,0 +1,54 @@
+#include "lttb.h"
+
+void LttbDownsample(const HistoryPoint *points, size_t count, size_t threshold, std::vector<HistoryPoint> *out)
+{
+  if (threshold >= count || threshold < 3)
+  {
+    out->insert(out->end(), points, points + count);
+    return;
+  }
+
+  // Times relative to the first point keep the float math exact for a day of minutes.
+  const uint32_t origin = points[0].epoch;
+  const float bucketSize = float(count - 2) / (threshold - 2);
+  size_t kept = 0;
+
+  out->push_back(points[0]);
+  for (size_t bucket = 0; bucket < threshold - 2; bucket++)
+  {
+    // Average of the next bucket, the last point for the final one.
+    size_t nextStart = min(size_t((bucket + 1) * bucketSize) + 1, count - 1);
+    size_t nextEnd = max(min(size_t((bucket + 2) * bucketSize) + 1, count), nextStart + 1);
+    float averageX = 0;
+    float averageY = 0;
+    for (size_t i = nextStart; i < nextEnd; i++)
+    {
+      averageX += points[i].epoch - origin;
+      averageY += points[i].price;
+    }
+    averageX /= nextEnd - nextStart;
+    averageY /= nextEnd - nextStart;
+
+    size_t start = size_t(bucket * bucketSize) + 1;
+    size_t end = nextStart;
+    float keptX = points[kept].epoch - origin;
+    float keptY = points[kept].price;
+    float largestArea = -1;
+    size_t selected = start;
+    for (size_t i = start; i < end; i++)
+    {
+      // Twice the triangle area, the factor does not change the choice.
+      float area = fabsf((keptX - averageX) * (points[i].price - keptY) -
+                         (keptX - (points[i].epoch - origin)) * (averageY - keptY));
+      if (area > largestArea)
+      {
+        largestArea = area;
+        selected = i;
+      }
+    }
+
+    out->push_back(points[selected]);
+    kept = selected;
+  }
+  out->push_back(points[count - 1]);
+}
@@ -0,0 +1,21 @@
+/*
+    lttb.h
+
+    Largest-Triangle-Three-Buckets downsampling. Keeps the first and last
+    point, and from each bucket in between the point forming the largest
+    triangle with the previously kept point and the next bucket's average,
+    so peaks and troughs survive where plain decimation would drop them.
+*/
+
+#ifndef LTTB_H
+#define LTTB_H
+
+#include <Arduino.h>
+#include <vector>
+#include "quoteHistory.h"
+
+// Appends at most threshold points of points[0..count) to out, oldest first.
+// Fewer than three points, or no more than threshold, are copied unchanged.
+void LttbDownsample(const HistoryPoint *points, size_t count, size_t threshold, std::vector<HistoryPoint> *out);
+
+#endif
@@ -16,11 +16,11 @@
 
   Supported API(s):
     https://iexcloud.io  
+    https://finnhub.io
 
   TODO: 
     Check for market holiday.      
     Apply timezone offset to local time.   
-    Add another API.
 
   History:
 
@@ -43,6 +43,37 @@
 #include "time.h"
 #include <Adafruit_NeoPixel.h>
 #include "utilities.h"       // Local.
+#include "fixedPoint.h"      // Local.
+#include "logger.h"          // Local.
+#include "sdLock.h"          // Local.
+#include "demoMarket.h"      // Local.
+#include "quoteRecorder.h"   // Local.
+#include "providerManager.h" // Local.
+#include "sseClient.h"       // Local.
+#include "quoteHistory.h"    // Local.
+#include "localApi.h"        // Local.
+#include "metrics.h"         // Local.
+#include "peerSync.h"        // Local.
+#include "responseCache.h"   // Local.
+#include "gzipStream.h"      // Local.
+#include "teeStream.h"       // Local.
+#include "configLoader.h"    // Local.
+#include "symbolIndex.h"     // Local.
+#include "symbolBrowser.h"   // Local.
+#include "taskConfig.h"      // Local.
+#include "httpDeadline.h"    // Local.
+#include "backoff.h"         // Local.
+#include "intradayChart.h"   // Local.
+#include "overviewGrid.h"    // Local.
+#include "tickerTape.h"      // Local.
+#include "fontAtlas.h"       // Local.
+#include "layout.h"          // Local.
+#include "logoCache.h"       // Local.
+#include "priceAlerts.h"     // Local.
+#include <WiFiClientSecure.h>
+#include <StreamString.h>
+#include <esp_timer.h>
+#include <memory>
 #include "tftMethods.h"      // Local.
 #include "main.h"            // Local.
 #include "neoPixelMethods.h" // Local.
@@ -68,22 +99,74 @@ Parameters parameters;
 Status status;
 MarketState marketState;
 
+SemaphoreHandle_t sdMutex;
+SemaphoreHandle_t symbolMutex;
+SemaphoreHandle_t symbolTableMutex;
+QueueHandle_t fetchQueue;
+QueueHandle_t alertQueue;                 // Fired alerts, from the ingesting tasks to the loop.
+TaskHandle_t fetchTaskHandle = NULL;
+std::atomic<bool> fetchCancel(false);     // Set by the watchdog, ends the request at its next read.
+std::atomic<uint32_t> fetchStartMs(0);    // Non zero while the fetch task holds the SymbolTableLock for a request.
+SocketWatch fetchSocket;                  // Connection of the fetch task's request, shut down by the watchdog.
+volatile FetchResult apiFault = FetchResult::Ok; // Why quotes are stale, shown as a banner over the cached ones.
+AlertEvent shownAlert;                    // Latest fired alert, on the banner and the matrix while alertShowing.
+bool alertShowing = false;
+unsigned long alertStart = 0;
+uint32_t alertVersion = 0;                // Changes when an alert is shown or taken down.
+RTC_NOINIT_ATTR uint8_t bootFailures;     // Survives the restart after a boot error.
+DemoMarket demoMarket;
+QuoteRecorder quoteRecorder;
+ProviderManager providerManager;
+StreamStats streamStats;
+QuoteHistory quoteHistory;
+PeerSync peerSync;
+ResponseCache responseCache;
+SymbolIndex symbolIndex;
+SymbolBrowser symbolBrowser(tft, symbolIndex);
+IntradayChart intradayChart(tft);
+OverviewGrid overviewGrid(tft);
+TickerTape tickerTape(tft);
+FontAtlas priceFont(tft);
+LogoCache logoCache(tft);
+volatile uint32_t quoteGeneration = 0;
+volatile uint32_t symbolTableVersion = 0; // Incremented when a reload or an addition changes the symbol table.
+ConfigDigest parametersDigest;            // Sections of parameters.json as last applied.
+size_t parametersFileSize = 0;
+time_t parametersFileTime = 0;
+std::vector<SymbolData> watchlistAdditions; // Picked in the browser, not yet in the symbol table.
+
 const char *parametersFilePath = "/parameters.json";
-const float peRatioNA = 0.0;
+const char *parametersUploadFilePath = "/parameters.upload";
+const char *watchlistFilePath = "/watchlist.txt"; // Symbols added on the device, one per line.
+const char *symbolIndexFilePath = "/symbols.idx";
+const char *responseSpoolPath = "/response.tmp"; // Body of the response being parsed, see ResponseSpool.
+const size_t maxResponseLength = 64 * 1024;      // Longer quote responses are dropped.
+const size_t maxErrorBodyLength = 1024;
+const unsigned long minFetchIntervalMs = 10000;
+const unsigned long fetchAbortGraceMs = 10000;   // After cancelling, before the socket is shut down.
+const unsigned long fetchRecycleGraceMs = 20000; // After cancelling, before a task still blocked on the network is replaced.
+const BackoffPolicy bootBackoff = {30000, 30 * 60000}; // Milliseconds.
+const BackoffPolicy streamBackoff = {1000, 60000};     // Milliseconds.
+const BackoffPolicy symbolBackoff = {60, 3600};               // Seconds, symbols missing from a response.
+const BackoffPolicy unknownSymbolBackoff = {3600, 24 * 3600}; // Seconds, delisted or mistyped symbols.
+const int32_t peRatioNA = 0;
 bool isMarketHoliday = false;
 
 ///////////////////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////////////////
 
+// Shows a boot error, then restarts to try again. Restarts are spaced by a backoff
+// so a card that is being swapped or a file being fixed gets a fresh attempt soon.
 void Error(ErrorIDs errorId)
 {
-  const int yLine1 = 20;
-  const int yLine2 = 90;
-  const int yLine3 = 130;
-  const int yLine4 = 170;
+  const int yLine1 = screen.Y(20);
+  const int yLine2 = screen.Y(90);
+  const int yLine3 = screen.Y(130);
+  const int yLine4 = screen.Y(170);
+  const int yLine5 = screen.Y(212);
 
   tft.fillScreen(TFT_BLACK);
-  tft.setTextSize(4);
+  tft.setTextSize(screen.Text(4));
   tft.setTextDatum(TL_DATUM);
   tft.setTextColor(TFT_RED, TFT_BLACK);
   tft.drawString("ERROR!", 30, yLine1);
@@ -104,17 +187,25 @@ void Error(ErrorIDs errorId)
     tft.drawString("Uknown", 30, yLine2);
     tft.drawString("API provider.", 30, yLine3);
   }
-  else if (errorId == ErrorIDs::InvalidApiKey)
+
+  if (esp_reset_reason() != ESP_RST_SW)
   {
-    tft.drawString("Invalid", 30, yLine2);
-    tft.drawString("API key.", 30, yLine3);
+    bootFailures = 0; // Not our restart, the RTC memory is undefined.
   }
+  bootFailures = min(bootFailures + 1, 16);
+  uint32_t retryMs = BackoffDelay(bootBackoff, bootFailures);
 
-  while (1)
-    ;
+  char buf[32];
+  sprintf(buf, "Retry in %u s.", retryMs / 1000);
+  tft.setTextSize(screen.Text(2));
+  tft.drawString(buf, 30, yLine5);
+  LOG_ERROR("SYSTEM: Boot failed, restarting in %u ms.", retryMs);
+
+  delay(retryMs);
+  ESP.restart();
 }
 
-auto sortByAbsFloat = [](float i, float j) {
+auto sortByAbsFixed = [](int32_t i, int32_t j) {
   return abs(i) < abs(j);
 };
 
@@ -128,11 +219,26 @@ void ProcessMatrix()
                        : parameters.matrix.brightnessMin;
   if (previousBrightness != brightness)
   {
-    Serial.printf("DISPLAY: matrix brightness changed from %u to %u.\n", previousBrightness, brightness);
+    LOG_INFO("DISPLAY: matrix brightness changed from %u to %u.", previousBrightness, brightness);
     previousBrightness = brightness;
     matrix.setBrightness(brightness);
   }
 
+  // A fired alert flashes the whole matrix, the pattern resumes after it.
+  if (alertShowing)
+  {
+    static unsigned long flashStart = 0;
+    static bool flashOn = false;
+    if (millis() - flashStart > 250)
+    {
+      flashStart = millis();
+      flashOn = !flashOn;
+      matrix.fill(flashOn ? (AlertRise(shownAlert) ? NeoGreen : NeoRed) : NeoOff);
+      matrix.show();
+    }
+    return;
+  }
+
   // Update pattern.
   static unsigned long start = millis();
   int delay = 1000;
@@ -151,13 +257,13 @@ void ProcessMatrix()
 
     if (pattern.equalsIgnoreCase("TOP16"))
     {
-      // Order change price data by magnitude.
-      std::vector<float> changes;
+      // Order change price data by magnitude, on a common scale.
+      std::vector<int32_t> changes;
       for (auto &symbolData : parameters.symbolData)
       {
-        changes.push_back(symbolData.change);
+        changes.push_back(FixedRescale(symbolData.change, symbolData.decimals, fixedSubDollarDecimals));
       }
-      sort(changes.begin(), changes.end(), sortByAbsFloat);
+      sort(changes.begin(), changes.end(), sortByAbsFixed);
 
       for (int i = 0; i < matrix.numPixels() && i < changes.size(); i++)
       {
@@ -203,111 +309,127 @@ bool InitSDCard()
 {
   int count = 0;
 
-  Serial.println("SD: Attempting to mount SD card...");
+  LOG_INFO("SD: Attempting to mount SD card...");
 
   while (!SD.begin(PIN_SD_CHIP_SELECT))
   {
     if (++count > 5)
     {
-      Serial.println("SD: Card Mount Failed.");
+      LOG_ERROR("SD: Card Mount Failed.");
       return false;
     }
     delay(250);
   }
 
-  Serial.println("SD: SD card mounted.");
+  LOG_INFO("SD: SD card mounted.");
   return true;
 }
 
 bool GetParametersFromSDCard()
 {
+  SdLock lock;
   File file = SD.open(parametersFilePath);
 
-  Serial.printf("SD: Attempting to fetch parameters from %s...\n", parametersFilePath);
+  LOG_INFO("SD: Attempting to fetch parameters from %s...", parametersFilePath);
 
   if (!file)
   {
-    Serial.printf("SD: Failed to open file: %s\n", parametersFilePath);
+    LOG_ERROR("SD: Failed to open file: %s", parametersFilePath);
     file.close();
     return false;
   }
 
-  DynamicJsonDocument doc(2048);
-  DeserializationError error = deserializeJson(doc, file.readString());
+  bool loaded = LoadParameters(file, &parameters, &sys.time, &parametersDigest);
+  parametersFileSize = file.size();
+  parametersFileTime = file.getLastWrite();
+  file.close();
+  return loaded;
+}
 
-  if (error)
+// Keys and passwords are masked in every log line, those of a reload join the ones already registered.
+void AddLogSecrets(const Parameters &loaded)
+{
+  for (auto &providerParameters : loaded.api.providers)
   {
-    Serial.print(F("DeserializeJson() failed: "));
-    Serial.println(error.c_str());
-    return false;
+    LogAddSecret(providerParameters.key.c_str());
+    LogAddSecret(providerParameters.sandboxKey.c_str());
   }
-
-  // TODO: check for valid parameters.json file.
-  // Check if expected parameters exist, if not alert user, and provide default file example.
-
-  for (int i = 0; i < doc["symbols"].size(); i++)
+  for (auto &wifiCredentials : loaded.wifiCredentials)
   {
-    SymbolData sData;
-    sData.symbol = doc["symbols"][i].as<String>();
-    parameters.symbolData.push_back(sData);
+    LogAddSecret(wifiCredentials.password.c_str());
   }
+}
 
-  for (int i = 0; i < doc["wifiCredentials"].size(); i++)
+// Appends the symbols added on the device to those from parameters.json.
+void LoadWatchlistAdditions(std::vector<SymbolData> *symbolTable)
+{
+  SdLock lock;
+  File file = SD.open(watchlistFilePath, FILE_READ);
+  if (!file)
   {
-    WifiCredentials wC;
-    wC.ssid = doc["wifiCredentials"][i]["ssid"].as<String>();
-    wC.password = doc["wifiCredentials"][i]["password"].as<String>();
-    parameters.wifiCredentials.push_back(wC);
+    return;
   }
 
-  String apiMode = doc["api"]["mode"].as<String>();
-  parameters.api.provider = doc["api"]["provider"].as<String>();
-  parameters.api.key = doc["api"]["key"].as<String>();
-  parameters.api.maxRequestsPerDay = doc["api"]["maxRequestsPerDay"].as<int>();
-  parameters.api.sandboxKey = doc["api"]["sandboxKey"].as<String>();
-  parameters.api.sandboxMaxRequestsPerDay = doc["api"]["sandboxMaxRequestsPerDay"].as<int>();
-
-  parameters.market.fetchPreMarketData = doc["market"]["fetchPreMarketData"].as<bool>();
-  parameters.market.fetchMarketData = doc["market"]["fetchMarketData"].as<bool>();
-  parameters.market.fetchAfterMarketData = doc["market"]["fetchAfterMarketData"].as<bool>();
-
-  parameters.display.nextSymbolDelay = doc["display"]["nextSymbolDelay"].as<int>();
-  parameters.display.brightnessMax = doc["display"]["brightnessMax"].as<int>();
-  parameters.display.brightnessMin = doc["display"]["brightnessMin"].as<int>();
-  sys.time.displayMaxBrightnessTimeRange.SetTimeRangeFromString(doc["display"]["maxBrightnessHours"].as<String>());
-
-  parameters.matrix.holidayPattern = doc["matrix"]["holidayPattern"].as<String>();
-  parameters.matrix.weekendPattern = doc["matrix"]["weekendPattern"].as<String>();
-  parameters.matrix.preMarketPattern = doc["matrix"]["preMarketPattern"].as<String>();
-  parameters.matrix.marketPattern = doc["matrix"]["marketPattern"].as<String>();
-  parameters.matrix.afterMarketPattern = doc["matrix"]["afterMarketPattern"].as<String>();
-  parameters.matrix.closedPattern = doc["matrix"]["closedPattern"].as<String>();
-  parameters.matrix.brightnessMax = doc["matrix"]["brightnessMax"].as<int>();
-  parameters.matrix.brightnessMin = doc["matrix"]["brightnessMin"].as<int>();
-  sys.time.matrixMaxBrightnessTimeRange.SetTimeRangeFromString(doc["matrix"]["maxBrightnessHours"].as<String>());
-
-  sys.time.timeZone = doc["system"]["timeZone"].as<String>();
+  while (file.available())
+  {
+    String symbol = file.readStringUntil('\n');
+    symbol.trim();
+    bool listed = symbol.length() == 0;
+    for (auto &symbolData : *symbolTable)
+    {
+      listed = listed || symbolData.symbol.equalsIgnoreCase(symbol);
+    }
+    if (!listed)
+    {
+      SymbolData sData;
+      sData.symbol = symbol;
+      symbolTable->push_back(sData);
+    }
+  }
+  file.close();
+}
 
-  // Conform parameters into acceptable ranges.
+// Picked in the symbol browser. The symbol is listed by ProcessWatchlistAdditions, through the same
+// table swap as a reload, so the fetch, stream and peer tasks and the display all follow.
+const char *AddWatchlistSymbol(const SymbolRecord &record)
+{
+  {
+    SymbolLock lock;
+    for (auto &symbolData : parameters.symbolData)
+    {
+      if (symbolData.symbol.equalsIgnoreCase(record.symbol))
+      {
+        return "Listed";
+      }
+    }
+  }
+  for (auto &symbolData : watchlistAdditions)
+  {
+    if (symbolData.symbol.equalsIgnoreCase(record.symbol))
+    {
+      return "Listed";
+    }
+  }
 
-  parameters.api.mode =
-      apiMode.equalsIgnoreCase("DEMO")      ? ApiMode::Demo
-      : apiMode.equalsIgnoreCase("SANDBOX") ? ApiMode::Sandbox
-      : apiMode.equalsIgnoreCase("LIVE")    ? ApiMode::Live
-                                            : ApiMode::Unknown;
+  SymbolData sData;
+  sData.symbol = record.symbol;
+  sData.companyName.concat(record.name, strnlen(record.name, sizeof(record.name)));
+  watchlistAdditions.push_back(sData);
 
-  if (parameters.display.nextSymbolDelay < 1)
+  SdLock lock;
+  File file = SD.open(watchlistFilePath, FILE_APPEND);
+  if (file)
   {
-    parameters.display.nextSymbolDelay = 1;
+    file.println(record.symbol);
+    file.close();
   }
-
-  file.close();
-  return true;
+  LOG_INFO("WATCHLIST: Added %s.", record.symbol);
+  return "Added";
 }
 
 void DisplayIndicator(String string, int x, int y, uint16_t color)
 {
-  tft.setTextSize(2);
+  tft.setTextSize(indicatorLayout.textSize);
   tft.setTextDatum(TC_DATUM);
   tft.setTextColor(TFT_BLACK, color);
   int padding = tft.textWidth(string);
@@ -320,7 +442,7 @@ void DisplayIndicator(String string, int x, int y, uint16_t color)
 void ProcessIndicators(bool forceUpdate = false)
 {
   char buf[12];
-  int y = 217;
+  int y = indicatorLayout.y;
   static Status previousStatus;
   if (previousStatus != status || forceUpdate)
   {
@@ -328,28 +450,92 @@ void ProcessIndicators(bool forceUpdate = false)
 
     sprintf(buf, "%02u:%02u", sys.time.currentTimeInfo.tm_hour, sys.time.currentTimeInfo.tm_min);
 
-    DisplayIndicator("SD", 25, y, status.sd ? TFT_GREEN : TFT_RED);
-    DisplayIndicator("WIFI", 75, y, status.wifi ? TFT_GREEN : TFT_RED);
-    DisplayIndicator("API", 130, y, status.api ? TFT_GREEN : TFT_RED);
-    DisplayIndicator("L", 165, y, status.symbolLocked ? TFT_BLUE : 0x0001);
-    DisplayIndicator("R", 190, y, status.requestInProgess ? TFT_BLUE : 0x0001);
-    DisplayIndicator(String(buf), 275, y, status.time ? TFT_GREEN : TFT_RED);
+    DisplayIndicator("SD", indicatorLayout.sdX, y, status.sd ? TFT_GREEN : TFT_RED);
+    DisplayIndicator("WIFI", indicatorLayout.wifiX, y, status.wifi ? TFT_GREEN : TFT_RED);
+    DisplayIndicator("API", indicatorLayout.apiX, y, status.api ? TFT_GREEN : TFT_RED);
+    DisplayIndicator("L", indicatorLayout.lockX, y, status.symbolLocked ? TFT_BLUE : 0x0001);
+    DisplayIndicator("R", indicatorLayout.requestX, y, status.requestInProgess ? TFT_BLUE : 0x0001);
+    DisplayIndicator(String(buf), indicatorLayout.timeX, y, status.time ? TFT_GREEN : TFT_RED);
+  }
+}
+
+// Strip between the symbol row and the price, cleared by an empty text.
+void DisplayBanner(const String &text, uint16_t color)
+{
+  if (text.length() == 0)
+  {
+    tft.fillRect(1, frameLayout.centerTop, screen.width - 2, frameLayout.bannerHeight, TFT_BLACK);
+    return;
+  }
+
+  tft.fillRect(1, frameLayout.centerTop, screen.width - 2, frameLayout.bannerHeight, color);
+  tft.setTextSize(frameLayout.bannerTextSize);
+  tft.setTextDatum(MC_DATUM);
+  tft.setTextColor(TFT_BLACK, color);
+  tft.setTextPadding(0);
+  tft.drawString(text, screen.width / 2, frameLayout.centerTop + frameLayout.bannerHeight / 2);
+}
+
+// Shown while quotes are stale.
+void DisplayFaultBanner(FetchResult fault)
+{
+  DisplayBanner(fault == FetchResult::Ok ? String("") : String("Cached - ") + fetchResultText[int(fault)], TFT_ORANGE);
+}
+
+// Log the alerts fired by the ingesting tasks, the latest one takes the banner and the matrix.
+void ProcessAlerts()
+{
+  AlertEvent event;
+  while (xQueueReceive(alertQueue, &event, 0) == pdTRUE)
+  {
+    String text = AlertText(event);
+    LOG_INFO("ALERT: %s", text.c_str());
+
+    if (parameters.alerts.logFile.length() > 0)
+    {
+      char stamp[24];
+      time_t epoch = event.epoch;
+      strftime(stamp, sizeof(stamp), "%Y-%m-%d %H:%M:%S", localtime(&epoch));
+
+      SdLock lock;
+      File file = SD.open(parameters.alerts.logFile, FILE_APPEND);
+      if (file)
+      {
+        file.printf("%s %s\n", stamp, text.c_str());
+        file.close();
+      }
+      else
+      {
+        LOG_RATE_LIMITED(LOG_LEVEL_WARN, 60000, "ALERT: Failed to open %s", parameters.alerts.logFile.c_str());
+      }
+    }
+
+    shownAlert = event;
+    alertShowing = true;
+    alertStart = millis();
+    alertVersion++;
+  }
+
+  if (alertShowing && millis() - alertStart >= parameters.alerts.flashSeconds * 1000UL)
+  {
+    alertShowing = false;
+    alertVersion++;
   }
 }
 
 void DisplayLayout()
 {
   // Frame.
-  tft.drawRect(0, 0, tft.width(), tft.height(), TFT_WHITE);
-  tft.drawFastHLine(0, 35, tft.width(), TFT_WHITE);
-  tft.drawFastHLine(0, 205, tft.width(), TFT_WHITE);
-  tft.drawFastVLine(100, 0, 35, TFT_WHITE);
+  tft.drawRect(0, 0, screen.width, screen.height, TFT_WHITE);
+  tft.drawFastHLine(0, frameLayout.titleHeight, screen.width, TFT_WHITE);
+  tft.drawFastHLine(0, frameLayout.footerTop, screen.width, TFT_WHITE);
+  tft.drawFastVLine(frameLayout.symbolBoxWidth, 0, frameLayout.titleHeight, TFT_WHITE);
 }
 
 void DisplayBlank()
 {
-  tft.fillRect(101, 2, tft.height() - 102, 32, TFT_BLACK);        // Name area.
-  tft.fillRect(1, 36, tft.height() - 2, 205 - 36 - 1, TFT_BLACK); // Center area
+  tft.fillRect(frameLayout.symbolBoxWidth + 1, 2, screen.width - frameLayout.symbolBoxWidth - 2, frameLayout.titleHeight - 3, TFT_BLACK); // Name area.
+  tft.fillRect(1, frameLayout.centerTop, screen.width - 2, frameLayout.centerHeight, TFT_BLACK);                                            // Center area
 }
 
 void DisplayStockData(SymbolData symbolData)
@@ -358,83 +544,106 @@ void DisplayStockData(SymbolData symbolData)
   tft.setTextFont(0);
 
   // Symbol.
-  tft.setTextSize(3);
+  tft.setTextSize(quoteLayout.symbolTextSize);
   tft.setTextDatum(TC_DATUM);
   tft.setTextColor(TFT_WHITE, TFT_BLACK);
   tft.setTextPadding(tft.textWidth("12345"));
-  tft.drawString(symbolData.symbol, 52, 7);
+  tft.drawString(symbolData.symbol, quoteLayout.symbolX, quoteLayout.symbolY);
 
   if (symbolData.isValid)
   {
     // Company name.
-    tft.setTextSize(2);
+    tft.setTextSize(quoteLayout.nameTextSize);
     tft.setTextDatum(TL_DATUM);
     String name = symbolData.companyName;
-    if (symbolData.companyName.length() > 16)
+    if (symbolData.companyName.length() > (unsigned int)quoteLayout.nameChars)
     {
-      tft.drawString(symbolData.companyName.substring(0, 15), 115, 12);
-      tft.drawPixel(297, 25, TFT_WHITE);
-      tft.drawPixel(300, 25, TFT_WHITE);
-      tft.drawPixel(303, 25, TFT_WHITE);
+      tft.drawString(symbolData.companyName.substring(0, quoteLayout.nameChars - 1), quoteLayout.nameX, quoteLayout.nameY);
+      int dotX = quoteLayout.nameX + GlyphWidth(quoteLayout.nameTextSize) * (quoteLayout.nameChars - 1) + 2;
+      int dotY = quoteLayout.nameY + GlyphHeight(quoteLayout.nameTextSize) - 3;
+      tft.drawPixel(dotX, dotY, TFT_WHITE);
+      tft.drawPixel(dotX + 3, dotY, TFT_WHITE);
+      tft.drawPixel(dotX + 6, dotY, TFT_WHITE);
     }
     else
     {
-      tft.setTextPadding(tft.textWidth("12345678901234567"));
-      tft.drawString(symbolData.companyName, 115, 12);
+      tft.setTextPadding(GlyphWidth(quoteLayout.nameTextSize) * quoteLayout.nameChars); // Up to the logo.
+      tft.drawString(symbolData.companyName, quoteLayout.nameX, quoteLayout.nameY);
+    }
+
+    // Logo, from RAM or one read of its pixels on the card.
+    if (!logoCache.Draw(symbolData.symbol, quoteLayout.logoX, quoteLayout.logoY))
+    {
+      tft.fillRect(quoteLayout.logoX, quoteLayout.logoY, quoteLayout.logoSize, quoteLayout.logoSize, TFT_BLACK);
     }
     //////////////////////////////////////////////////////
 
     // Price.
     //////////////////////////////////////////////////////
-    tft.setTextSize(6);
+    tft.setTextSize(quoteLayout.priceTextSize);
     tft.setTextDatum(TC_DATUM);
 
+    uint16_t priceColor = TFT_WHITE;
     if (marketState == MarketState::Holiday || marketState == MarketState::Weekend)
     {
-      tft.setTextColor(TFT_MAGENTA, TFT_BLACK);
+      priceColor = TFT_MAGENTA;
     }
     else if (symbolData.change < 0)
     {
-      tft.setTextColor(TFT_RED, TFT_BLACK);
+      priceColor = TFT_RED;
     }
     else if (symbolData.change > 0)
     {
-      tft.setTextColor(TFT_GREEN, TFT_BLACK);
+      priceColor = TFT_GREEN;
     }
+    tft.setTextColor(priceColor, TFT_BLACK);
     tft.setTextPadding(tft.textWidth("12345.78"));
 
-    sprintf(buf, "%4.2f", symbolData.currentPrice);
-    tft.drawString(buf, tft.height() / 2, 55);
+    FormatFixed(buf, sizeof(buf), symbolData.currentPrice, symbolData.decimals, symbolData.decimals, parameters.display.thousandsSeparator);
+    if (priceFont.Enabled())
+    {
+      priceFont.Draw(buf, screen.width / 2, quoteLayout.priceY, TC_DATUM, priceColor, TFT_BLACK, tft.textWidth("12345.78"));
+    }
+    else
+    {
+      tft.drawString(buf, screen.width / 2, quoteLayout.priceY);
+    }
 
     // Change.
-    tft.setTextSize(3);
+    tft.setTextSize(quoteLayout.changeTextSize);
     tft.setTextPadding(tft.textWidth("123.56"));
-    sprintf(buf, "%1.2f", symbolData.change);
-    tft.drawString(buf, 90, 113);
+    FormatFixed(buf, sizeof(buf), symbolData.change, symbolData.decimals, symbolData.decimals);
+    tft.drawString(buf, quoteLayout.changeX, quoteLayout.changeY);
 
     tft.setTextPadding(tft.textWidth("-2345.67"));
-    sprintf(buf, "%3.2f%%", symbolData.changePercent * 100);
-    tft.drawString(buf, tft.height() - 90, 113);
+    size_t length = FormatFixed(buf, sizeof(buf) - 1, symbolData.changePercent, 2, 2);
+    buf[length] = '%';
+    buf[length + 1] = 0;
+    tft.drawString(buf, quoteLayout.percentX, quoteLayout.changeY);
     //////////////////////////////////////////////////////
 
     // 52 week
     //////////////////////////////////////////////////////
-    static int x52 = 20;
-    int y = 143;
-    tft.fillRect(x52, y, 5, 10, TFT_BLACK);
-    x52 = mapFloat(symbolData.currentPrice, symbolData.week52Low, symbolData.week52High, 20, tft.height() - 20);
-    tft.drawLine(20, y + 5, tft.height() - 20, y + 5, TFT_YELLOW);
-    tft.fillRect(x52, y, 5, 10, TFT_YELLOW);
+    const int left = quoteLayout.rangeMargin;
+    const int right = screen.width - quoteLayout.rangeMargin;
+    const int markerWidth = quoteLayout.rangeMarkerWidth;
+    const int markerHeight = quoteLayout.rangeMarkerHeight;
+    static int x52 = left;
+    int y = quoteLayout.rangeY;
+    tft.fillRect(x52, y, markerWidth, markerHeight, TFT_BLACK);
+    x52 = mapFixed(symbolData.currentPrice, symbolData.week52Low, symbolData.week52High, left, right);
+    tft.drawLine(left, y + markerHeight / 2, right, y + markerHeight / 2, TFT_YELLOW);
+    tft.fillRect(x52, y, markerWidth, markerHeight, TFT_YELLOW);
     //////////////////////////////////////////////////////
 
     // Extra data.
     //////////////////////////////////////////////////////
 
-    tft.setTextSize(2);
+    tft.setTextSize(quoteLayout.labelTextSize);
     tft.setTextColor(TFT_BLUE, TFT_BLACK);
     tft.setTextPadding(0);
-    tft.drawString("Update", 260, 160);
-    tft.drawString("P/E", 50, 160);
+    tft.drawString("Update", quoteLayout.updateX, quoteLayout.labelY);
+    tft.drawString("P/E", quoteLayout.peX, quoteLayout.labelY);
 
     // PE.
     if (symbolData.peRatio == peRatioNA)
@@ -443,10 +652,10 @@ void DisplayStockData(SymbolData symbolData)
     }
     else
     {
-      sprintf(buf, "%3.2f", symbolData.peRatio);
+      FormatFixed(buf, sizeof(buf), symbolData.peRatio, 2, 2);
     }
     tft.setTextPadding(tft.textWidth("-123.56"));
-    tft.drawString(buf, 50, 182);
+    tft.drawString(buf, quoteLayout.peX, quoteLayout.valueY);
 
     // Market state.
     tft.setTextPadding(tft.textWidth("Weekend"));
@@ -454,301 +663,216 @@ void DisplayStockData(SymbolData symbolData)
     if (previousMarketState != marketState)
     {
       previousMarketState = marketState;
-      tft.fillRect(90, 158, 120, 44, TFT_BLACK);  
+      tft.fillRect(quoteLayout.stateX - quoteLayout.stateClearWidth / 2, quoteLayout.labelY - 2,
+                   quoteLayout.stateClearWidth, quoteLayout.valueY + GlyphHeight(quoteLayout.labelTextSize) + 4 - (quoteLayout.labelY - 2), TFT_BLACK);
     }
     if (marketStateDesciptionBottom[int(marketState)][0] != 0)
     {
-      tft.drawString(marketStateDesciptionTop[int(marketState)], 150, 160);
-      tft.drawString(marketStateDesciptionBottom[int(marketState)], 150, 182);
+      tft.drawString(marketStateDesciptionTop[int(marketState)], quoteLayout.stateX, quoteLayout.labelY);
+      tft.drawString(marketStateDesciptionBottom[int(marketState)], quoteLayout.stateX, quoteLayout.valueY);
     }
     else
     {
-      tft.drawString(marketStateDesciptionTop[int(marketState)], 150, 171);
+      tft.drawString(marketStateDesciptionTop[int(marketState)], quoteLayout.stateX, quoteLayout.stateY);
     }
 
     // Update.
     tft.setTextPadding(0);
     time_t rawtime(symbolData.latestUpdate);
     sprintf(buf, "%02u:%02u", localtime(&rawtime)->tm_hour, localtime(&rawtime)->tm_min);
-    tft.drawString(buf, 260, 182);
+    tft.drawString(buf, quoteLayout.updateX, quoteLayout.valueY);
     //////////////////////////////////////////////////////
   }
   else
   {
     // Error message.
     DisplayBlank();
-    tft.setTextSize(3);
+    tft.setTextSize(quoteLayout.changeTextSize);
     tft.setTextDatum(TC_DATUM);
     tft.setTextColor(TFT_RED, TFT_BLACK);
-    tft.drawString("Invalid Symbol", tft.height() / 2, 65);
+    tft.drawString("Invalid Symbol", screen.width / 2, quoteLayout.messageY);
   }
 }
 
-bool GetSymbolDataFromApiIEXCLOUD(SymbolData *symbolData)
+// Logs the time to draw a price with the font atlas and with the scaled built in font.
+void BenchmarkPriceFont()
 {
-  String payload;
-  String host;
+  const char *sample = "12345.78";
+  const int runs = 10;
 
-  // API documentation: https://iexcloud.io/docs/api/#quote
-  if (parameters.api.mode == ApiMode::Live)
-  {
-    host = "https://cloud.iexapis.com/stable/stock/" + symbolData->symbol + "/quote?token=" + parameters.api.key;
-  }
-  else if (parameters.api.mode == ApiMode::Sandbox)
+  tft.setTextSize(quoteLayout.priceTextSize);
+  tft.setTextDatum(TC_DATUM);
+  tft.setTextColor(TFT_GREEN, TFT_BLACK);
+  tft.setTextPadding(0);
+  unsigned long start = micros();
+  for (int i = 0; i < runs; i++)
   {
-    host = "https://sandbox.iexapis.com/stable/stock/" + symbolData->symbol + "/quote?token=" + parameters.api.sandboxKey;
+    tft.drawString(sample, screen.width / 2, quoteLayout.priceY);
   }
-  else
+  unsigned long builtIn = (micros() - start) / runs;
+
+  start = micros();
+  for (int i = 0; i < runs; i++)
   {
-    return false;
+    priceFont.Draw(sample, screen.width / 2, quoteLayout.priceY, TC_DATUM, TFT_GREEN, TFT_BLACK);
   }
+  unsigned long atlas = (micros() - start) / runs;
 
-  symbolData->lastApiCall = sys.time.currentEpoch;
-
-  Serial.print("API: Connecting to ");
-  Serial.println(host);
+  DisplayBlank();
+  LOG_INFO("FONT: Price draw, atlas %lu us, built in font %lu us.", atlas, builtIn);
+}
 
-  HTTPClient http;
-  http.begin(host);
-  int httpCode = http.GET();
+// Single entry point for quotes from every source.
+void IngestQuote(SymbolData *symbolData, const Quote &quote)
+{
+  SymbolLock lock;
+  const uint16_t fields = quote.fields;
 
-  Serial.printf("WIFI: HTTP code: %i\n", httpCode);
+  // Fields the quote does not carry move to its price scale.
+  if (symbolData->decimals != quote.decimals)
+  {
+    symbolData->openPrice = FixedRescale(symbolData->openPrice, symbolData->decimals, quote.decimals);
+    symbolData->currentPrice = FixedRescale(symbolData->currentPrice, symbolData->decimals, quote.decimals);
+    symbolData->change = FixedRescale(symbolData->change, symbolData->decimals, quote.decimals);
+    symbolData->week52High = FixedRescale(symbolData->week52High, symbolData->decimals, quote.decimals);
+    symbolData->week52Low = FixedRescale(symbolData->week52Low, symbolData->decimals, quote.decimals);
+    symbolData->decimals = quote.decimals;
+  }
 
-  if (httpCode > 0)
+  if ((fields & QuoteFieldCompanyName) && quote.companyName.length() > 0)
+    symbolData->companyName = quote.companyName;
+  if (fields & QuoteFieldPreviousClose)
+    symbolData->openPrice = quote.openPrice;
+  if (fields & QuoteFieldLatestPrice)
+    symbolData->currentPrice = quote.currentPrice;
+  if (fields & QuoteFieldChange)
+    symbolData->change = quote.change;
+  if (fields & QuoteFieldChangePercent)
+    symbolData->changePercent = quote.changePercent;
+  if (fields & QuoteFieldPeRatio)
+    symbolData->peRatio = quote.peRatio;
+  if (fields & QuoteFieldWeek52High)
+    symbolData->week52High = quote.week52High;
+  if (fields & QuoteFieldWeek52Low)
+    symbolData->week52Low = quote.week52Low;
+  if (fields & QuoteFieldLatestUpdate)
+    symbolData->latestUpdate = quote.latestUpdate;
+  symbolData->errorString = "";
+  symbolData->isValid = true;
+  symbolData->fetchFailures = 0;
+  symbolData->retryAfter = 0;
+  symbolData->version++;
+  quoteGeneration++;
+
+  if (fields & QuoteFieldLatestPrice)
   {
-    payload = http.getString();
-    Serial.println("API: [RESPONSE]");
-    Serial.println(payload);
-    http.end();
+    quoteHistory.Add(symbolData - parameters.symbolData.data(), time(NULL), quote.currentPrice, quote.decimals);
+  }
 
-    if (httpCode != 200)
+  // Constant work per quote, the rules were compiled into the symbol's slots.
+  uint8_t fired = parameters.alerts.enabled ? EvaluateAlerts(symbolData, lroundf(parameters.alerts.hysteresisPercent * 100)) : 0;
+  for (size_t kind = 0; fired != 0; kind++, fired >>= 1)
+  {
+    if (fired & 1)
     {
-      // Check for endpoint error messages.
-      if (payload.equalsIgnoreCase("Unknown symbol"))
-      {
-        Serial.println("API: Error from endpoint: Unknown symbol");
-        symbolData->errorString = "Unknown symbol";
-        symbolData->isValid = false;
-        return false;
-      }
-      else if (payload.equalsIgnoreCase("Forbidden"))
-      {
-        Serial.println("API: Error from endpoint: Forbidden");
-        symbolData->errorString = "Forbidden";
-        return false;
-      }
-      else if (payload.equalsIgnoreCase("The API key provided is not valid."))
-      {
-        Serial.println("API: Error from endpoint: The API key provided is not valid.");
-        symbolData->errorString = "The API key provided is not valid.";
-        Error(ErrorIDs::InvalidApiKey);
-        return false;
-      }
-
-      // TODO: report more error codes. https://iexcloud.io/docs/api/#error-codes
-      return false;
+      AlertEvent event;
+      MakeAlertEvent(*symbolData, AlertKind(kind), time(NULL), &event);
+      xQueueSend(alertQueue, &event, 0);
     }
   }
-  else
-  {
-    Serial.print("WIFI: Connection failed, HTTP client code: ");
-    Serial.println(httpCode);
-    symbolData->errorString = String(httpCode);
-    http.end();
-    return false;
-  }
+}
 
-  DynamicJsonDocument doc(2048);
-  DeserializationError jsonError = deserializeJson(doc, payload);
+void SetSymbolError(SymbolData *symbolData, const String &errorString, bool isValid = true)
+{
+  SymbolLock lock;
 
-  if (jsonError)
+  symbolData->errorString = errorString;
+  if (!isValid)
   {
-    Serial.print(F("JSON: DeserializeJson() failed: "));
-    Serial.println(jsonError.c_str());
-    symbolData->errorString = "JSON: jsonError.c_str()";
-    return false;
+    symbolData->isValid = false;
   }
+  symbolData->version++;
+  quoteGeneration++;
+}
 
-  symbolData->currentPrice = doc["latestPrice"].as<float>();
-  symbolData->companyName = doc["companyName"].as<String>();
-  symbolData->openPrice = doc["previousClose"].as<float>();
-  symbolData->change = doc["change"].as<float>();
-  symbolData->changePercent = doc["changePercent"].as<float>();
-  symbolData->week52High = doc["week52High"].as<float>();
-  symbolData->week52High = doc["week52High"].as<float>();
-  symbolData->week52Low = doc["week52Low"].as<float>();
-  symbolData->latestUpdate = doc["latestUpdate"].as<long long>() / 1000; // convert milliseconds to seconds
+// Keeps a symbol the provider could not quote out of requests for a while, longer each time.
+void BackOffSymbol(SymbolData *symbolData, const BackoffPolicy &policy)
+{
+  SymbolLock lock;
 
-  if (doc["peRatio"].is<float>())
-  {
-    symbolData->peRatio = doc["peRatio"].as<float>();
-  }
-  else
+  if (symbolData->fetchFailures < UINT8_MAX)
   {
-    symbolData->peRatio = peRatioNA;
+    symbolData->fetchFailures++;
   }
-
-  return true;
+  symbolData->retryAfter = sys.time.currentEpoch + BackoffDelay(policy, symbolData->fetchFailures);
 }
 
-// Executed as a RTOS task.
-void GetSymbolData(void *)
+// Quote multicast by another QuoteBot, kept only if newer than ours. index is where the
+// symbol was when the datagram arrived, a reload may have moved it since.
+void IngestPeerQuote(const PeerQuote &peerQuote, size_t index)
 {
-  static unsigned long start = millis();
-
-  if (millis() - start > sys.millisecondsBetweenApiCalls)
+  SymbolTableLock tableLock;
+  if (index >= parameters.symbolData.size() || !parameters.symbolData[index].symbol.equalsIgnoreCase(peerQuote.symbol))
   {
-    start = millis();
-
-    // Get index of symbol with oldest api call time.
-    int selectedIndex = 0;
-    for (int i = 0; i < parameters.symbolData.size(); i++)
-    {
-      if (parameters.symbolData[i].isValid)
-      {
-        if (parameters.symbolData[i].lastApiCall < parameters.symbolData[selectedIndex].lastApiCall)
-        {
-          selectedIndex = i;
-        }
-      }
-    }
-
-    if (parameters.api.mode == ApiMode::Live || parameters.api.mode == ApiMode::Sandbox)
-    {
-      if ((marketState == MarketState::PreHours && parameters.market.fetchPreMarketData) ||
-          (marketState == MarketState::MarketHours) ||
-          (marketState == MarketState::AfterHours && parameters.market.fetchAfterMarketData) ||
-          parameters.symbolData[selectedIndex].lastApiCall == 0)
-      {
-
-        Serial.printf("API: Requesting data for symbol: %s\n", parameters.symbolData[selectedIndex].symbol.c_str());
-        status.requestInProgess = true;
-
-        if (parameters.api.provider.equalsIgnoreCase("IEXCLOUD"))
-        {
-          status.api = GetSymbolDataFromApiIEXCLOUD(&parameters.symbolData[selectedIndex]);
-        }
-        else
-        {
-          Serial.printf("API: Error, unknown API provider: %s\n", parameters.api.provider.c_str());
-          Error(ErrorIDs::UnknownApi);
-        }
-
-        status.requestInProgess = false;
-      }
-    }
-    else if (parameters.api.mode == ApiMode::Demo)
+    auto found = std::find_if(parameters.symbolData.begin(), parameters.symbolData.end(),
+                              [&](const SymbolData &symbolData) { return symbolData.symbol.equalsIgnoreCase(peerQuote.symbol); });
+    if (found == parameters.symbolData.end())
     {
-      // TODO: generate random data.
+      return; // Removed from the watchlist.
     }
+    index = found - parameters.symbolData.begin();
   }
 
-  vTaskDelete(NULL);
-}
-
-// Touch screen requires calibation, orientation may be inversed.
-void ProcessTouchScreen()
-{
-  //static takeTouchReadings = true;
-  static unsigned long touchDebounceDelay = 250;
-  static unsigned long touchDebounceMillis = millis();
-  uint16_t x, y;
-
-  if (millis() - touchDebounceMillis > touchDebounceDelay)
+  SymbolData *symbolData = &parameters.symbolData[index];
   {
-    if (tft.getTouch(&x, &y, 64))
+    SymbolLock lock;
+    if (peerQuote.latestUpdate <= symbolData->latestUpdate)
     {
-      touchDebounceMillis = millis();
-
-      if (x < tft.width() / 3)
-      {
-        sys.symbolSelect++;
-        if (sys.symbolSelect > parameters.symbolData.size() - 1)
-        {
-          sys.symbolSelect = 0;
-        }
-      }
-      else if (x > (tft.width() / 3) * 2)
-      {
-        if (sys.symbolSelect != 0)
-        {
-          sys.symbolSelect--;
-        }
-        else
-        {
-          sys.symbolSelect = parameters.symbolData.size() - 1;
-        }
-      }
-      else
-      {
-        status.symbolLocked = !status.symbolLocked;
-      }
+      return;
     }
+    symbolData->lastApiCall = sys.time.currentEpoch;
   }
+  Quote quote;
+  PeerQuoteToQuote(peerQuote, &quote);
+  IngestQuote(symbolData, quote);
 }
 
-bool ConnectWifi()
+// Executed as a RTOS task on the protocol core. Takes quotes from other QuoteBots off the
+// peer queue, the wait for the symbol table happens here and not on the AsyncUDP task.
+void PeerQuotesTask(void *)
 {
-  const int yLine1 = 50;
-  const int yLine2 = 70;
-  const int yLine3 = 90;
-  const int yLine4 = 110;
-  const int yLine5 = 140;
-  const int yLine6 = 160;
-
-  char buf[128];
-  int wifiCredentialsIndex = 0;
-
   while (1)
   {
-    DisplayBlank();
-    tft.setTextSize(2);
-    tft.setTextColor(TFT_GREEN);
-    tft.setTextDatum(TL_DATUM);
-    tft.drawString("Connecting to WiFi", 10, yLine1);
-    sprintf(buf, "SSID: %s", parameters.wifiCredentials[wifiCredentialsIndex].ssid.c_str());
-    tft.drawString(buf, 10, yLine2);
-    sprintf(buf, "PWD: %s", parameters.wifiCredentials[wifiCredentialsIndex].password.c_str());
-    tft.drawString(buf, 10, yLine3);
-
-    Serial.printf("\nWIFI: Connecting to SSID: %s, with password: %s\n", parameters.wifiCredentials[wifiCredentialsIndex].ssid.c_str(), parameters.wifiCredentials[wifiCredentialsIndex].password.c_str());
-
-    WiFi.begin(parameters.wifiCredentials[wifiCredentialsIndex].ssid.c_str(), parameters.wifiCredentials[wifiCredentialsIndex].password.c_str());
-
-    tft.setCursor(10, yLine4);
-    int count = 0;
-    while (count++ < 10)
-    {
-      delay(500);
-      tft.print(".");
-      Serial.print(".");
-
-      if (WiFi.status() == WL_CONNECTED)
-      {
-        tft.drawString("Connected!", 10, yLine5);
-        sprintf(buf, "IP: %s", WiFi.localIP().toString().c_str());
-        tft.drawString(buf, 10, yLine6);
-        Serial.println("");
-        Serial.printf("WIFI: WiFi connected to %s, device IP: %s\n", parameters.wifiCredentials[wifiCredentialsIndex].ssid.c_str(), WiFi.localIP().toString().c_str());
-        delay(2000);
-        DisplayBlank();
-        return true;
-      }
-    }
-
-    wifiCredentialsIndex++;
-    if (wifiCredentialsIndex > parameters.wifiCredentials.size() - 1)
+    PeerQuote peerQuote;
+    size_t index;
+    if (peerSync.Receive(&peerQuote, &index, portMAX_DELAY))
     {
-      wifiCredentialsIndex = 0;
+      int64_t start = esp_timer_get_time();
+      IngestPeerQuote(peerQuote, index);
+      MetricsTaskBusy(peerTaskConfig.name, esp_timer_get_time() - start);
+      MetricsTaskStack(peerTaskConfig.name);
     }
   }
 }
 
+SymbolData GetSymbolSnapshot(unsigned int index)
+{
+  SymbolLock lock;
+  return parameters.symbolData.at(index);
+}
+
 void CalcMillisecondsBetweenApiFetches()
 {
   unsigned long delay = 0;
 
-  if (parameters.api.mode == ApiMode::Live)
+  // Budget of the provider in use, or the primary one before the first request.
+  QuoteProvider *provider = providerManager.Active();
+  if (provider == NULL && providerManager.Size() > 0)
+  {
+    provider = providerManager.Provider(0);
+  }
+
+  if (parameters.api.mode == ApiMode::Live && provider != NULL)
   {
     float apiSeconds = 0;
     if (parameters.market.fetchPreMarketData)
@@ -757,12 +881,12 @@ void CalcMillisecondsBetweenApiFetches()
       apiSeconds += sys.time.marketTimeRange.GetTotalSeconds();
     if (parameters.market.fetchAfterMarketData)
       apiSeconds += sys.time.afterMarketTimeRange.GetTotalSeconds();
-    delay = (apiSeconds / parameters.api.maxRequestsPerDay) * 1000;
+    delay = (apiSeconds / max(provider->MaxRequestsPerDay(), 1)) * 1000;
   }
-  else if (parameters.api.mode == ApiMode::Sandbox)
+  else if (parameters.api.mode == ApiMode::Sandbox && provider != NULL)
   {
     float apiSeconds = 24 * 60 * 60;
-    delay = (apiSeconds / parameters.api.sandboxMaxRequestsPerDay) * 1000;
+    delay = (apiSeconds / max(provider->MaxRequestsPerDay(), 1)) * 1000;
   }
   else if (parameters.api.mode == ApiMode::Demo)
   {
@@ -776,90 +900,1412 @@ void CalcMillisecondsBetweenApiFetches()
   sys.millisecondsBetweenApiCalls = delay;
 }
 
-bool ProcessTime()
+// Union of the fields read by the consumers enabled in parameters.json.
+uint16_t RequiredQuoteFields()
 {
-  static unsigned long startGetTime = millis();
-
-  if (millis() - startGetTime > 250)
+  uint16_t fields = quoteFieldsSymbolScreen | quoteFieldsMatrix | quoteFieldsChart;
+  if (parameters.localApi.enabled || parameters.peers.enabled)
   {
-    startGetTime = millis();
+    fields |= quoteFieldsShared;
+  }
+  return fields;
+}
 
-    if (!getLocalTime(&sys.time.currentTimeInfo))
+// Apply the outcome of a provider response to the symbols it covered, live or replayed.
+bool ApplyFetchResult(QuoteProvider *provider, std::vector<SymbolData *> &batch, FetchResult result, Quote *quotes, bool *found)
+{
+  if (result != FetchResult::Ok)
+  {
+    LOG_WARN("API: Error from %s: %s", provider->Name().c_str(), fetchResultText[int(result)]);
+    for (auto symbolData : batch)
     {
-      Serial.println("TIME: Failed to obtain time");
-      status.time = false;
-      return false;
+      SetSymbolError(symbolData, fetchResultText[int(result)], result != FetchResult::UnknownSymbol);
+      if (result == FetchResult::UnknownSymbol)
+      {
+        BackOffSymbol(symbolData, unknownSymbolBackoff); // Provider faults back off in the provider manager.
+      }
     }
+    return false;
+  }
 
-    status.time = true;
-
-    time(&sys.time.currentEpoch); // Fetch current time as epoch
-
-    static int previousMinute = ~sys.time.currentTimeInfo.tm_min;
-    if (previousMinute != sys.time.currentTimeInfo.tm_min)
+  for (size_t i = 0; i < batch.size(); i++)
+  {
+    if (found[i])
     {
-      previousMinute = sys.time.currentTimeInfo.tm_min;
-      ProcessIndicators(true);
+      IngestQuote(batch[i], quotes[i]);
+    }
+    else
+    {
+      LOG_WARN("API: Error from %s: Unknown symbol %s", provider->Name().c_str(), batch[i]->symbol.c_str());
+      SetSymbolError(batch[i], fetchResultText[int(FetchResult::UnknownSymbol)], false);
+      BackOffSymbol(batch[i], symbolBackoff);
     }
   }
 
   return true;
 }
 
-void ProcessMarketState()
+FetchResult FetchQuotes(QuoteProvider *provider, std::vector<SymbolData *> &batch)
 {
-  marketState = isMarketHoliday                                                                                                        ? MarketState::Holiday
-                : sys.time.currentTimeInfo.tm_wday == int(DayIds::Sunday) || sys.time.currentTimeInfo.tm_wday == int(DayIds::Saturday) ? MarketState::Weekend
-                : sys.time.preMarketTimeRange.isTimeBetweenRange(sys.time.currentTimeInfo.tm_hour, sys.time.currentTimeInfo.tm_min)    ? MarketState::PreHours
+  const size_t count = batch.size();
+  std::vector<String> symbols;
+  String symbolList;
+  std::vector<Quote> quotes(count);
+  std::unique_ptr<bool[]> found(new bool[count]());
+
+  for (auto symbolData : batch)
+  {
+    symbolData->lastApiCall = sys.time.currentEpoch;
+    symbols.push_back(symbolData->symbol);
+    symbolList += (symbolList.length() ? "," : "") + symbolData->symbol;
+  }
+
+  String url = provider->BuildUrl(symbols.data(), count);
+
+  LOG_INFO("API: Requesting data for symbol(s): %s from %s", symbolList.c_str(), provider->Name().c_str());
+  LOG_DEBUG("API: Connecting to %s", url.c_str());
+
+  // Symbols with nothing ingested since boot need a body, even when the server has nothing new.
+  bool cold = false;
+  for (auto symbolData : batch)
+  {
+    cold |= symbolData->version == 0;
+  }
+
+  // Validators from the last response for this URL, dropped when a cold batch has no cached body to fall back on.
+  const CacheSlot *cached = responseCache.Find(url);
+  StreamString cachedBody;
+  if (cached != NULL && cold && !responseCache.LoadBody(*cached, &cachedBody))
+  {
+    cached = NULL;
+  }
+
+  unsigned long start = millis();
+  FetchResult result;
+  bool unchanged = false;
+
+  // Every phase has its own deadline, a request can not take longer than their sum.
+  const HttpTimeouts &timeouts = parameters.api.timeouts;
+  bool dnsTimedOut;
+  bool resolved = ResolveHost(HostFromUrl(url).c_str(), timeouts.dns, &dnsTimedOut);
+
+  WiFiClient plainClient;
+  WatchedClientSecure secureClient;
+  bool secure = url.startsWith("https://");
+  if (secure)
+  {
+    secureClient.setInsecure();
+    secureClient.setHandshakeTimeout((timeouts.tls + 999) / 1000); // Whole seconds.
+  }
+
+  HTTPClient http;
+  http.useHTTP10(true); // No chunked transfer, the body is parsed straight off the socket.
+  http.setConnectTimeout(timeouts.connect);
+  http.setTimeout(timeouts.headers);
+  http.begin(secure ? (WiFiClient &)secureClient : plainClient, url);
+  if (cached != NULL && cached->etag[0])
+  {
+    http.addHeader("If-None-Match", cached->etag);
+  }
+  if (cached != NULL && cached->lastModified[0])
+  {
+    http.addHeader("If-Modified-Since", cached->lastModified);
+  }
+  if (parameters.api.gzip)
+  {
+    http.addHeader("Accept-Encoding", "gzip");
+  }
+  const char *responseHeaders[] = {"ETag", "Last-Modified", "Content-Encoding"};
+  http.collectHeaders(responseHeaders, 3);
+  fetchSocket.Attach(secure ? (WiFiClient &)secureClient : plainClient, secure);
+  unsigned long requestStart = millis();
+  int httpCode = HTTPC_ERROR_CONNECTION_REFUSED;
+  if (resolved && !fetchCancel)
+  {
+    WatchedCall call(&fetchSocket);
+    httpCode = http.GET();
+  }
+  unsigned long responseStart = millis();
+
+  bool timedOut = true;
+  if (dnsTimedOut)
+  {
+    MetricsCountFetchTimeout(FetchTimeout::Dns);
+  }
+  else if (httpCode == HTTPC_ERROR_CONNECTION_REFUSED && resolved && responseStart - requestStart >= (unsigned long)timeouts.connect)
+  {
+    MetricsCountFetchTimeout(FetchTimeout::Connect);
+  }
+  else if (httpCode == HTTPC_ERROR_READ_TIMEOUT)
+  {
+    MetricsCountFetchTimeout(FetchTimeout::Headers);
+  }
+  else
+  {
+    timedOut = false;
+  }
+
+  // Inflated on the fly, the parser and the cache only ever see plain JSON.
+  DeadlineStream bodyStream(http.getStream(), timeouts.body, fetchCancel, &fetchSocket);
+  GzipStream gzip(bodyStream);
+  bool compressed = httpCode == 200 && http.header("Content-Encoding").equalsIgnoreCase("gzip");
+  bool inflateFailed = compressed && !gzip.Begin();
+  Stream &body = compressed ? (Stream &)gzip : (Stream &)bodyStream;
+  auto bodyCut = [&]() { return bodyStream.Expired() || bodyStream.Cancelled(); };
+
+  LOG_DEBUG("WIFI: HTTP code: %i", httpCode);
+  MetricsCountHttpCode(httpCode);
+  MetricsObserveFetch(FetchPhase::Request, responseStart - start);
+
+  if (timedOut)
+  {
+    result = FetchResult::Timeout;
+  }
+  else if (inflateFailed)
+  {
+    result = bodyCut() ? FetchResult::Timeout : FetchResult::ParseError;
+  }
+  else if (httpCode == HTTP_CODE_NOT_MODIFIED && cached != NULL)
+  {
+    if (cachedBody.length() > 0)
+    {
+      result = provider->ParseQuotes(cachedBody, symbols.data(), count, quotes.data(), found.get()) ? FetchResult::Ok : FetchResult::ParseError;
+    }
+    else
+    {
+      unchanged = true;
+      result = FetchResult::Ok;
+    }
+  }
+  else if (httpCode == 200 && (parameters.capture.enabled || responseCache.Enabled()))
+  {
+    // Parsed off the socket, while the body is hashed and spooled to the card on the way for
+    // the capture and the cache.
+    ResponseSpool spool;
+    spool.Begin(responseSpoolPath);
+    TeeStream tee(body, spool, maxResponseLength);
+    bool parsed = provider->ParseQuotes(tee, symbols.data(), count, quotes.data(), found.get());
+    tee.Drain();
+    spool.End();
+
+    if (parameters.capture.enabled && !bodyCut() && !spool.Failed())
+    {
+      struct timeval now;
+      gettimeofday(&now, NULL);
+      SdLock lock;
+      File file = SD.open(responseSpoolPath);
+      quoteRecorder.Append(now.tv_sec, now.tv_usec / 1000, httpCode, symbolList, file, spool.Length());
+      file.close();
+    }
+
+    if (bodyCut())
+    {
+      result = FetchResult::Timeout; // Never cached or ingested, the body is incomplete.
+    }
+    else if (tee.Overflowed())
+    {
+      LOG_WARN("API: Response over %u bytes dropped.", maxResponseLength);
+      result = FetchResult::ParseError;
+    }
+    else if (gzip.Failed() || !parsed)
+    {
+      result = FetchResult::ParseError;
+    }
+    else if (!spool.Failed() && !responseCache.Store(url, http.header("ETag"), http.header("Last-Modified"), spool) && !cold)
+    {
+      // Byte identical to the last response, nothing to ingest or redraw.
+      unchanged = true;
+      result = FetchResult::Ok;
+    }
+    else
+    {
+      result = FetchResult::Ok;
+    }
+  }
+  else if (httpCode == 200)
+  {
+    result = provider->ParseQuotes(body, symbols.data(), count, quotes.data(), found.get()) ? FetchResult::Ok
+             : bodyCut()                                                                    ? FetchResult::Timeout
+                                                                                            : FetchResult::ParseError;
+  }
+  else if (httpCode > 0)
+  {
+    // Error bodies are short, a longer one is cut rather than held whole.
+    StreamString payload;
+    TeeStream tee(body, payload, maxErrorBodyLength);
+    tee.Drain();
+    result = provider->MapError(httpCode, payload);
+    if (parameters.capture.enabled && !bodyCut())
+    {
+      struct timeval now;
+      gettimeofday(&now, NULL);
+      quoteRecorder.Append(now.tv_sec, now.tv_usec / 1000, httpCode, symbolList, payload, payload.length());
+    }
+  }
+  else
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 10000, "WIFI: Connection failed, HTTP client code: %i", httpCode);
+    result = httpCode == HTTPC_ERROR_READ_TIMEOUT ? FetchResult::Timeout : FetchResult::NetworkError;
+  }
+
+  if (bodyStream.Expired())
+  {
+    MetricsCountFetchTimeout(FetchTimeout::Body);
+  }
+  if (bodyCut())
+  {
+    LOG_WARN("API: Response body %s after %lu ms.", bodyStream.Expired() ? "timed out" : "cancelled", millis() - responseStart);
+  }
+
+  http.end();
+  fetchSocket.Detach();
+  unsigned long applyStart = millis();
+  MetricsObserveFetch(FetchPhase::Parse, applyStart - responseStart);
+
+  providerManager.Report(provider, result, applyStart - start);
+  if (unchanged)
+  {
+    LOG_DEBUG("API: Response for %s unchanged.", symbolList.c_str());
+  }
+  if (!unchanged)
+  {
+    ApplyFetchResult(provider, batch, result, quotes.data(), found.get());
+  }
+
+  if (result == FetchResult::Ok)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      if (found[i])
+      {
+        peerSync.Publish(batch[i] - parameters.symbolData.data(), quotes[i]);
+      }
+    }
+  }
+
+  MetricsObserveFetch(FetchPhase::Apply, millis() - applyStart);
+  MetricsObserveFetch(FetchPhase::Total, millis() - start);
+  return result;
+}
+
+// Listed but neither requested nor streamed yet.
+bool Unquoted(const SymbolData &symbolData)
+{
+  return symbolData.version == 0 && symbolData.lastApiCall == 0;
+}
+
+// Symbols this device is responsible for and not backing off, with the oldest api call time first.
+// unquotedOnly keeps those without a quote.
+std::vector<SymbolData *> SelectOldestSymbols(size_t count, bool unquotedOnly)
+{
+  std::vector<SymbolData *> candidates;
+  for (size_t i = 0; i < parameters.symbolData.size(); i++)
+  {
+    if (parameters.symbolData[i].retryAfter <= sys.time.currentEpoch && peerSync.ShouldFetch(i) &&
+        (!unquotedOnly || Unquoted(parameters.symbolData[i])))
+    {
+      candidates.push_back(&parameters.symbolData[i]);
+    }
+  }
+
+  count = min(count, candidates.size());
+  std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(),
+                    [](SymbolData *a, SymbolData *b) { return a->lastApiCall < b->lastApiCall; });
+  candidates.resize(count);
+  return candidates;
+}
+
+// Fetch the symbols that have waited longest from the current provider, or only those without a quote.
+// Caller holds the SymbolTableLock, the batch points into the table for the whole request.
+void FetchDueSymbols(bool unquotedOnly)
+{
+  QuoteProvider *previousProvider = providerManager.Active();
+  QuoteProvider *provider = providerManager.Select(sys.time.currentTimeInfo.tm_yday);
+
+  if (provider != previousProvider)
+  {
+    // Spread requests over the new provider's budget.
+    CalcMillisecondsBetweenApiFetches();
+  }
+
+  if (provider == NULL)
+  {
+    // Nothing is requested until a cooldown expires, the cached quotes stay on screen.
+    // While streaming the indicator shows the stream.
+    if (!unquotedOnly)
+    {
+      status.api = false;
+      apiFault = providerManager.Fault();
+    }
+    const struct tm &now = sys.time.currentTimeInfo;
+    unsigned long nextDayInMs = (24 * 3600UL - (now.tm_hour * 3600UL + now.tm_min * 60UL + now.tm_sec)) * 1000UL;
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 60000, "API: No provider available (%s), retry in %lu s.", fetchResultText[int(providerManager.Fault())],
+                     providerManager.RetryInMs(nextDayInMs) / 1000);
+  }
+  else
+  {
+    // A provider on trial is asked for one symbol, a failed probe costs a single request.
+    bool probing = providerManager.Probing(provider);
+    std::vector<SymbolData *> batch = SelectOldestSymbols(probing ? 1 : provider->MaxBatchSize(), unquotedOnly);
+
+    if (batch.size() > 0 &&
+        ((marketState == MarketState::PreHours && parameters.market.fetchPreMarketData) ||
+         (marketState == MarketState::MarketHours) ||
+         (marketState == MarketState::AfterHours && parameters.market.fetchAfterMarketData) ||
+         batch[0]->lastApiCall == 0))
+    {
+      status.requestInProgess = true;
+      FetchResult result = FetchQuotes(provider, batch);
+      status.requestInProgess = false;
+      if (!unquotedOnly)
+      {
+        status.api = result == FetchResult::Ok;
+        apiFault = result == FetchResult::UnknownSymbol ? FetchResult::Ok : result;
+      }
+    }
+  }
+}
+
+// GET a small document or image into body, bounded by the api phase deadlines. Returns the HTTP code,
+// HTTPC_ERROR_TOO_LESS_RAM for a body over maxLength, HTTPC_ERROR_READ_TIMEOUT for one cut short.
+// Caller holds the SymbolTableLock, see fetchStartMs.
+int HttpGetBytes(const String &url, size_t maxLength, std::vector<uint8_t> *body)
+{
+  const HttpTimeouts &timeouts = parameters.api.timeouts;
+  bool dnsTimedOut;
+  if (!ResolveHost(HostFromUrl(url).c_str(), timeouts.dns, &dnsTimedOut))
+  {
+    return dnsTimedOut ? HTTPC_ERROR_READ_TIMEOUT : HTTPC_ERROR_CONNECTION_REFUSED;
+  }
+
+  WiFiClient plainClient;
+  WatchedClientSecure secureClient;
+  bool secure = url.startsWith("https://");
+  if (secure)
+  {
+    secureClient.setInsecure();
+    secureClient.setHandshakeTimeout((timeouts.tls + 999) / 1000);
+  }
+
+  fetchCancel = false;
+  fetchStartMs = max(millis(), 1UL);
+
+  HTTPClient http;
+  http.useHTTP10(true);
+  http.setConnectTimeout(timeouts.connect);
+  http.setTimeout(timeouts.headers);
+  http.begin(secure ? (WiFiClient &)secureClient : plainClient, url);
+  fetchSocket.Attach(secure ? (WiFiClient &)secureClient : plainClient, secure);
+  int httpCode;
+  {
+    WatchedCall call(&fetchSocket);
+    httpCode = http.GET();
+  }
+
+  body->clear();
+  if (httpCode > 0 && http.getSize() > (int)maxLength)
+  {
+    httpCode = HTTPC_ERROR_TOO_LESS_RAM;
+  }
+  else if (httpCode > 0)
+  {
+    DeadlineStream stream(http.getStream(), timeouts.body, fetchCancel, &fetchSocket);
+    body->reserve(max(http.getSize(), 0));
+    uint8_t buf[256];
+    size_t length;
+    while ((length = stream.readBytes((char *)buf, sizeof(buf))) > 0)
+    {
+      if (body->size() + length > maxLength)
+      {
+        httpCode = HTTPC_ERROR_TOO_LESS_RAM;
+        break;
+      }
+      body->insert(body->end(), buf, buf + length);
+    }
+    if (stream.Expired() || stream.Cancelled())
+    {
+      httpCode = HTTPC_ERROR_READ_TIMEOUT;
+    }
+  }
+
+  http.end();
+  fetchSocket.Detach();
+  fetchStartMs = 0;
+  return httpCode;
+}
+
+// Download, decode and store one missing logo, the selected symbol's first. At most one per fetch
+// cycle, each symbol's logo is fetched once. The logo document comes from the provider's API, it
+// is counted against the request budget and reported like a quote request. The image itself is
+// served by a CDN and costs nothing. Caller holds the SymbolTableLock.
+void FetchMissingLogo()
+{
+  const size_t maxDocumentLength = 4096;
+  const size_t maxImageLength = 64 * 1024;
+  const unsigned long retryMs = 10 * 60000; // After a network or server failure.
+  static unsigned long failedAt = 0;
+
+  if (!logoCache.Enabled() || parameters.symbolData.empty() || (failedAt != 0 && millis() - failedAt < retryMs))
+  {
+    return;
+  }
+
+  // Nothing is requested once the budget is spent, nor from a provider on trial.
+  QuoteProvider *previousProvider = providerManager.Active();
+  QuoteProvider *provider = providerManager.Select(sys.time.currentTimeInfo.tm_yday);
+  if (provider != previousProvider)
+  {
+    CalcMillisecondsBetweenApiFetches();
+  }
+  if (provider == NULL || providerManager.Probing(provider))
+  {
+    return;
+  }
+  failedAt = 0;
+
+  String symbol;
+  for (size_t i = 0; i < parameters.symbolData.size() && symbol.length() == 0; i++)
+  {
+    const SymbolData &symbolData = parameters.symbolData[(sys.symbolSelect + i) % parameters.symbolData.size()];
+    if (symbolData.isValid && symbolData.version != 0 && logoCache.Wanted(symbolData.symbol, sys.time.currentEpoch))
+    {
+      symbol = symbolData.symbol;
+    }
+  }
+  String url = provider->BuildLogoUrl(symbol);
+  if (symbol.length() == 0 || url.length() == 0)
+  {
+    return;
+  }
+
+  LOG_INFO("LOGO: Requesting the logo of %s from %s", symbol.c_str(), provider->Name().c_str());
+  std::vector<uint8_t> body;
+  unsigned long start = millis();
+  int httpCode = HttpGetBytes(url, maxDocumentLength, &body);
+  body.push_back(0);
+  String document((const char *)body.data());
+
+  // A rejected key or a rate limit starts the provider's cooldown as it would for quotes.
+  FetchResult result = httpCode == 200                        ? FetchResult::Ok
+                       : httpCode > 0                         ? provider->MapError(httpCode, document)
+                       : httpCode == HTTPC_ERROR_TOO_LESS_RAM ? FetchResult::ParseError
+                       : httpCode == HTTPC_ERROR_READ_TIMEOUT ? FetchResult::Timeout
+                                                              : FetchResult::NetworkError;
+  providerManager.Report(provider, result, millis() - start);
+
+  String imageUrl;
+  if (httpCode == 200)
+  {
+    imageUrl = provider->ParseLogoUrl(document);
+  }
+
+  if ((httpCode == 200 || httpCode == 404) && imageUrl.length() == 0)
+  {
+    logoCache.MarkMissing(symbol, sys.time.currentEpoch);
+    return;
+  }
+  if (httpCode != 200)
+  {
+    LOG_WARN("LOGO: Logo of %s not available, HTTP code: %i", symbol.c_str(), httpCode);
+    failedAt = max(millis(), 1UL);
+    return;
+  }
+
+  httpCode = HttpGetBytes(imageUrl, maxImageLength, &body);
+  if (httpCode == 200)
+  {
+    if (!logoCache.StorePng(symbol, body, sys.time.currentEpoch))
+    {
+      logoCache.MarkMissing(symbol, sys.time.currentEpoch); // Not a format the decoder handles.
+    }
+  }
+  else if (httpCode == 404 || httpCode == 403 || httpCode == HTTPC_ERROR_TOO_LESS_RAM)
+  {
+    logoCache.MarkMissing(symbol, sys.time.currentEpoch);
+  }
+  else
+  {
+    LOG_WARN("LOGO: Image of %s not available, HTTP code: %i", symbol.c_str(), httpCode);
+    failedAt = max(millis(), 1UL);
+  }
+}
+
+// Executed as a RTOS task, plays a capture back through the provider response path.
+// Speed scales the recorded spacing, zero replays as fast as possible.
+void ReplayCapture(void *)
+{
+  QuoteReplayer replayer;
+  RecordedResponse response;
+  ProviderParameters providerParameters = {};
+  providerParameters.name = parameters.replay.provider;
+  std::unique_ptr<QuoteProvider> provider(CreateProvider(providerParameters, false));
+  if (provider)
+  {
+    provider->SetFields(RequiredQuoteFields());
+  }
+
+  if (!provider || !replayer.Begin(parameters.replay.file.c_str()))
+  {
+    LOG_ERROR("REPLAY: Unable to replay %s with provider %s.", parameters.replay.file.c_str(), parameters.replay.provider.c_str());
+    vTaskDelete(NULL);
+  }
+
+  while (1)
+  {
+    uint64_t firstTimestamp = 0;
+    unsigned long startMillis = millis();
+    uint32_t count = 0;
+
+    while (replayer.Next(&response))
+    {
+      if (count++ == 0)
+      {
+        firstTimestamp = response.Timestamp();
+      }
+
+      if (parameters.replay.speed > 0)
+      {
+        unsigned long due = (response.Timestamp() - firstTimestamp) / parameters.replay.speed;
+        while (millis() - startMillis < due)
+        {
+          vTaskDelay(pdMS_TO_TICKS(min(due - (millis() - startMillis), 100UL)));
+        }
+      }
+
+      // Recorded symbol lists are comma separated for batch requests.
+      int64_t start = esp_timer_get_time();
+      SymbolTableLock tableLock;
+      std::vector<SymbolData *> batch;
+      std::vector<String> symbols;
+      for (auto &symbolData : parameters.symbolData)
+      {
+        String list = "," + response.symbol + ",";
+        if (list.indexOf("," + symbolData.symbol + ",") >= 0)
+        {
+          symbolData.lastApiCall = response.epoch;
+          batch.push_back(&symbolData);
+          symbols.push_back(symbolData.symbol);
+        }
+      }
+      if (batch.size() == 0)
+      {
+        continue;
+      }
+
+      std::vector<Quote> quotes(batch.size());
+      std::unique_ptr<bool[]> found(new bool[batch.size()]());
+      StreamString body;
+      body.concat(response.payload);
+
+      status.requestInProgess = true;
+      FetchResult result = response.httpCode != 200                                                                   ? provider->MapError(response.httpCode, response.payload)
+                           : provider->ParseQuotes(body, symbols.data(), batch.size(), quotes.data(), found.get()) ? FetchResult::Ok
+                                                                                                                    : FetchResult::ParseError;
+      status.api = ApplyFetchResult(provider.get(), batch, result, quotes.data(), found.get());
+      status.requestInProgess = false;
+      MetricsTaskBusy(replayTaskConfig.name, esp_timer_get_time() - start);
+    }
+
+    MetricsTaskStack(replayTaskConfig.name);
+    unsigned long elapsed = millis() - startMillis;
+    LOG_INFO("REPLAY: %u responses in %lu ms (%lu per second).", count, elapsed, elapsed ? count * 1000UL / elapsed : 0);
+
+    if (!parameters.replay.loop || count == 0 || !replayer.Rewind())
+    {
+      break;
+    }
+  }
+
+  replayer.End();
+  vTaskDelete(NULL);
+}
+
+// Executed as a RTOS task, holds a server-sent events connection and ingests quotes as they arrive.
+// Quotes are conflated per symbol and ingested at most streaming.ingestPerSecond times a second,
+// so a burst of events costs one slot per symbol instead of an unbounded queue.
+void StreamQuotes(void *)
+{
+  SseClient sse;
+  std::vector<Quote> pendingQuotes;
+  std::vector<int64_t> pendingSince; // Receive time in microseconds, 0 when empty.
+  std::vector<String> symbols;       // Subscribed, a change of the symbol table resubscribes.
+  uint32_t tableVersion = ~0;
+  uint8_t connectFailures = 0;
+  unsigned long lastIngest = 0;
+  unsigned long lastReport = millis();
+  const unsigned long ingestInterval = 1000 / parameters.streaming.ingestPerSecond;
+
+  sse.SetMaxEventSize(parameters.streaming.maxEventSize);
+
+  auto onQuote = [&](const char *symbol, const Quote &quote) {
+    for (size_t i = 0; i < symbols.size(); i++)
+    {
+      if (symbols[i].equalsIgnoreCase(symbol))
+      {
+        if (pendingSince[i] != 0)
+        {
+          streamStats.conflated++;
+        }
+        else
+        {
+          pendingSince[i] = esp_timer_get_time();
+        }
+        pendingQuotes[i] = quote;
+        streamStats.quotes++;
+        return;
+      }
+    }
+  };
+
+  while (1)
+  {
+    if (tableVersion != symbolTableVersion)
+    {
+      SymbolTableLock tableLock;
+      tableVersion = symbolTableVersion;
+      symbols.clear();
+      for (auto &symbolData : parameters.symbolData)
+      {
+        symbols.push_back(symbolData.symbol);
+      }
+      pendingQuotes.assign(symbols.size(), Quote());
+      pendingSince.assign(symbols.size(), 0);
+    }
+
+    QuoteProvider *provider = providerManager.Select(sys.time.currentTimeInfo.tm_yday);
+    String url = parameters.streaming.url.length() > 0 ? parameters.streaming.url
+                 : provider != NULL                   ? provider->BuildStreamUrl(symbols.data(), symbols.size())
+                                                      : String("");
+
+    if (url.length() == 0 || WiFi.status() != WL_CONNECTED)
+    {
+      vTaskDelay(pdMS_TO_TICKS(5000));
+      continue;
+    }
+
+    LOG_DEBUG("SSE: Connecting to %s", url.c_str());
+    if (!sse.Connect(url, sse.LastEventId(), 10000))
+    {
+      // Back off, honouring the server's retry hint as the floor.
+      streamStats.reconnects++;
+      connectFailures = min(connectFailures + 1, 16);
+      vTaskDelay(pdMS_TO_TICKS(max(BackoffDelay(streamBackoff, connectFailures), sse.RetryMs())));
+      continue;
+    }
+
+    LOG_INFO("SSE: Streaming %u symbols.", symbols.size());
+    status.streaming = true;
+    status.api = true;
+    apiFault = FetchResult::Ok;
+    connectFailures = 0;
+
+    auto onEvent = [&](const String &event, const String &data) {
+      streamStats.messages++;
+      if (provider == NULL || !provider->ParseStreamEvent(data, onQuote))
+      {
+        streamStats.parseErrors++;
+      }
+    };
+
+    while (1)
+    {
+      int64_t busyStart = esp_timer_get_time();
+      size_t bytesRead = 0;
+      bool connected = sse.Poll(onEvent, &bytesRead);
+      streamStats.bytes += bytesRead;
+
+      if (millis() - lastIngest >= ingestInterval)
+      {
+        lastIngest = millis();
+        SymbolTableLock tableLock;
+        if (tableVersion != symbolTableVersion)
+        {
+          break; // Reloaded, resubscribe with the new list.
+        }
+        for (size_t i = 0; i < pendingQuotes.size(); i++)
+        {
+          if (pendingSince[i] != 0)
+          {
+            IngestQuote(&parameters.symbolData[i], pendingQuotes[i]);
+            uint32_t latencyUs = esp_timer_get_time() - pendingSince[i];
+            streamStats.lastLatencyUs = latencyUs;
+            streamStats.maxLatencyUs = max(streamStats.maxLatencyUs, latencyUs);
+            streamStats.totalLatencyUs += latencyUs;
+            streamStats.ingested++;
+            pendingSince[i] = 0;
+          }
+        }
+      }
+      MetricsTaskBusy(streamTaskConfig.name, esp_timer_get_time() - busyStart);
+
+      if (millis() - lastReport > 60000)
+      {
+        lastReport = millis();
+        MetricsTaskStack(streamTaskConfig.name);
+        LOG_INFO("SSE: %u messages, %u quotes, %u conflated, mean latency %lu us, max %u us.",
+                 streamStats.messages, streamStats.quotes, streamStats.conflated,
+                 streamStats.ingested ? (unsigned long)(streamStats.totalLatencyUs / streamStats.ingested) : 0UL,
+                 streamStats.maxLatencyUs);
+      }
+
+      if (!connected)
+      {
+        break;
+      }
+
+      if (bytesRead == 0)
+      {
+        vTaskDelay(pdMS_TO_TICKS(10));
+      }
+    }
+
+    LOG_WARN("SSE: Connection lost, resuming from event id \"%s\".", sse.LastEventId().c_str());
+    sse.Stop();
+    status.streaming = false;
+    streamStats.reconnects++;
+    streamStats.oversized = sse.Oversized();
+  }
+}
+
+// Executed as a RTOS task, drives every symbol from the synthetic market.
+void GenerateDemoData(void *)
+{
+  TickType_t lastWake = xTaskGetTickCount();
+  const TickType_t period = max(1, configTICK_RATE_HZ / parameters.demo.ticksPerSecond);
+  Quote quote;
+
+  while (1)
+  {
+    {
+      int64_t start = esp_timer_get_time();
+      SymbolTableLock tableLock;
+      for (size_t i = 0; i < min(demoMarket.Size(), parameters.symbolData.size()); i++)
+      {
+        demoMarket.Step(i, sys.time.currentEpoch, &quote);
+        IngestQuote(&parameters.symbolData[i], quote);
+      }
+      MetricsTaskBusy(demoTaskConfig.name, esp_timer_get_time() - start);
+    }
+    status.api = true;
+    MetricsTaskStack(demoTaskConfig.name);
+
+    vTaskDelayUntil(&lastWake, period);
+  }
+}
+
+// Touch screen requires calibation, orientation may be inversed.
+void ProcessTouchScreen()
+{
+  //static takeTouchReadings = true;
+  static unsigned long touchDebounceDelay = 250;
+  static unsigned long touchDebounceMillis = millis();
+  uint16_t x, y;
+
+  if (millis() - touchDebounceMillis > touchDebounceDelay)
+  {
+    if (tft.getTouch(&x, &y, 64))
+    {
+      touchDebounceMillis = millis();
+
+      if (symbolBrowser.Active())
+      {
+        symbolBrowser.Touch(x, y);
+      }
+      else if (overviewGrid.Active())
+      {
+        int symbol = overviewGrid.SymbolAt(x, y);
+        if (y < frameLayout.titleHeight)
+        {
+          overviewGrid.NextPage();
+        }
+        else if (symbol >= 0)
+        {
+          sys.symbolSelect = symbol; // A tile opens its quote.
+          overviewGrid.Close();
+        }
+        else if (y > frameLayout.footerTop)
+        {
+          overviewGrid.Close();
+          tickerTape.Open(parameters.symbolData.size()); // Indicator row moves on to the tape.
+        }
+      }
+      else if (tickerTape.Active())
+      {
+        if (y > frameLayout.footerTop)
+        {
+          tickerTape.Close();
+        }
+      }
+      else if (y > frameLayout.footerTop)
+      {
+        intradayChart.Close();
+        overviewGrid.Open(parameters.symbolData.size(), sys.symbolSelect); // Indicator row opens the overview.
+      }
+      else if (intradayChart.Active() && (y < frameLayout.titleHeight || (x >= screen.width / 3 && x <= (screen.width / 3) * 2)))
+      {
+        intradayChart.Close(); // Title or middle of the chart returns to the quote.
+      }
+      else if (y < frameLayout.titleHeight && x < frameLayout.symbolBoxWidth && symbolIndex.Enabled())
+      {
+        symbolBrowser.Open(AddWatchlistSymbol); // Symbol box opens the browser.
+      }
+      else if (y < frameLayout.titleHeight && x >= frameLayout.symbolBoxWidth)
+      {
+        intradayChart.Open(); // Name box opens the chart.
+      }
+      else if (x < screen.width / 3)
+      {
+        sys.symbolSelect++;
+        if (sys.symbolSelect > parameters.symbolData.size() - 1)
+        {
+          sys.symbolSelect = 0;
+        }
+      }
+      else if (x > (screen.width / 3) * 2)
+      {
+        if (sys.symbolSelect != 0)
+        {
+          sys.symbolSelect--;
+        }
+        else
+        {
+          sys.symbolSelect = parameters.symbolData.size() - 1;
+        }
+      }
+      else
+      {
+        status.symbolLocked = !status.symbolLocked;
+      }
+    }
+  }
+}
+
+bool ConnectWifi()
+{
+  const int yLine1 = screen.Y(50);
+  const int yLine2 = screen.Y(70);
+  const int yLine3 = screen.Y(90);
+  const int yLine4 = screen.Y(110);
+  const int yLine5 = screen.Y(140);
+  const int yLine6 = screen.Y(160);
+
+  char buf[128];
+  int wifiCredentialsIndex = 0;
+
+  while (1)
+  {
+    DisplayBlank();
+    tft.setTextSize(2);
+    tft.setTextColor(TFT_GREEN);
+    tft.setTextDatum(TL_DATUM);
+    tft.drawString("Connecting to WiFi", 10, yLine1);
+    sprintf(buf, "SSID: %s", parameters.wifiCredentials[wifiCredentialsIndex].ssid.c_str());
+    tft.drawString(buf, 10, yLine2);
+    sprintf(buf, "PWD: %s", parameters.wifiCredentials[wifiCredentialsIndex].password.c_str());
+    tft.drawString(buf, 10, yLine3);
+
+    LOG_INFO("WIFI: Connecting to SSID: %s", parameters.wifiCredentials[wifiCredentialsIndex].ssid.c_str());
+
+    WiFi.begin(parameters.wifiCredentials[wifiCredentialsIndex].ssid.c_str(), parameters.wifiCredentials[wifiCredentialsIndex].password.c_str());
+
+    tft.setCursor(10, yLine4);
+    int count = 0;
+    while (count++ < 10)
+    {
+      delay(500);
+      tft.print(".");
+
+      if (WiFi.status() == WL_CONNECTED)
+      {
+        tft.drawString("Connected!", 10, yLine5);
+        sprintf(buf, "IP: %s", WiFi.localIP().toString().c_str());
+        tft.drawString(buf, 10, yLine6);
+        LOG_INFO("WIFI: WiFi connected to %s, device IP: %s", parameters.wifiCredentials[wifiCredentialsIndex].ssid.c_str(), WiFi.localIP().toString().c_str());
+        delay(2000);
+        DisplayBlank();
+        return true;
+      }
+    }
+
+    wifiCredentialsIndex++;
+    if (wifiCredentialsIndex > parameters.wifiCredentials.size() - 1)
+    {
+      wifiCredentialsIndex = 0;
+    }
+  }
+}
+
+bool ProcessTime()
+{
+  static unsigned long startGetTime = millis();
+
+  if (millis() - startGetTime > 250)
+  {
+    startGetTime = millis();
+
+    if (!getLocalTime(&sys.time.currentTimeInfo))
+    {
+      LOG_RATE_LIMITED(LOG_LEVEL_WARN, 10000, "TIME: Failed to obtain time");
+      status.time = false;
+      return false;
+    }
+
+    status.time = true;
+
+    time(&sys.time.currentEpoch); // Fetch current time as epoch
+
+    static int previousMinute = ~sys.time.currentTimeInfo.tm_min;
+    if (previousMinute != sys.time.currentTimeInfo.tm_min)
+    {
+      previousMinute = sys.time.currentTimeInfo.tm_min;
+      ProcessIndicators(true);
+    }
+  }
+
+  return true;
+}
+
+void ProcessMarketState()
+{
+  marketState = isMarketHoliday                                                                                                        ? MarketState::Holiday
+                : sys.time.currentTimeInfo.tm_wday == int(DayIds::Sunday) || sys.time.currentTimeInfo.tm_wday == int(DayIds::Saturday) ? MarketState::Weekend
+                : sys.time.preMarketTimeRange.isTimeBetweenRange(sys.time.currentTimeInfo.tm_hour, sys.time.currentTimeInfo.tm_min)    ? MarketState::PreHours
                 : sys.time.marketTimeRange.isTimeBetweenRange(sys.time.currentTimeInfo.tm_hour, sys.time.currentTimeInfo.tm_min)       ? MarketState::MarketHours
                 : sys.time.afterMarketTimeRange.isTimeBetweenRange(sys.time.currentTimeInfo.tm_hour, sys.time.currentTimeInfo.tm_min)  ? MarketState::AfterHours
                                                                                                                                        : MarketState::Closed;
 }
 
-void ProcessDisplayBrightness()
+void ProcessDisplayBrightness()
+{
+  static int previousBrightness = ledcRead(0);
+  int brightness = sys.time.displayMaxBrightnessTimeRange.isTimeBetweenRange(sys.time.currentTimeInfo.tm_hour, sys.time.currentTimeInfo.tm_min) ? parameters.display.brightnessMax : parameters.display.brightnessMin;
+
+  if (previousBrightness != brightness)
+  {
+    LOG_INFO("DISPLAY: display brightness changed from %u to %u.", previousBrightness, brightness);
+    previousBrightness = brightness;
+    ledcWrite(PWM_CHANNEL_LCD_BACKLIGHT, brightness);
+  }
+}
+
+void ProcessWifiCheck()
+{
+  // Check for WiFi connection, attempt reconnect after timeout.
+  status.wifi = (WiFi.status() == WL_CONNECTED);
+  static unsigned long startStatus = millis();
+  if (millis() - startStatus > sys.wifiTimeoutUntilNewScan)
+  {
+    MetricsCountWifiReconnect();
+    ConnectWifi();
+  }
+  if (status.wifi == true)
+  {
+    startStatus = millis();
+  }
+}
+
+// Replace the symbol table with the reloaded list. Entries already listed keep their quotes and
+// history, so the display carries on showing them. Caller holds the SymbolTableLock.
+void ApplySymbolTable(const std::vector<SymbolData> &symbols)
+{
+  std::vector<SymbolData> table;
+  std::vector<int> sourceIndex;
+  std::vector<String> watchlist;
+  size_t kept = 0;
+  table.reserve(symbols.size());
+
+  {
+    SymbolLock lock;
+    for (auto &symbolData : symbols)
+    {
+      int source = -1;
+      for (size_t i = 0; i < parameters.symbolData.size() && source < 0; i++)
+      {
+        if (parameters.symbolData[i].symbol.equalsIgnoreCase(symbolData.symbol))
+        {
+          source = i;
+        }
+      }
+      table.push_back(source >= 0 ? parameters.symbolData[source] : symbolData);
+      sourceIndex.push_back(source);
+      watchlist.push_back(symbolData.symbol);
+      kept += source >= 0;
+    }
+
+    // Stay on the symbol being shown when it is still listed.
+    String selected = parameters.symbolData.at(sys.symbolSelect).symbol;
+    size_t previousSize = parameters.symbolData.size();
+    parameters.symbolData.swap(table);
+    quoteHistory.Remap(sourceIndex);
+    if (parameters.api.mode == ApiMode::Demo)
+    {
+      demoMarket.Remap(sourceIndex);
+    }
+    sys.symbolSelect = 0;
+    for (size_t i = 0; i < watchlist.size(); i++)
+    {
+      if (watchlist[i].equalsIgnoreCase(selected))
+      {
+        sys.symbolSelect = i;
+      }
+    }
+    quoteGeneration++;
+    symbolTableVersion++;
+
+    LOG_INFO("WATCHLIST: %u kept, %u added, %u removed.", kept, watchlist.size() - kept, previousSize - kept);
+  }
+
+  if (peerSync.Enabled())
+  {
+    peerSync.SetWatchlist(watchlist);
+  }
+
+  if (kept < watchlist.size())
+  {
+    FetchRequest request = FetchRequest::NewSymbols;
+    xQueueSend(fetchQueue, &request, 0);
+  }
+}
+
+enum class ReloadResult
 {
-  static int previousBrightness = ledcRead(0);
-  int brightness = sys.time.displayMaxBrightnessTimeRange.isTimeBetweenRange(sys.time.currentTimeInfo.tm_hour, sys.time.currentTimeInfo.tm_min) ? parameters.display.brightnessMax : parameters.display.brightnessMin;
+  Applied,
+  Invalid,
+  Busy
+};
 
-  if (previousBrightness != brightness)
+// Load parameters from path and apply the sections that differ from the running ones.
+// Sections read only at start up are reported and left as they are.
+ReloadResult ReloadParameters(const char *path)
+{
+  Parameters loaded;
+  Time loadedTime(sys.time);
+  ConfigDigest digest;
   {
-    Serial.printf("DISPLAY: display brightness changed from %u to %u.\n", previousBrightness, brightness);
-    previousBrightness = brightness;
-    ledcWrite(PWM_CHANNEL_LCD_BACKLIGHT, brightness);
+    SdLock lock;
+    File file = SD.open(path);
+    bool valid = file && LoadParameters(file, &loaded, &loadedTime, &digest);
+    file.close();
+    if (!valid)
+    {
+      return ReloadResult::Invalid;
+    }
+  }
+  AddLogSecrets(loaded);
+  LoadWatchlistAdditions(&loaded.symbolData);
+
+  bool symbolsChanged = loaded.symbolData.size() != parameters.symbolData.size();
+  for (size_t i = 0; i < loaded.symbolData.size() && !symbolsChanged; i++)
+  {
+    symbolsChanged = !loaded.symbolData[i].symbol.equalsIgnoreCase(parameters.symbolData[i].symbol);
+  }
+
+  if (symbolsChanged)
+  {
+    SymbolTableLock tableLock(0);
+    if (!tableLock.Locked())
+    {
+      return ReloadResult::Busy; // A fetch is in flight, try again shortly.
+    }
+    ApplySymbolTable(loaded.symbolData);
+  }
+
+  bool alertRulesChanged = false;
+  for (auto &section : digest.Changed(parametersDigest))
+  {
+    if (section == "display")
+    {
+      parameters.display = loaded.display;
+      sys.time.displayMaxBrightnessTimeRange = loadedTime.displayMaxBrightnessTimeRange;
+    }
+    else if (section == "matrix")
+    {
+      parameters.matrix = loaded.matrix;
+      sys.time.matrixMaxBrightnessTimeRange = loadedTime.matrixMaxBrightnessTimeRange;
+    }
+    else if (section == "market")
+    {
+      parameters.market = loaded.market;
+    }
+    else if (section == "system")
+    {
+      sys.time.timeZone = loadedTime.timeZone;
+    }
+    else if (section == "alerts")
+    {
+      parameters.alerts = loaded.alerts;
+    }
+    else if (section == "alertRules")
+    {
+      parameters.alertRules.swap(loaded.alertRules);
+      alertRulesChanged = true;
+    }
+    else if (section == "log" && loaded.log.level != parameters.log.level)
+    {
+      parameters.log.level = loaded.log.level;
+      LogSetLevel(LogLevelFromString(parameters.log.level));
+    }
+    else if (section != "symbols")
+    {
+      LOG_WARN("CONFIG: Changes to \"%s\" take effect after a restart.", section.c_str());
+      continue;
+    }
+    LOG_INFO("CONFIG: Applied \"%s\".", section.c_str());
+  }
+
+  // New symbols and rules start with fresh slots.
+  if (symbolsChanged || alertRulesChanged)
+  {
+    SymbolLock lock;
+    CompileAlerts(parameters.symbolData, parameters.alertRules);
   }
+
+  parametersDigest = digest;
+  CalcMillisecondsBetweenApiFetches();
+  return ReloadResult::Applied;
 }
 
-void ProcessWifiCheck()
+// Watch parameters.json for edits and the local API for an uploaded replacement.
+void ProcessParametersReload()
 {
-  // Check for WiFi connection, attempt reconnect after timeout.
-  status.wifi = (WiFi.status() == WL_CONNECTED);
-  static unsigned long startStatus = millis();
-  if (millis() - startStatus > sys.wifiTimeoutUntilNewScan)
+  static unsigned long startCheck = millis();
+  if (millis() - startCheck < 5000)
   {
-    ConnectWifi();
+    return;
   }
-  if (status.wifi == true)
+  startCheck = millis();
+
+  static bool pending = false; // Changed, not yet applied.
+  bool uploaded;
   {
-    startStatus = millis();
+    SdLock lock;
+    uploaded = SD.exists(parametersUploadFilePath);
+    File file = SD.open(parametersFilePath);
+    if (file && (file.size() != parametersFileSize || file.getLastWrite() != parametersFileTime))
+    {
+      parametersFileSize = file.size();
+      parametersFileTime = file.getLastWrite();
+      pending = true;
+    }
+    file.close();
+  }
+
+  // An upload replaces the file only once it has loaded.
+  if (uploaded)
+  {
+    ReloadResult result = ReloadParameters(parametersUploadFilePath);
+    SdLock lock;
+    if (result == ReloadResult::Invalid)
+    {
+      LOG_ERROR("CONFIG: Uploaded parameters are invalid, discarded.");
+      SD.remove(parametersUploadFilePath);
+    }
+    else if (result == ReloadResult::Applied)
+    {
+      SD.remove(parametersFilePath);
+      SD.rename(parametersUploadFilePath, parametersFilePath);
+      File file = SD.open(parametersFilePath);
+      parametersFileSize = file.size();
+      parametersFileTime = file.getLastWrite();
+      file.close();
+      pending = false;
+    }
+    return;
+  }
+
+  if (pending)
+  {
+    ReloadResult result = ReloadParameters(parametersFilePath);
+    if (result == ReloadResult::Invalid)
+    {
+      LOG_ERROR("CONFIG: %s changed but is invalid, keeping the running parameters.", parametersFilePath);
+    }
+    pending = result == ReloadResult::Busy;
+  }
+}
+
+// List the symbols picked in the browser once no fetch is in flight. A reload in the meantime
+// has read them from the watchlist file already.
+void ProcessWatchlistAdditions()
+{
+  if (watchlistAdditions.empty())
+  {
+    return;
+  }
+
+  SymbolTableLock tableLock(0);
+  if (!tableLock.Locked())
+  {
+    return; // Try again on the next loop.
+  }
+
+  // Only this loop changes the symbols, the names are read without the SymbolLock.
+  std::vector<SymbolData> symbols(parameters.symbolData.size());
+  for (size_t i = 0; i < symbols.size(); i++)
+  {
+    symbols[i].symbol = parameters.symbolData[i].symbol;
+  }
+  for (auto &addition : watchlistAdditions)
+  {
+    auto listed = std::find_if(symbols.begin(), symbols.end(),
+                               [&](const SymbolData &symbolData) { return symbolData.symbol.equalsIgnoreCase(addition.symbol); });
+    if (listed == symbols.end())
+    {
+      symbols.push_back(addition);
+    }
+  }
+  watchlistAdditions.clear();
+
+  if (symbols.size() > parameters.symbolData.size())
+  {
+    ApplySymbolTable(symbols);
+    SymbolLock lock;
+    CompileAlerts(parameters.symbolData, parameters.alertRules);
+  }
+}
+
+// Executed as a RTOS task on the protocol core. Polls at the budgeted rate, a FetchRequest
+// on fetchQueue brings the next request forward to the minimum interval.
+void FetchQuotesTask(void *)
+{
+  unsigned long lastFetch = millis() - minFetchIntervalMs;
+  bool requested = false;
+
+  while (1)
+  {
+    unsigned long interval = requested ? minFetchIntervalMs : max(sys.millisecondsBetweenApiCalls, minFetchIntervalMs);
+    unsigned long elapsed = millis() - lastFetch;
+    if (elapsed < interval)
+    {
+      FetchRequest request;
+      requested |= xQueueReceive(fetchQueue, &request, pdMS_TO_TICKS(interval - elapsed)) == pdTRUE;
+      continue;
+    }
+
+    lastFetch = millis();
+    requested = false;
+
+    // Polling fills in while the stream is down. While it is up, a symbol that has no quote yet
+    // is polled once, so one the stream does not carry still shows a price.
+    {
+      SymbolTableLock tableLock;
+      bool streaming = status.streaming;
+      if (!streaming || std::any_of(parameters.symbolData.begin(), parameters.symbolData.end(), Unquoted))
+      {
+        int64_t start = esp_timer_get_time();
+        fetchCancel = false;
+        fetchStartMs = max(millis(), 1UL);
+        FetchDueSymbols(streaming);
+        fetchStartMs = 0;
+        if (status.api && !streaming)
+        {
+          FetchMissingLogo();
+        }
+        MetricsTaskBusy(fetchTaskConfig.name, esp_timer_get_time() - start);
+      }
+    }
+    MetricsTaskStack(fetchTaskConfig.name);
+  }
+}
+
+// Cancel a fetch that has outrun the sum of its phase deadlines. When it does not return, shut its
+// socket down so the blocked call fails and the task unwinds on its own, releasing its locks.
+// Only a task that is still blocked on the network after that is replaced, it holds no lock
+// then but the SymbolTableLock. The stuck connection's buffers are leaked with it.
+void ProcessFetchWatchdog()
+{
+  static uint32_t abortedStart = 0;
+  uint32_t started = fetchStartMs;
+  if (started == 0)
+  {
+    return;
+  }
+
+  unsigned long elapsed = millis() - started;
+  unsigned long limit = parameters.api.timeouts.Total();
+  if (elapsed > limit && !fetchCancel)
+  {
+    LOG_WARN("API: Fetch running for %lu ms, cancelling.", elapsed);
+    fetchCancel = true;
+    MetricsCountFetchTimeout(FetchTimeout::Cancelled);
+  }
+
+  if (elapsed > limit + fetchAbortGraceMs && abortedStart != started)
+  {
+    abortedStart = started;
+    bool aborted = fetchSocket.Abort();
+    MetricsCountFetchTimeout(FetchTimeout::Aborted);
+    LOG_WARN("API: Fetch running for %lu ms, %s.", elapsed, aborted ? "socket shut down" : "no socket to shut down");
+  }
+
+  if (elapsed > limit + fetchRecycleGraceMs)
+  {
+    vTaskSuspend(fetchTaskHandle);
+    if (fetchStartMs != started)
+    {
+      vTaskResume(fetchTaskHandle); // Returned in the meantime.
+      return;
+    }
+    if (!fetchSocket.Waiting())
+    {
+      // Away from the network it may hold the symbol or SD lock, it is left to finish.
+      vTaskResume(fetchTaskHandle);
+      LOG_RATE_LIMITED(LOG_LEVEL_ERROR, 60000, "API: Fetch task stuck for %lu ms outside a network call.", elapsed);
+      return;
+    }
+    vTaskDelete(fetchTaskHandle);
+    fetchSocket.Reset();
+    fetchStartMs = 0;
+    status.requestInProgess = false;
+    status.api = false;
+    xSemaphoreGive(symbolTableMutex); // Held by the deleted task, see SymbolTableLock.
+    MetricsCountFetchRecycle();
+    LOG_ERROR("API: Fetch task stuck for %lu ms, replaced.", elapsed);
+    StartTask(FetchQuotesTask, fetchTaskConfig, NULL, &fetchTaskHandle);
   }
 }
 
 // Start API data fetch.
 void ProcessAPIFetch()
 {
-  static unsigned long startFetch = 0;
-  if (millis() - startFetch > 10000)
+  if (parameters.api.mode == ApiMode::Demo)
+  {
+    static bool demoStarted = false;
+    if (!demoStarted)
+    {
+      demoStarted = true;
+      demoMarket.Begin(parameters.demo.seed, parameters.demo.volatility, parameters.symbolData.size());
+      StartTask(GenerateDemoData, demoTaskConfig);
+    }
+    return;
+  }
+
+  if (parameters.api.mode == ApiMode::Replay)
   {
-    startFetch = millis();
+    static bool replayStarted = false;
+    if (!replayStarted)
+    {
+      replayStarted = true;
+      StartTask(ReplayCapture, replayTaskConfig);
+    }
+    return;
+  }
+
+  if (parameters.streaming.enabled)
+  {
+    static bool streamStarted = false;
+    if (!streamStarted)
+    {
+      streamStarted = true;
+      StartTask(StreamQuotes, streamTaskConfig);
+    }
+  }
 
-    xTaskCreate(
-        GetSymbolData,   // Function that should be called
-        "GetSymbolData", // Name of the task (for debugging)
-        8192,            // Stack size (bytes)
-        NULL,            // Parameter to pass
-        1,               // Task priority
-        NULL             // Task handle
-    );
+  static bool fetchStarted = false;
+  if (!fetchStarted && (parameters.api.mode == ApiMode::Live || parameters.api.mode == ApiMode::Sandbox))
+  {
+    fetchStarted = true;
+    StartTask(FetchQuotesTask, fetchTaskConfig, NULL, &fetchTaskHandle);
   }
 }
 
@@ -880,29 +2326,157 @@ void ProcessSymbolIncrement()
   }
 }
 
-// Update display after a API completes.
-void ProcessDisplayUpdate()
+void DisplayIntradayChart()
 {
-  static bool previousRequestInProgess;
-  static unsigned int previousSymbolSelect;
-  if (previousRequestInProgess == true && status.requestInProgess == false)
+  std::vector<HistoryPoint> history;
+  SymbolData symbolData;
+  uint8_t decimals;
   {
-    previousSymbolSelect = !previousSymbolSelect;
+    SymbolLock lock;
+    decimals = quoteHistory.Copy(sys.symbolSelect, &history);
+    symbolData = parameters.symbolData.at(sys.symbolSelect);
   }
-  previousRequestInProgess = status.requestInProgess;
 
-  // Update display with symbol data.
-  if (previousSymbolSelect != sys.symbolSelect)
+  // The history may predate a change of the quote's scale.
+  int32_t reference = FixedRescale(symbolData.openPrice, symbolData.decimals, decimals);
+  intradayChart.Draw(symbolData.symbol, history, decimals, reference);
+}
+
+// Quote of the overview and ticker tape pages, copied only when it changed.
+bool ReadQuoteTile(size_t index, uint32_t knownVersion, bool repaint, QuoteTile *tile)
+{
+  SymbolLock lock;
+  if (index >= parameters.symbolData.size())
   {
-    previousSymbolSelect = sys.symbolSelect;
-    DisplayStockData(parameters.symbolData.at(sys.symbolSelect));
+    return false;
+  }
+
+  const SymbolData &symbolData = parameters.symbolData[index];
+  if (!repaint && symbolData.version == knownVersion)
+  {
+    return false;
   }
+  tile->symbol = symbolData.symbol;
+  tile->price = symbolData.currentPrice;
+  tile->change = symbolData.change;
+  tile->changePercent = symbolData.changePercent;
+  tile->decimals = symbolData.decimals;
+  tile->valid = symbolData.isValid;
+  tile->version = symbolData.version;
+  return true;
+}
 
+// Update display when the selected symbol or its quote changes.
+void ProcessDisplayUpdate()
+{
+  static unsigned int previousSymbolSelect = ~0;
+  static uint32_t previousVersion;
   static MarketState previousMarketState = marketState;
-  if (previousMarketState != marketState)
+  static uint32_t previousTableVersion = symbolTableVersion;
+  static FetchResult previousFault = FetchResult::Ok;
+  static uint32_t previousLogoVersion = 0;
+  static uint32_t previousAlertVersion = 0;
+  static bool browsing = false;
+  static bool charting = false;
+  static bool overview = false;
+  static bool taping = false;
+
+  // The browser owns the screen until it is closed, then the layout is redrawn.
+  if (symbolBrowser.Active())
+  {
+    browsing = true;
+    return;
+  }
+  if (browsing || (charting && !intradayChart.Active()) || (overview && !overviewGrid.Active()) ||
+      (taping && !tickerTape.Active()))
+  {
+    browsing = false;
+    charting = false;
+    overview = false;
+    taping = false;
+    previousSymbolSelect = ~0;
+    tft.fillScreen(TFT_BLACK);
+    DisplayLayout();
+    ProcessIndicators(true);
+  }
+
+  // Only tiles whose quote changed are repainted.
+  if (overviewGrid.Active())
+  {
+    if (!overview || previousTableVersion != symbolTableVersion)
+    {
+      overview = true;
+      previousTableVersion = symbolTableVersion;
+      overviewGrid.Open(parameters.symbolData.size(), overviewGrid.First());
+    }
+
+    unsigned long frameStart = micros();
+    if (overviewGrid.Update(ReadQuoteTile) > 0)
+    {
+      MetricsObserveFrame(micros() - frameStart);
+    }
+    return;
+  }
+
+  // Scrolls every loop, a frame is pushed at the tape's own frame rate.
+  if (tickerTape.Active())
+  {
+    if (!taping || previousTableVersion != symbolTableVersion)
+    {
+      taping = true;
+      previousTableVersion = symbolTableVersion;
+      tickerTape.Open(parameters.symbolData.size());
+    }
+
+    unsigned long frameStart = micros();
+    if (tickerTape.Update(ReadQuoteTile, parameters.display.tapeSpeed))
+    {
+      MetricsObserveFrame(micros() - frameStart);
+    }
+    return;
+  }
+  if (!charting && intradayChart.Active())
+  {
+    charting = true;
+    previousSymbolSelect = ~0;
+  }
+
+  uint32_t version = parameters.symbolData.at(sys.symbolSelect).version;
+
+  if (previousSymbolSelect != sys.symbolSelect ||
+      previousVersion != version ||
+      previousMarketState != marketState ||
+      previousTableVersion != symbolTableVersion ||
+      previousFault != apiFault ||
+      previousLogoVersion != logoCache.Version() ||
+      previousAlertVersion != alertVersion)
   {
+    previousSymbolSelect = sys.symbolSelect;
+    previousTableVersion = symbolTableVersion;
+    previousVersion = version;
     previousMarketState = marketState;
-     DisplayStockData(parameters.symbolData.at(sys.symbolSelect));
+    previousFault = apiFault;
+    previousLogoVersion = logoCache.Version();
+    previousAlertVersion = alertVersion;
+
+    unsigned long frameStart = micros();
+    if (charting)
+    {
+      DisplayIntradayChart();
+    }
+    else
+    {
+      DisplayStockData(GetSymbolSnapshot(sys.symbolSelect));
+      if (alertShowing)
+      {
+        DisplayBanner(AlertText(shownAlert), AlertRise(shownAlert) ? TFT_GREEN : TFT_RED);
+      }
+      else
+      {
+        DisplayFaultBanner(previousFault);
+      }
+    }
+    MetricsObserveFrame(micros() - frameStart);
   }
 }
 
@@ -910,7 +2484,15 @@ void setup()
 {
   delay(500);
   Serial.begin(115200);
-  Serial.println(F("\nQuoteBot starting up..."));
+  sdMutex = xSemaphoreCreateRecursiveMutex();
+  symbolMutex = xSemaphoreCreateMutex();
+  symbolTableMutex = xSemaphoreCreateBinary();
+  xSemaphoreGive(symbolTableMutex);
+  fetchQueue = xQueueCreate(4, sizeof(FetchRequest));
+  alertQueue = xQueueCreate(16, sizeof(AlertEvent));
+  fetchSocket.Begin();
+  LogBegin();
+  LOG_INFO("QuoteBot starting up...");
 
   matrix.setBrightness(0);
   matrix.begin();
@@ -923,7 +2505,7 @@ void setup()
 
   tft.init();
   delay(50);
-  tft.setRotation(1);
+  tft.setRotation(displayRotation);
   delay(50);
   tft.fillScreen(TFT_BLACK);
   DisplayLayout();
@@ -945,25 +2527,101 @@ void setup()
   {
     Error(ErrorIDs::ParametersFailed);
   }
+  LoadWatchlistAdditions(&parameters.symbolData);
+  CompileAlerts(parameters.symbolData, parameters.alertRules);
+  symbolIndex.Begin(symbolIndexFilePath);
+  if (parameters.display.priceFont.length() > 0)
+  {
+    {
+      SdLock lock;
+      priceFont.Begin(SD, parameters.display.priceFont.c_str(), quoteLayout.changeY - quoteLayout.priceY,
+                      parameters.display.thousandsSeparator);
+    }
+    if (priceFont.Enabled())
+    {
+      BenchmarkPriceFont();
+    }
+  }
+
+  LogSetLevel(LogLevelFromString(parameters.log.level));
+  AddLogSecrets(parameters);
+  if (parameters.capture.enabled && !quoteRecorder.Begin(parameters.capture.file.c_str()))
+  {
+    parameters.capture.enabled = false;
+  }
+
+  if (parameters.cache.enabled)
+  {
+    responseCache.Begin(parameters.cache.directory.c_str(), parameters.cache.entries);
+  }
+
+  if (parameters.logos.enabled)
+  {
+    logoCache.Begin(parameters.logos.directory.c_str(), quoteLayout.logoSize, parameters.logos.ramSlots);
+  }
+
+  if (parameters.log.sdMirror)
+  {
+    LogEnableSdMirror("/quotebot.log", parameters.log.sdMirrorMaxFileSize, parameters.log.sdMirrorFiles);
+  }
+
+  quoteHistory.Begin(parameters.history.maxSymbols, parameters.history.points); // Series stay empty until quoted.
 
   ConnectWifi();
 
+  if (parameters.localApi.enabled)
+  {
+    LocalApiBegin(parameters.localApi.port, parameters.localApi.maxClients, parameters.localApi.metrics, parameters.localApi.configUpload);
+  }
+
+  if (parameters.peers.enabled)
+  {
+    std::vector<String> watchlist;
+    for (auto &symbolData : parameters.symbolData)
+    {
+      watchlist.push_back(symbolData.symbol);
+    }
+    if (peerSync.Begin(parameters.peers.group, parameters.peers.port, parameters.peers.staleSeconds, watchlist))
+    {
+      StartTask(PeerQuotesTask, peerTaskConfig);
+    }
+  }
+
   configTime(sys.time.gmtOffset_sec, sys.time.daylightOffset_sec, sys.time.ntpServer);
 
   sys.time.preMarketTimeRange = TimeRange(4, 0, 9, 29);
   sys.time.marketTimeRange = TimeRange(9, 30, 15, 59);
   sys.time.afterMarketTimeRange = TimeRange(16, 0, 21, 59);
 
+  for (auto &providerParameters : parameters.api.providers)
+  {
+    QuoteProvider *provider = CreateProvider(providerParameters, parameters.api.mode == ApiMode::Sandbox);
+    if (provider == NULL)
+    {
+      LOG_ERROR("API: Error, unknown API provider: %s", providerParameters.name.c_str());
+      continue;
+    }
+    provider->SetFields(RequiredQuoteFields());
+    providerManager.Add(provider);
+    LOG_INFO("API: provider %s, max fetches per day: %u", provider->Name().c_str(), provider->MaxRequestsPerDay());
+  }
+
+  if ((parameters.api.mode == ApiMode::Live || parameters.api.mode == ApiMode::Sandbox) && providerManager.Size() == 0)
+  {
+    Error(ErrorIDs::UnknownApi);
+  }
+
   CalcMillisecondsBetweenApiFetches();
 
-  Serial.printf("API: mode: %s\n", apiModeText[int(parameters.api.mode)]);
-  Serial.printf("API: max api (live) fetches per day: %u\n", parameters.api.maxRequestsPerDay);
-  Serial.printf("API: milliseconds per request: %lu\n", sys.millisecondsBetweenApiCalls);
+  LOG_INFO("API: mode: %s", apiModeText[int(parameters.api.mode)]);
+  LOG_INFO("API: milliseconds per request: %lu", sys.millisecondsBetweenApiCalls);
 
 }
 
 void loop()
 {
+  unsigned long loopStart = micros();
+
   ProcessDisplayBrightness();
 
   ProcessMarketState();
@@ -978,9 +2636,39 @@ void loop()
 
   ProcessAPIFetch();
 
-  ProcessIndicators();
+  ProcessFetchWatchdog();
+
+  ProcessParametersReload();
+
+  ProcessWatchlistAdditions();
+
+  ProcessAlerts();
+
+  peerSync.Process();
+
+  if (!symbolBrowser.Active())
+  {
+    ProcessIndicators();
+  }
 
   ProcessSymbolIncrement();
 
   ProcessDisplayUpdate();
+
+  MetricsObserveLoop(micros() - loopStart);
+  MetricsTaskBusy(loopTaskConfig.name, micros() - loopStart);
+
+  static unsigned long startStackCheck = 0;
+  if (millis() - startStackCheck > 10000)
+  {
+    startStackCheck = millis();
+    MetricsTaskStack(loopTaskConfig.name);
+  }
+
+  static unsigned long startTaskLog = millis();
+  if (millis() - startTaskLog > 60000)
+  {
+    startTaskLog = millis();
+    MetricsLogTasks();
+  }
 }
@@ -1,3 +1,6 @@
+#ifndef MAIN_H
+#define MAIN_H
+
 #include <Arduino.h>
 #include <vector>
 #include "timeRange.h"
@@ -36,21 +39,186 @@ struct System
   const unsigned long wifiTimeoutUntilNewScan = 30000; // milliseconds.
 };
 
+// Alert rule conditions, see priceAlerts.h.
+enum class AlertKind : uint8_t
+{
+  Above,
+  Below,
+  MovePercent,
+  Near52WeekHigh,
+  Near52WeekLow
+};
+
+const size_t alertKindCount = 5;
+static const char *const alertKindText[] = {"above", "below", "movePercent", "near52WeekHigh", "near52WeekLow"};
+
+// Rules of one symbol compiled to thresholds, one slot per kind.
+struct AlertSlots
+{
+  int64_t thresholds[alertKindCount] = {}; // Above, Below at fixedMaxDecimals whatever the quote's scale, the others in hundredths of a percent.
+  uint8_t rules = 0;  // Bit per AlertKind with a threshold.
+  uint8_t known = 0;  // Side established by a first quote.
+  uint8_t inZone = 0; // Fired, armed again past the hysteresis band.
+};
+
 struct SymbolData
 {
   String symbol = "";
   String companyName = "";
-  float openPrice = 0;
-  float currentPrice = 0;
-  float change = 0;
-  float changePercent = 0;
-  float peRatio = 0;
-  float week52High = 0;
-  float week52Low = 0;
+  uint8_t decimals = 2;      // Scale of the price fields (see fixedPoint.h).
+  int32_t openPrice = 0;
+  int32_t currentPrice = 0;
+  int32_t change = 0;
+  int32_t changePercent = 0; // Hundredths of a percent.
+  int32_t peRatio = 0;       // Hundredths.
+  int32_t week52High = 0;
+  int32_t week52Low = 0;
   unsigned long long latestUpdate = 0; // EPOCH in seconds.
   unsigned long long lastApiCall = 0;  // EPOCH in seconds.
   bool isValid = true;
   String errorString = "";
+  uint8_t fetchFailures = 0;          // Consecutive, for the retry backoff.
+  unsigned long long retryAfter = 0;  // EPOCH in seconds, not requested before.
+  uint32_t version = 0; // Incremented each time a quote is ingested.
+  AlertSlots alerts;
+};
+
+// Quote fields a source can provide, fields missing from a quote keep their current value.
+enum QuoteField : uint16_t
+{
+  QuoteFieldCompanyName = 1 << 0,
+  QuoteFieldLatestPrice = 1 << 1,
+  QuoteFieldPreviousClose = 1 << 2,
+  QuoteFieldChange = 1 << 3,
+  QuoteFieldChangePercent = 1 << 4,
+  QuoteFieldPeRatio = 1 << 5,
+  QuoteFieldWeek52High = 1 << 6,
+  QuoteFieldWeek52Low = 1 << 7,
+  QuoteFieldLatestUpdate = 1 << 8,
+  QuoteFieldAll = 0x01FF
+};
+
+// Fields each consumer reads. Requests ask the provider for the union of the active consumers.
+const uint16_t quoteFieldsSymbolScreen = QuoteFieldCompanyName | QuoteFieldLatestPrice | QuoteFieldChange | QuoteFieldChangePercent |
+                                         QuoteFieldPeRatio | QuoteFieldWeek52High | QuoteFieldWeek52Low | QuoteFieldLatestUpdate;
+const uint16_t quoteFieldsMatrix = QuoteFieldChange;
+const uint16_t quoteFieldsChart = QuoteFieldLatestPrice | QuoteFieldPreviousClose; // Reference line at the previous close.
+const uint16_t quoteFieldsShared = QuoteFieldAll; // Local API and peers hand quotes on whole.
+
+constexpr uint8_t QuoteFieldCount(uint16_t fields)
+{
+  return fields == 0 ? 0 : (fields & 1) + QuoteFieldCount(fields >> 1);
+}
+
+// Provider neutral quote, every source (API, demo) hands one of these to IngestQuote().
+struct Quote
+{
+  uint16_t fields = 0; // QuoteField bits present in this quote.
+  String companyName;
+  uint8_t decimals = 2;
+  int32_t openPrice = 0;
+  int32_t currentPrice = 0;
+  int32_t change = 0;
+  int32_t changePercent = 0;
+  int32_t peRatio = 0;
+  int32_t week52High = 0;
+  int32_t week52Low = 0;
+  unsigned long long latestUpdate = 0;
+};
+
+// Symbol data is written by the fetch tasks and read by the display loop.
+extern SemaphoreHandle_t symbolMutex;
+
+class SymbolLock
+{
+public:
+  SymbolLock()
+  {
+    xSemaphoreTake(symbolMutex, portMAX_DELAY);
+  }
+
+  ~SymbolLock()
+  {
+    xSemaphoreGive(symbolMutex);
+  }
+
+  SymbolLock(const SymbolLock &) = delete;
+  SymbolLock &operator=(const SymbolLock &) = delete;
+};
+
+// Held across blocking work by tasks that keep pointers or indices into parameters.symbolData,
+// the table is only reordered or shrunk by a holder. Taken before the SymbolLock.
+// A binary semaphore rather than a mutex, so the fetch watchdog can release it for a deleted task.
+extern SemaphoreHandle_t symbolTableMutex;
+
+class SymbolTableLock
+{
+public:
+  SymbolTableLock(TickType_t timeout = portMAX_DELAY)
+  {
+    locked = xSemaphoreTake(symbolTableMutex, timeout) == pdTRUE;
+  }
+
+  ~SymbolTableLock()
+  {
+    if (locked)
+    {
+      xSemaphoreGive(symbolTableMutex);
+    }
+  }
+
+  bool Locked() { return locked; }
+
+  SymbolTableLock(const SymbolTableLock &) = delete;
+  SymbolTableLock &operator=(const SymbolTableLock &) = delete;
+
+private:
+  bool locked;
+};
+
+struct Streaming
+{
+  bool enabled;
+  String url; // Overrides the provider's stream endpoint, e.g. a local test server.
+  int maxEventSize;
+  int ingestPerSecond;
+};
+
+struct StreamStats
+{
+  uint32_t messages;
+  uint32_t quotes;
+  uint32_t conflated; // Quotes replaced by a newer one before being ingested.
+  uint32_t ingested;
+  uint32_t parseErrors;
+  uint32_t oversized;
+  uint32_t reconnects;
+  uint64_t bytes;
+  uint32_t lastLatencyUs; // Receive to ingest.
+  uint32_t maxLatencyUs;
+  uint64_t totalLatencyUs;
+};
+
+struct Capture
+{
+  bool enabled;
+  String file;
+};
+
+struct Replay
+{
+  String file;
+  String provider; // Provider whose responses were captured.
+  float speed; // 1 is real time, 0 is as fast as possible.
+  bool loop;
+};
+
+struct Demo
+{
+  uint32_t seed;
+  float volatility; // Standard deviation of each tick, in percent.
+  int ticksPerSecond;
+  int symbolCount; // Synthetic symbols are added when above the watchlist size.
 };
 
 enum class ApiMode
@@ -58,26 +226,49 @@ enum class ApiMode
   Unknown,
   Demo,
   Sandbox,
-  Live
+  Live,
+  Replay
 };
 
-static const char *const apiModeText[] = {"Unknown", "Demo", "Sandbox", "Live"};
+static const char *const apiModeText[] = {"Unknown", "Demo", "Sandbox", "Live", "Replay"};
 
-struct Api
+struct ProviderParameters
 {
-  ApiMode mode;
-  String provider;
+  String name;
+  int priority; // Lowest value is tried first.
   String key;
   int maxRequestsPerDay;
   String sandboxKey;
   int sandboxMaxRequestsPerDay;
+  int batchSize; // Symbols per request, where the provider supports batching.
+};
 
-  
+// Deadline of each phase of a quote request, milliseconds.
+struct HttpTimeouts
+{
+  int dns;
+  int connect;
+  int tls;
+  int headers; // Longest wait between header lines.
+  int body;    // The whole body.
+
+  int Total() const { return dns + connect + tls + headers + body; }
+};
+
+struct Api
+{
+  ApiMode mode;
+  std::vector<ProviderParameters> providers; // Sorted by priority.
+  bool gzip; // Ask for compressed responses.
+  HttpTimeouts timeouts;
 };
 
 struct Display
 {
   int nextSymbolDelay;
+  int tapeSpeed;    // Ticker tape, pixels per second.
+  String priceFont; // Smooth font on the SD card for the price, empty for the built in font.
+  char thousandsSeparator;
   int brightnessMax;
   int brightnessMin;
   int dimStartHour;
@@ -115,6 +306,66 @@ struct Market
   bool fetchAfterMarketData;
 };
 
+struct Log
+{
+  String level;
+  bool sdMirror;
+  int sdMirrorMaxFileSize;
+  int sdMirrorFiles;
+};
+
+struct LocalApi
+{
+  bool enabled;
+  int port;
+  int maxClients; // Responses in flight, further requests get 503.
+  bool metrics;   // Serve /metrics for Prometheus.
+  bool configUpload; // Accept a replacement parameters.json, which holds the WiFi and API keys.
+};
+
+struct AlertRule
+{
+  String symbol;
+  AlertKind kind;
+  double value; // Price, or percent for the others.
+};
+
+struct Alerts
+{
+  bool enabled;
+  float hysteresisPercent; // Of the threshold, in percentage points for movePercent.
+  int flashSeconds;        // Matrix flash and banner.
+  String logFile;          // Fired alerts, empty for none.
+};
+
+struct Cache
+{
+  bool enabled;
+  String directory;
+  int entries; // Distinct request URLs kept.
+};
+
+struct Logos
+{
+  bool enabled;
+  String directory;
+  int ramSlots; // Most recently drawn logos kept in RAM.
+};
+
+struct Peers
+{
+  bool enabled;
+  String group; // Multicast address shared by the QuoteBots.
+  int port;
+  int staleSeconds; // Fetch a peer owned symbol ourselves after this long without a quote.
+};
+
+struct History
+{
+  int points;     // One per minute, 390 covers a regular session.
+  int maxSymbols; // Symbols past this have no history.
+};
+
 struct Parameters
 {
   std::vector<SymbolData> symbolData;
@@ -123,6 +374,18 @@ struct Parameters
   Market market;
   Display display;
   Matrix matrix;
+  Log log;
+  Demo demo;
+  Streaming streaming;
+  Capture capture;
+  Replay replay;
+  LocalApi localApi;
+  Cache cache;
+  Logos logos;
+  Alerts alerts;
+  std::vector<AlertRule> alertRules;
+  Peers peers;
+  History history;
   System system;
 };
 
@@ -143,6 +406,7 @@ struct Status
   bool time;
   bool symbolLocked;
   bool requestInProgess;
+  bool streaming;
 
   bool operator!=(Status const &s)
   {
@@ -151,7 +415,8 @@ struct Status
             api != s.api ||
             time != s.time ||
             symbolLocked != s.symbolLocked ||
-            requestInProgess != s.requestInProgess);
+            requestInProgess != s.requestInProgess ||
+            streaming != s.streaming);
   }
 };
 
@@ -159,8 +424,7 @@ enum class ErrorIDs
 {
   SdFailed,
   ParametersFailed,
-  UnknownApi,
-  InvalidApiKey
+  UnknownApi
 };
 
 enum class MarketState
@@ -174,6 +438,13 @@ enum class MarketState
   Closed
 };
 
+extern Parameters parameters;
+extern const char *parametersUploadFilePath; // Uploaded parameters.json waiting to be validated and applied.
+extern MarketState marketState;
+extern volatile uint32_t quoteGeneration; // Incremented under the SymbolLock on every symbol change.
+
 static const char *const marketStateDesciptionTop[] = {"Unknown", "Holiday", "Weekend", "Pre", "Open", "After", "Closed"};
 static const char *const marketStateDesciptionBottom[] = {"", "", "", "Hours", "", "Hours", ""};
-// static const char *const marketStateDesciptionLetter[] = {"U", "H", "W", "P", "M", "S", "C"};
\ No newline at end of file
+// static const char *const marketStateDesciptionLetter[] = {"U", "H", "W", "P", "M", "S", "C"};
+
+#endif
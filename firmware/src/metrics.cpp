@@ -0,0 +1,326 @@
+#include "metrics.h"
+#include <atomic>
+#include <WiFi.h>
+#include <esp_timer.h>
+#include "main.h"
+#include "providerManager.h"
+#include "peerSync.h"
+#include "logger.h"
+
+// 64 bit atomics take a lock on the Xtensa cores, every counter is 32 bits. Sums wrap, which
+// Prometheus treats as a counter reset. (is_always_lock_free needs C++17.)
+static_assert(ATOMIC_INT_LOCK_FREE == 2 && ATOMIC_LONG_LOCK_FREE == 2 && ATOMIC_POINTER_LOCK_FREE == 2,
+              "Metrics are recorded with lock free atomics.");
+
+// Fixed bucket histogram, values above the last bound only count toward +Inf.
+class Histogram
+{
+public:
+  static const size_t maxBounds = 10;
+
+  Histogram(const uint32_t (&bounds)[maxBounds], float unitSeconds) : bounds(bounds), unitSeconds(unitSeconds) {}
+
+  void Observe(uint32_t value)
+  {
+    size_t bucket = 0;
+    while (bucket < maxBounds && value > bounds[bucket])
+    {
+      bucket++;
+    }
+    counts[bucket].fetch_add(1, std::memory_order_relaxed);
+    sum.fetch_add(value, std::memory_order_relaxed);
+  }
+
+  // Buckets are cumulative in the exposition format.
+  void Write(Print &out, const char *name, const char *labels)
+  {
+    uint32_t cumulative = 0;
+    const char *separator = labels[0] ? "," : "";
+    for (size_t i = 0; i < maxBounds; i++)
+    {
+      cumulative += counts[i].load(std::memory_order_relaxed);
+      out.printf("%s_bucket{%s%sle=\"%g\"} %u\n", name, labels, separator, bounds[i] * unitSeconds, cumulative);
+    }
+    cumulative += counts[maxBounds].load(std::memory_order_relaxed);
+    out.printf("%s_bucket{%s%sle=\"+Inf\"} %u\n", name, labels, separator, cumulative);
+
+    char braced[48] = "";
+    if (labels[0])
+    {
+      snprintf(braced, sizeof(braced), "{%s}", labels);
+    }
+    out.printf("%s_sum%s %g\n", name, braced, double(sum.load(std::memory_order_relaxed)) * unitSeconds);
+    out.printf("%s_count%s %u\n", name, braced, cumulative);
+  }
+
+private:
+  const uint32_t (&bounds)[maxBounds];
+  const float unitSeconds;
+  std::atomic<uint32_t> counts[maxBounds + 1] = {};
+  std::atomic<uint32_t> sum{0}; // In the unit of the bounds, wraps after 71 minutes of microseconds.
+};
+
+static const uint32_t fetchBoundsMs[Histogram::maxBounds] = {25, 50, 100, 250, 500, 1000, 2500, 5000, 10000, 20000};
+static const uint32_t loopBoundsUs[Histogram::maxBounds] = {100, 250, 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000};
+static const uint32_t frameBoundsUs[Histogram::maxBounds] = {2500, 5000, 10000, 25000, 50000, 100000, 150000, 250000, 500000, 1000000};
+
+static const char *const fetchPhaseText[] = {"request", "parse", "apply", "total"};
+
+static Histogram fetchHistograms[int(FetchPhase::Count)] = {
+    {fetchBoundsMs, 0.001f},
+    {fetchBoundsMs, 0.001f},
+    {fetchBoundsMs, 0.001f},
+    {fetchBoundsMs, 0.001f}};
+static Histogram loopHistogram(loopBoundsUs, 0.000001f);
+static Histogram frameHistogram(frameBoundsUs, 0.000001f);
+
+// Codes the providers are known to answer with, anything else is counted as other.
+static const int httpCodes[] = {200, 304, 400, 401, 402, 403, 404, 429, 500, 502, 503, 504};
+static const size_t httpCodeCount = sizeof(httpCodes) / sizeof(httpCodes[0]);
+static std::atomic<uint32_t> httpCodeCounts[httpCodeCount + 2]; // Then other, then transport errors.
+
+static const char *const fetchTimeoutText[] = {"dns", "connect", "headers", "body", "cancelled", "aborted"};
+static std::atomic<uint32_t> fetchTimeouts[int(FetchTimeout::Count)];
+static std::atomic<uint32_t> fetchRecycles(0);
+
+static std::atomic<uint32_t> wifiReconnects(0);
+
+struct TaskStats
+{
+  std::atomic<const char *> name;
+  std::atomic<uint32_t> minFreeBytes;
+  std::atomic<int> core;
+  std::atomic<uint32_t> busyUs; // Wraps after 71 minutes busy.
+  uint32_t loggedBusyUs;        // Only touched by MetricsLogTasks().
+};
+
+static const size_t maxTasks = 8;
+static TaskStats taskStats[maxTasks];
+
+void MetricsObserveFetch(FetchPhase phase, uint32_t milliseconds)
+{
+  fetchHistograms[int(phase)].Observe(milliseconds);
+}
+
+void MetricsCountHttpCode(int httpCode)
+{
+  size_t index = httpCodeCount;
+  if (httpCode < 0)
+  {
+    index = httpCodeCount + 1;
+  }
+  for (size_t i = 0; i < httpCodeCount; i++)
+  {
+    if (httpCodes[i] == httpCode)
+    {
+      index = i;
+      break;
+    }
+  }
+  httpCodeCounts[index].fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsCountFetchTimeout(FetchTimeout phase)
+{
+  fetchTimeouts[int(phase)].fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsCountFetchRecycle()
+{
+  fetchRecycles.fetch_add(1, std::memory_order_relaxed);
+}
+
+void MetricsObserveLoop(uint32_t microseconds)
+{
+  loopHistogram.Observe(microseconds);
+}
+
+void MetricsObserveFrame(uint32_t microseconds)
+{
+  frameHistogram.Observe(microseconds);
+}
+
+void MetricsCountWifiReconnect()
+{
+  wifiReconnects.fetch_add(1, std::memory_order_relaxed);
+}
+
+// Slot for name, claimed on first use. NULL when every slot is taken.
+static TaskStats *TaskSlot(const char *name)
+{
+  for (size_t i = 0; i < maxTasks; i++)
+  {
+    const char *slotName = taskStats[i].name.load(std::memory_order_acquire);
+    if (slotName == NULL)
+    {
+      // Claim a free slot, another task may get there first.
+      const char *expected = NULL;
+      if (taskStats[i].name.compare_exchange_strong(expected, name))
+      {
+        taskStats[i].minFreeBytes.store(UINT32_MAX, std::memory_order_relaxed);
+        taskStats[i].core.store(-1, std::memory_order_relaxed);
+        return &taskStats[i];
+      }
+      slotName = expected;
+    }
+
+    if (slotName == name)
+    {
+      return &taskStats[i];
+    }
+  }
+  return NULL;
+}
+
+void MetricsTaskStack(const char *name)
+{
+  uint32_t freeBytes = uxTaskGetStackHighWaterMark(NULL); // Bytes on the ESP32 port.
+  TaskStats *stats = TaskSlot(name);
+  if (stats == NULL)
+  {
+    return;
+  }
+
+  stats->core.store(xPortGetCoreID(), std::memory_order_relaxed);
+  uint32_t previous = stats->minFreeBytes.load(std::memory_order_relaxed);
+  while (freeBytes < previous && !stats->minFreeBytes.compare_exchange_weak(previous, freeBytes))
+  {
+  }
+}
+
+void MetricsTaskBusy(const char *name, uint32_t microseconds)
+{
+  TaskStats *stats = TaskSlot(name);
+  if (stats != NULL)
+  {
+    stats->busyUs.fetch_add(microseconds, std::memory_order_relaxed);
+  }
+}
+
+void MetricsLogTasks()
+{
+  static int64_t lastLogUs = esp_timer_get_time();
+  int64_t now = esp_timer_get_time();
+  uint64_t elapsedUs = max(now - lastLogUs, (int64_t)1);
+  lastLogUs = now;
+
+  for (size_t i = 0; i < maxTasks; i++)
+  {
+    const char *name = taskStats[i].name.load(std::memory_order_acquire);
+    if (name == NULL)
+    {
+      continue;
+    }
+    uint32_t busyUs = taskStats[i].busyUs.load(std::memory_order_relaxed);
+    uint32_t minFree = taskStats[i].minFreeBytes.load(std::memory_order_relaxed);
+    LOG_INFO("TASK: %s core %d, %u bytes stack free, %.1f%% busy.", name, taskStats[i].core.load(std::memory_order_relaxed),
+             minFree == UINT32_MAX ? 0 : minFree, uint32_t(busyUs - taskStats[i].loggedBusyUs) * 100.0 / elapsedUs);
+    taskStats[i].loggedBusyUs = busyUs;
+  }
+}
+
+static void WriteHeader(Print &out, const char *name, const char *type, const char *help)
+{
+  out.printf("# HELP %s %s\n# TYPE %s %s\n", name, help, name, type);
+}
+
+void MetricsWrite(Print &out)
+{
+  WriteHeader(out, "quotebot_fetch_duration_seconds", "histogram", "Quote fetch time by phase.");
+  for (int i = 0; i < int(FetchPhase::Count); i++)
+  {
+    char labels[24];
+    snprintf(labels, sizeof(labels), "phase=\"%s\"", fetchPhaseText[i]);
+    fetchHistograms[i].Write(out, "quotebot_fetch_duration_seconds", labels);
+  }
+
+  WriteHeader(out, "quotebot_http_responses_total", "counter", "Provider responses by HTTP status code.");
+  for (size_t i = 0; i < httpCodeCount; i++)
+  {
+    out.printf("quotebot_http_responses_total{code=\"%d\"} %u\n", httpCodes[i], httpCodeCounts[i].load(std::memory_order_relaxed));
+  }
+  out.printf("quotebot_http_responses_total{code=\"other\"} %u\n", httpCodeCounts[httpCodeCount].load(std::memory_order_relaxed));
+  out.printf("quotebot_http_responses_total{code=\"transport_error\"} %u\n", httpCodeCounts[httpCodeCount + 1].load(std::memory_order_relaxed));
+
+  WriteHeader(out, "quotebot_fetch_timeouts_total", "counter", "Quote requests abandoned, by the phase that ran out of time.");
+  for (int i = 0; i < int(FetchTimeout::Count); i++)
+  {
+    out.printf("quotebot_fetch_timeouts_total{phase=\"%s\"} %u\n", fetchTimeoutText[i], fetchTimeouts[i].load(std::memory_order_relaxed));
+  }
+  WriteHeader(out, "quotebot_fetch_recycles_total", "counter", "Stuck fetch tasks replaced by the watchdog.");
+  out.printf("quotebot_fetch_recycles_total %u\n", fetchRecycles.load(std::memory_order_relaxed));
+
+  // Copied under the provider manager's lock, the fetch task updates them.
+  std::vector<ProviderStats> providerStats;
+  for (size_t i = 0; i < providerManager.Size(); i++)
+  {
+    providerStats.push_back(providerManager.Stats(i));
+  }
+  WriteHeader(out, "quotebot_api_budget_remaining", "gauge", "Requests left in today's provider budget.");
+  for (size_t i = 0; i < providerStats.size(); i++)
+  {
+    int remaining = providerManager.Provider(i)->MaxRequestsPerDay() - providerStats[i].requestsToday;
+    out.printf("quotebot_api_budget_remaining{provider=\"%s\"} %d\n", providerManager.Provider(i)->Name().c_str(), max(remaining, 0));
+  }
+  WriteHeader(out, "quotebot_api_requests_total", "counter", "Requests sent to the provider.");
+  for (size_t i = 0; i < providerStats.size(); i++)
+  {
+    out.printf("quotebot_api_requests_total{provider=\"%s\"} %u\n", providerManager.Provider(i)->Name().c_str(), providerStats[i].requests);
+  }
+  WriteHeader(out, "quotebot_api_failovers_total", "counter", "Times the provider was abandoned for the next one.");
+  for (size_t i = 0; i < providerStats.size(); i++)
+  {
+    out.printf("quotebot_api_failovers_total{provider=\"%s\"} %u\n", providerManager.Provider(i)->Name().c_str(), providerStats[i].failovers);
+  }
+
+  WriteHeader(out, "quotebot_loop_duration_seconds", "histogram", "Main loop iteration time.");
+  loopHistogram.Write(out, "quotebot_loop_duration_seconds", "");
+
+  WriteHeader(out, "quotebot_display_frame_seconds", "histogram", "Time to draw a symbol page.");
+  frameHistogram.Write(out, "quotebot_display_frame_seconds", "");
+
+  WriteHeader(out, "quotebot_heap_free_bytes", "gauge", "Free heap.");
+  out.printf("quotebot_heap_free_bytes %u\n", ESP.getFreeHeap());
+  WriteHeader(out, "quotebot_heap_min_free_bytes", "gauge", "Lowest free heap since boot.");
+  out.printf("quotebot_heap_min_free_bytes %u\n", ESP.getMinFreeHeap());
+  WriteHeader(out, "quotebot_heap_largest_free_block_bytes", "gauge", "Largest allocatable heap block.");
+  out.printf("quotebot_heap_largest_free_block_bytes %u\n", ESP.getMaxAllocHeap());
+
+  WriteHeader(out, "quotebot_task_stack_free_bytes", "gauge", "Task stack high water mark.");
+  for (size_t i = 0; i < maxTasks; i++)
+  {
+    const char *name = taskStats[i].name.load(std::memory_order_acquire);
+    uint32_t minFree = taskStats[i].minFreeBytes.load(std::memory_order_relaxed);
+    if (name != NULL && minFree != UINT32_MAX)
+    {
+      out.printf("quotebot_task_stack_free_bytes{task=\"%s\",core=\"%d\"} %u\n", name, taskStats[i].core.load(std::memory_order_relaxed), minFree);
+    }
+  }
+  WriteHeader(out, "quotebot_task_busy_seconds_total", "counter", "Time each task spent working rather than blocked.");
+  for (size_t i = 0; i < maxTasks; i++)
+  {
+    const char *name = taskStats[i].name.load(std::memory_order_acquire);
+    if (name != NULL)
+    {
+      out.printf("quotebot_task_busy_seconds_total{task=\"%s\"} %.3f\n", name, taskStats[i].busyUs.load(std::memory_order_relaxed) / 1000000.0);
+    }
+  }
+
+  WriteHeader(out, "quotebot_wifi_rssi_dbm", "gauge", "WiFi signal strength.");
+  out.printf("quotebot_wifi_rssi_dbm %d\n", WiFi.RSSI());
+  WriteHeader(out, "quotebot_wifi_reconnects_total", "counter", "WiFi reconnect attempts.");
+  out.printf("quotebot_wifi_reconnects_total %u\n", wifiReconnects.load(std::memory_order_relaxed));
+
+  WriteHeader(out, "quotebot_peers", "gauge", "QuoteBots sharing quotes with this one.");
+  out.printf("quotebot_peers %u\n", unsigned(peerSync.PeerCount()));
+
+  LogStats logStats = LogGetStats();
+  WriteHeader(out, "quotebot_log_dropped_total", "counter", "Log messages dropped on a full buffer.");
+  out.printf("quotebot_log_dropped_total %u\n", logStats.dropped);
+
+  WriteHeader(out, "quotebot_quote_generation", "counter", "Symbol table changes since boot.");
+  out.printf("quotebot_quote_generation %u\n", quoteGeneration);
+
+  WriteHeader(out, "quotebot_uptime_seconds", "counter", "Time since boot.");
+  out.printf("quotebot_uptime_seconds %lu\n", millis() / 1000);
+}
@@ -0,0 +1,52 @@
+/*
+    metrics.h
+
+    Counters and histograms served at /metrics in the Prometheus text format.
+    Recording is a few relaxed atomic adds, cheap enough to leave on in production.
+*/
+
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <Arduino.h>
+
+enum class FetchPhase
+{
+  Request, // Connect, send and wait for the response headers.
+  Parse,   // Read and parse the body.
+  Apply,   // Ingest the parsed quotes.
+  Total,
+  Count
+};
+
+enum class FetchTimeout
+{
+  Dns,
+  Connect, // TCP connect and TLS handshake, the client does not tell them apart.
+  Headers,
+  Body,
+  Cancelled, // By the fetch watchdog.
+  Aborted,   // Socket shut down by the fetch watchdog when the cancel was not noticed.
+  Count
+};
+
+void MetricsObserveFetch(FetchPhase phase, uint32_t milliseconds);
+void MetricsCountFetchTimeout(FetchTimeout phase);
+void MetricsCountFetchRecycle(); // Stuck fetch task deleted and restarted.
+void MetricsCountHttpCode(int httpCode); // Negative codes are HTTPClient transport errors.
+void MetricsObserveLoop(uint32_t microseconds);
+void MetricsObserveFrame(uint32_t microseconds);
+void MetricsCountWifiReconnect();
+
+// Record the calling task's stack high water mark and core under name (a string literal).
+void MetricsTaskStack(const char *name);
+
+// Add time the calling task spent working, not blocked, under name.
+void MetricsTaskBusy(const char *name, uint32_t microseconds);
+
+// One log line per task: core, stack headroom and busy share since the last call.
+void MetricsLogTasks();
+
+void MetricsWrite(Print &out);
+
+#endif
@@ -0,0 +1,126 @@
+#include "overviewGrid.h"
+#include "fixedPoint.h"
+#include "layout.h"
+
+static const int titleHeight = frameLayout.titleHeight;
+static const int areaTop = frameLayout.centerTop;
+static const int areaHeight = frameLayout.centerHeight; // Up to the indicator row line.
+static const int areaLeft = 1;
+static const int areaWidth = screen.width - 2;
+static const size_t columns = 4;
+static const uint16_t borderColor = 0x4208;
+
+void OverviewGrid::Open(size_t count, size_t firstSymbol)
+{
+  active = true;
+  symbolCount = count;
+  first = firstSymbol - firstSymbol % maxTiles;
+  if (first >= symbolCount)
+  {
+    first = 0;
+  }
+  tiles = min(symbolCount - first, maxTiles);
+
+  // Fewer rows make taller tiles with larger text.
+  rows = max((tiles + columns - 1) / columns, (size_t)3);
+  tileWidth = areaWidth / columns;
+  tileHeight = areaHeight / rows;
+  for (size_t i = 0; i < maxTiles; i++)
+  {
+    versions[i] = 0;
+    painted[i] = false;
+  }
+
+  tft.fillRect(areaLeft, areaTop, areaWidth, areaHeight, TFT_BLACK);
+  DrawTitle();
+}
+
+void OverviewGrid::NextPage()
+{
+  Open(symbolCount, first + maxTiles < symbolCount ? first + maxTiles : 0);
+}
+
+void OverviewGrid::DrawTitle()
+{
+  char buf[32];
+  tft.fillRect(1, 1, tft.width() - 2, titleHeight - 1, TFT_BLACK); // Also clears the symbol box divider.
+  tft.setTextFont(0);
+  tft.setTextSize(2);
+  tft.setTextPadding(0);
+  tft.setTextDatum(ML_DATUM);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  tft.drawString("Overview", 8, titleHeight / 2);
+
+  size_t pages = (symbolCount + maxTiles - 1) / maxTiles;
+  if (pages > 1)
+  {
+    snprintf(buf, sizeof(buf), "%u/%u >", first / maxTiles + 1, pages);
+    tft.setTextDatum(MR_DATUM);
+    tft.drawString(buf, tft.width() - 8, titleHeight / 2);
+  }
+}
+
+size_t OverviewGrid::Update(const QuoteTileSource &source)
+{
+  size_t repainted = 0;
+  QuoteTile tile;
+  for (size_t slot = 0; slot < tiles; slot++)
+  {
+    if (source(first + slot, versions[slot], !painted[slot], &tile))
+    {
+      DrawTile(slot, tile);
+      versions[slot] = tile.version;
+      painted[slot] = true;
+      repainted++;
+    }
+  }
+  return repainted;
+}
+
+int OverviewGrid::SymbolAt(uint16_t x, uint16_t y)
+{
+  if (y < areaTop || y >= areaTop + tileHeight * rows || x < areaLeft || x >= areaLeft + tileWidth * columns)
+  {
+    return -1;
+  }
+  size_t slot = ((y - areaTop) / tileHeight) * columns + (x - areaLeft) / tileWidth;
+  return slot < tiles ? int(first + slot) : -1;
+}
+
+// Draws inside the tile's own rectangle only.
+void OverviewGrid::DrawTile(size_t slot, const QuoteTile &tile)
+{
+  char buf[16];
+  int x = areaLeft + (slot % columns) * tileWidth;
+  int y = areaTop + (slot / columns) * tileHeight;
+  bool large = tileHeight >= 40;
+
+  tft.fillRect(x + 1, y + 1, tileWidth - 2, tileHeight - 2, TFT_BLACK);
+  tft.drawRect(x, y, tileWidth, tileHeight, borderColor);
+
+  tft.setTextFont(0);
+  tft.setTextPadding(0);
+  tft.setTextSize(large ? 2 : 1);
+  tft.setTextDatum(TL_DATUM);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  tft.drawString(tile.symbol, x + 4, y + 4);
+
+  if (tile.valid)
+  {
+    FormatFixed(buf, sizeof(buf), tile.price, tile.decimals, tile.decimals);
+    tft.setTextColor(tile.change > 0 ? TFT_GREEN : tile.change < 0 ? TFT_RED : TFT_WHITE, TFT_BLACK);
+  }
+  else
+  {
+    strcpy(buf, "--");
+    tft.setTextColor(TFT_DARKGREY, TFT_BLACK);
+  }
+
+  // Large prices drop to the small font rather than overflow into the next tile.
+  if (tft.textWidth(buf) > tileWidth - 8)
+  {
+    tft.setTextSize(1);
+  }
+  tft.setTextDatum(BR_DATUM);
+  tft.drawString(buf, x + tileWidth - 4, y + tileHeight - 3);
+}
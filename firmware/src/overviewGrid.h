@@ -0,0 +1,55 @@
+/*
+    overviewGrid.h
+
+    Overview page: up to maxTiles symbols as tiles in the center area,
+    each with its ticker and price coloured by the day's change. Tiles
+    remember the quote version they show and only a tile whose version
+    changed is repainted, within its own rectangle. Longer watchlists are
+    split into pages, the title bar shows the page and flips to the next.
+*/
+
+#ifndef OVERVIEWGRID_H
+#define OVERVIEWGRID_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "quoteTile.h"
+
+class OverviewGrid
+{
+public:
+    static const size_t maxTiles = 24;
+
+    OverviewGrid(TFT_eSPI &tft) : tft(tft) {}
+
+    // Lays out the page holding first for symbolCount symbols and clears it.
+    void Open(size_t symbolCount, size_t first = 0);
+    void Close() { active = false; }
+    bool Active() { return active; }
+    size_t First() { return first; }
+
+    void NextPage();
+
+    // Repaints the tiles whose quote changed, returns how many were.
+    size_t Update(const QuoteTileSource &source);
+
+    // Symbol index of the tile at x, y, -1 outside the tiles.
+    int SymbolAt(uint16_t x, uint16_t y);
+
+private:
+    void DrawTitle();
+    void DrawTile(size_t slot, const QuoteTile &tile);
+
+    TFT_eSPI &tft;
+    bool active = false;
+    size_t symbolCount = 0;
+    size_t first = 0; // Symbol index of the page's first tile.
+    size_t tiles = 0; // On this page.
+    size_t rows = 0;
+    int tileWidth = 0;
+    int tileHeight = 0;
+    uint32_t versions[maxTiles];
+    bool painted[maxTiles];
+};
+
+#endif
@@ -0,0 +1,202 @@
+#include "peerDatagram.h"
+#include "fixedPoint.h"
+
+// Little endian field writer and reader over a datagram buffer.
+class Packer
+{
+public:
+  Packer(uint8_t *buf, size_t size) : buf(buf), size(size) {}
+
+  void Bytes(const void *data, size_t length)
+  {
+    if (position + length <= size)
+    {
+      memcpy(buf + position, data, length);
+    }
+    position += length;
+  }
+
+  template <typename T>
+  void Put(T value)
+  {
+    Bytes(&value, sizeof(value)); // The ESP32 is little endian.
+  }
+
+  void Text(const char *text, size_t maxLength)
+  {
+    uint8_t length = min(strlen(text), maxLength);
+    Put(length);
+    Bytes(text, length);
+  }
+
+  // Zero when the message did not fit.
+  size_t Length() { return position <= size ? position : 0; }
+
+private:
+  uint8_t *buf;
+  size_t size;
+  size_t position = 0;
+};
+
+class Unpacker
+{
+public:
+  Unpacker(const uint8_t *data, size_t length) : data(data), length(length) {}
+
+  template <typename T>
+  T Get()
+  {
+    T value = T();
+    if (position + sizeof(T) <= length)
+    {
+      memcpy(&value, data + position, sizeof(T));
+    }
+    position += sizeof(T);
+    return value;
+  }
+
+  // Longer texts than fit text are rejected, not cut.
+  void Text(char *text, size_t size)
+  {
+    uint8_t textLength = Get<uint8_t>();
+    text[0] = 0;
+    if (textLength >= size)
+    {
+      position = length + 1;
+      return;
+    }
+    if (position + textLength <= length)
+    {
+      memcpy(text, data + position, textLength);
+      text[textLength] = 0;
+    }
+    position += textLength;
+  }
+
+  bool Ok() { return position <= length; }
+
+private:
+  const uint8_t *data;
+  size_t length;
+  size_t position = 0;
+};
+
+static void PutHeader(Packer &packer, uint8_t type, uint32_t deviceId)
+{
+  packer.Bytes("QBP1", 4);
+  packer.Put(type);
+  packer.Put(deviceId);
+}
+
+uint32_t PeerHashSymbol(const char *symbol)
+{
+  uint32_t hash = 2166136261u;
+  for (; *symbol; symbol++)
+  {
+    hash = (hash ^ (uint8_t)toupper(*symbol)) * 16777619u;
+  }
+  return hash;
+}
+
+bool PeerDecodeHeader(const uint8_t *data, size_t length, uint8_t *type, uint32_t *deviceId)
+{
+  if (length < peerHeaderSize || memcmp(data, "QBP1", 4) != 0)
+  {
+    return false;
+  }
+  *type = data[4];
+  memcpy(deviceId, data + 5, 4);
+  return true;
+}
+
+size_t PeerEncodeAnnounce(uint8_t *buf, size_t size, uint32_t deviceId, const std::vector<uint32_t> &symbolHashes)
+{
+  Packer packer(buf, size);
+  size_t count = min(symbolHashes.size(), (peerMaxDatagramSize - peerHeaderSize - 2) / 4);
+
+  PutHeader(packer, peerMessageAnnounce, deviceId);
+  packer.Put<uint16_t>(count);
+  for (size_t i = 0; i < count; i++)
+  {
+    packer.Put<uint32_t>(symbolHashes[i]);
+  }
+  return packer.Length();
+}
+
+size_t PeerEncodeQuote(uint8_t *buf, size_t size, uint32_t deviceId, const char *symbol, const Quote &quote)
+{
+  Packer packer(buf, size);
+  PutHeader(packer, peerMessageQuote, deviceId);
+  packer.Text(symbol, peerMaxSymbolLength);
+  packer.Put<uint16_t>(quote.fields);
+  packer.Put<uint8_t>(quote.decimals);
+  packer.Put<int32_t>(quote.openPrice);
+  packer.Put<int32_t>(quote.currentPrice);
+  packer.Put<int32_t>(quote.change);
+  packer.Put<int32_t>(quote.changePercent);
+  packer.Put<int32_t>(quote.peRatio);
+  packer.Put<int32_t>(quote.week52High);
+  packer.Put<int32_t>(quote.week52Low);
+  packer.Put<uint64_t>(quote.latestUpdate);
+  packer.Text((quote.fields & QuoteFieldCompanyName) ? quote.companyName.c_str() : "", peerMaxCompanyNameLength);
+  return packer.Length();
+}
+
+bool PeerDecodeAnnounce(const uint8_t *data, size_t length, std::vector<uint32_t> *symbolHashes)
+{
+  if (length < peerHeaderSize + 2)
+  {
+    return false;
+  }
+  Unpacker unpacker(data + peerHeaderSize, length - peerHeaderSize);
+  uint16_t count = unpacker.Get<uint16_t>();
+  if (count * 4u > length - peerHeaderSize - 2)
+  {
+    return false;
+  }
+
+  symbolHashes->resize(count);
+  for (auto &hash : *symbolHashes)
+  {
+    hash = unpacker.Get<uint32_t>();
+  }
+  return true;
+}
+
+bool PeerDecodeQuote(const uint8_t *data, size_t length, PeerQuote *quote)
+{
+  if (length < peerHeaderSize)
+  {
+    return false;
+  }
+  Unpacker unpacker(data + peerHeaderSize, length - peerHeaderSize);
+  unpacker.Text(quote->symbol, sizeof(quote->symbol));
+  quote->fields = unpacker.Get<uint16_t>();
+  quote->decimals = unpacker.Get<uint8_t>();
+  quote->openPrice = unpacker.Get<int32_t>();
+  quote->currentPrice = unpacker.Get<int32_t>();
+  quote->change = unpacker.Get<int32_t>();
+  quote->changePercent = unpacker.Get<int32_t>();
+  quote->peRatio = unpacker.Get<int32_t>();
+  quote->week52High = unpacker.Get<int32_t>();
+  quote->week52Low = unpacker.Get<int32_t>();
+  quote->latestUpdate = unpacker.Get<uint64_t>();
+  unpacker.Text(quote->companyName, sizeof(quote->companyName));
+
+  return unpacker.Ok() && quote->symbol[0] && quote->decimals <= fixedMaxDecimals;
+}
+
+void PeerQuoteToQuote(const PeerQuote &peerQuote, Quote *quote)
+{
+  quote->fields = peerQuote.fields;
+  quote->companyName = peerQuote.companyName;
+  quote->decimals = peerQuote.decimals;
+  quote->openPrice = peerQuote.openPrice;
+  quote->currentPrice = peerQuote.currentPrice;
+  quote->change = peerQuote.change;
+  quote->changePercent = peerQuote.changePercent;
+  quote->peRatio = peerQuote.peRatio;
+  quote->week52High = peerQuote.week52High;
+  quote->week52Low = peerQuote.week52Low;
+  quote->latestUpdate = peerQuote.latestUpdate;
+}
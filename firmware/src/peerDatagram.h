@@ -0,0 +1,62 @@
+/*
+    peerDatagram.h
+
+    Encoding of the datagrams QuoteBots exchange in peerSync.h, kept apart
+    from the sockets so it can be checked on the host.
+
+    Datagrams (little endian), any host UDP socket joined to the group can take part:
+      header:   "QBP1", uint8 type, uint32 device id
+      announce: type 1, uint16 count, count * uint32 symbol hash (FNV-1a of the upper case symbol)
+      quote:    type 2, uint8 symbol length, symbol, uint16 fields (QuoteField bits),
+                uint8 decimals, int32 previous close, price, change, change percent,
+                pe ratio, 52 week high, 52 week low, uint64 latest update,
+                uint8 company name length, company name
+*/
+
+#ifndef PEERDATAGRAM_H
+#define PEERDATAGRAM_H
+
+#include <Arduino.h>
+#include <vector>
+#include "main.h"
+
+const uint8_t peerMessageAnnounce = 1;
+const uint8_t peerMessageQuote = 2;
+const size_t peerHeaderSize = 9;
+const size_t peerMaxDatagramSize = 1400; // Below the usual MTU, no fragmentation.
+const size_t peerMaxSymbolLength = 16;
+const size_t peerMaxCompanyNameLength = 64;
+
+// A quote datagram decoded, plain data so it can be queued between tasks.
+struct PeerQuote
+{
+    char symbol[peerMaxSymbolLength + 1];
+    char companyName[peerMaxCompanyNameLength + 1];
+    uint16_t fields;
+    uint8_t decimals;
+    int32_t openPrice;
+    int32_t currentPrice;
+    int32_t change;
+    int32_t changePercent;
+    int32_t peRatio;
+    int32_t week52High;
+    int32_t week52Low;
+    uint64_t latestUpdate;
+};
+
+uint32_t PeerHashSymbol(const char *symbol);
+
+// Message type and sender of a datagram, false when it is not one of ours.
+bool PeerDecodeHeader(const uint8_t *data, size_t length, uint8_t *type, uint32_t *deviceId);
+
+// Datagram lengths, 0 when buf is too small.
+size_t PeerEncodeAnnounce(uint8_t *buf, size_t size, uint32_t deviceId, const std::vector<uint32_t> &symbolHashes);
+size_t PeerEncodeQuote(uint8_t *buf, size_t size, uint32_t deviceId, const char *symbol, const Quote &quote);
+
+// Whole datagrams, header included. False when truncated or out of range.
+bool PeerDecodeAnnounce(const uint8_t *data, size_t length, std::vector<uint32_t> *symbolHashes);
+bool PeerDecodeQuote(const uint8_t *data, size_t length, PeerQuote *quote);
+
+void PeerQuoteToQuote(const PeerQuote &peerQuote, Quote *quote);
+
+#endif
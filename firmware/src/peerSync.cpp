@@ -0,0 +1,261 @@
+#include "peerSync.h"
+#include <algorithm>
+#include "logger.h"
+
+static const unsigned long announceIntervalMs = 15000;
+static const unsigned long peerTimeoutMs = 3 * announceIntervalMs;
+static const size_t quoteQueueLength = 8;
+
+// Rendezvous score, the device with the highest score for a symbol owns it.
+static uint32_t Score(uint32_t deviceId, uint32_t symbolHash)
+{
+  uint32_t x = deviceId ^ symbolHash;
+  x ^= x >> 16;
+  x *= 0x85ebca6b;
+  x ^= x >> 13;
+  x *= 0xc2b2ae35;
+  x ^= x >> 16;
+  return x;
+}
+
+bool PeerSync::Begin(const String &group, uint16_t groupPort, uint32_t staleSeconds, const std::vector<String> &watchlist)
+{
+  if (!groupAddress.fromString(group))
+  {
+    LOG_ERROR("PEER: Invalid multicast group %s", group.c_str());
+    return false;
+  }
+
+  port = groupPort;
+  staleMs = staleSeconds * 1000UL;
+  deviceId = (uint32_t)(ESP.getEfuseMac() >> 16) ^ (uint32_t)ESP.getEfuseMac();
+  mutex = xSemaphoreCreateMutex();
+  quotes = xQueueCreate(quoteQueueLength, sizeof(QueuedQuote));
+
+  SetWatchlist(watchlist);
+
+  if (!udp.listenMulticast(groupAddress, port))
+  {
+    LOG_ERROR("PEER: Unable to join %s:%u", group.c_str(), port);
+    return false;
+  }
+
+  udp.onPacket([this](AsyncUDPPacket &packet) { OnPacket(packet); });
+  enabled = true;
+  SendAnnounce();
+
+  LOG_INFO("PEER: Device %08X joined %s:%u", deviceId, group.c_str(), port);
+  return true;
+}
+
+void PeerSync::Process()
+{
+  if (!enabled || millis() - lastAnnounce < announceIntervalMs)
+  {
+    return;
+  }
+
+  SendAnnounce();
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  size_t previousCount = peers.size();
+  peers.erase(std::remove_if(peers.begin(), peers.end(), [](const Peer &peer) { return millis() - peer.lastSeen > peerTimeoutMs; }), peers.end());
+  size_t count = peers.size();
+  xSemaphoreGive(mutex);
+
+  if (count != previousCount)
+  {
+    LOG_INFO("PEER: %u peer(s) left, %u remaining.", previousCount - count, count);
+  }
+}
+
+void PeerSync::SetWatchlist(const std::vector<String> &watchlist)
+{
+  std::vector<uint32_t> hashes;
+  std::vector<unsigned long> lastQuotes(watchlist.size(), 0);
+  for (size_t i = 0; i < watchlist.size(); i++)
+  {
+    hashes.push_back(PeerHashSymbol(watchlist[i].c_str()));
+    for (size_t j = 0; j < symbols.size(); j++)
+    {
+      if (symbols[j].equalsIgnoreCase(watchlist[i]))
+      {
+        lastQuotes[i] = lastPeerQuote[j];
+      }
+    }
+  }
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  symbols = watchlist;
+  symbolHashes.swap(hashes);
+  lastPeerQuote.swap(lastQuotes);
+  xSemaphoreGive(mutex);
+
+  if (enabled)
+  {
+    SendAnnounce();
+  }
+}
+
+bool PeerSync::ShouldFetch(size_t symbolIndex)
+{
+  if (!enabled || symbolIndex >= symbols.size())
+  {
+    return true;
+  }
+
+  // The owner has not delivered in time, or never has.
+  unsigned long lastQuote = lastPeerQuote[symbolIndex];
+  if (lastQuote == 0 || millis() - lastQuote > staleMs)
+  {
+    return true;
+  }
+
+  uint32_t symbolHash = symbolHashes[symbolIndex];
+  uint32_t ownScore = Score(deviceId, symbolHash);
+  bool owner = true;
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  for (auto &peer : peers)
+  {
+    if (std::binary_search(peer.symbolHashes.begin(), peer.symbolHashes.end(), symbolHash) &&
+        Score(peer.id, symbolHash) > ownScore)
+    {
+      owner = false;
+      break;
+    }
+  }
+  xSemaphoreGive(mutex);
+
+  return owner;
+}
+
+void PeerSync::Publish(size_t symbolIndex, const Quote &quote)
+{
+  if (!enabled || symbolIndex >= symbols.size())
+  {
+    return;
+  }
+
+  uint8_t buf[160];
+  size_t length = PeerEncodeQuote(buf, sizeof(buf), deviceId, symbols[symbolIndex].c_str(), quote);
+  if (length > 0)
+  {
+    udp.writeTo(buf, length, groupAddress, port);
+  }
+}
+
+bool PeerSync::Receive(PeerQuote *quote, size_t *symbolIndex, TickType_t wait)
+{
+  QueuedQuote queued;
+  if (!enabled || xQueueReceive(quotes, &queued, wait) != pdTRUE)
+  {
+    return false;
+  }
+  *quote = queued.quote;
+  *symbolIndex = queued.symbolIndex;
+  return true;
+}
+
+size_t PeerSync::PeerCount()
+{
+  if (!enabled)
+  {
+    return 0;
+  }
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  size_t count = peers.size();
+  xSemaphoreGive(mutex);
+  return count;
+}
+
+void PeerSync::SendAnnounce()
+{
+  static uint8_t buf[peerMaxDatagramSize];
+  size_t length = PeerEncodeAnnounce(buf, sizeof(buf), deviceId, symbolHashes);
+  udp.writeTo(buf, length, groupAddress, port);
+  lastAnnounce = millis();
+}
+
+void PeerSync::OnPacket(AsyncUDPPacket &packet)
+{
+  const uint8_t *data = packet.data();
+  size_t length = packet.length();
+  uint8_t type;
+  uint32_t id;
+
+  if (!PeerDecodeHeader(data, length, &type, &id) || id == deviceId)
+  {
+    return; // Not ours, or our own datagram looped back.
+  }
+
+  if (type == peerMessageAnnounce)
+  {
+    OnAnnounce(id, data, length);
+  }
+  else if (type == peerMessageQuote)
+  {
+    OnQuote(data, length);
+  }
+}
+
+void PeerSync::OnAnnounce(uint32_t id, const uint8_t *data, size_t length)
+{
+  std::vector<uint32_t> hashes;
+  if (!PeerDecodeAnnounce(data, length, &hashes))
+  {
+    return;
+  }
+  std::sort(hashes.begin(), hashes.end());
+  size_t count = hashes.size();
+
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  auto peer = std::find_if(peers.begin(), peers.end(), [id](const Peer &p) { return p.id == id; });
+  bool joined = peer == peers.end();
+  if (joined)
+  {
+    peers.push_back(Peer{id, millis(), hashes});
+  }
+  else
+  {
+    peer->lastSeen = millis();
+    peer->symbolHashes.swap(hashes);
+  }
+  size_t peerCount = peers.size();
+  xSemaphoreGive(mutex);
+
+  if (joined)
+  {
+    LOG_INFO("PEER: Device %08X joined with %u symbols, %u peer(s).", id, count, peerCount);
+  }
+}
+
+void PeerSync::OnQuote(const uint8_t *data, size_t length)
+{
+  QueuedQuote queued;
+  if (!PeerDecodeQuote(data, length, &queued.quote))
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 60000, "PEER: Malformed quote datagram.");
+    return;
+  }
+
+  queued.symbolIndex = SIZE_MAX;
+  xSemaphoreTake(mutex, portMAX_DELAY);
+  for (size_t i = 0; i < symbols.size(); i++)
+  {
+    if (symbols[i].equalsIgnoreCase(queued.quote.symbol))
+    {
+      lastPeerQuote[i] = max(millis(), 1UL);
+      queued.symbolIndex = i;
+      break;
+    }
+  }
+  xSemaphoreGive(mutex);
+
+  // Ingesting waits for the symbol table, which a request holds for seconds. Never here.
+  if (queued.symbolIndex != SIZE_MAX && xQueueSend(quotes, &queued, 0) != pdTRUE)
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 60000, "PEER: Quote queue full, %s dropped.", queued.quote.symbol);
+  }
+}
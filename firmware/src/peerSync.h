@@ -0,0 +1,91 @@
+/*
+    peerSync.h
+
+    Quote sharing between QuoteBots on the same LAN over UDP multicast.
+
+    Every device announces its watchlist. Each symbol is owned by one of the
+    live devices watching it (rendezvous hashing on device id and symbol),
+    and only the owner fetches it from the provider. Fresh quotes are
+    multicast to the group and merged by latestUpdate, so the refresh rate
+    of shared symbols scales with the number of devices. A symbol whose
+    owner has gone quiet is fetched locally again after staleSeconds.
+
+    Quote datagrams arrive on the AsyncUDP task. They are decoded there and
+    queued, and a task of their own takes them off the queue, the UDP task
+    never waits for the symbol table. The datagram format is in
+    peerDatagram.h.
+*/
+
+#ifndef PEERSYNC_H
+#define PEERSYNC_H
+
+#include <Arduino.h>
+#include <AsyncUDP.h>
+#include <vector>
+#include "main.h"
+#include "peerDatagram.h"
+
+class PeerSync
+{
+public:
+    bool Begin(const String &group, uint16_t port, uint32_t staleSeconds, const std::vector<String> &watchlist);
+
+    // Waits for the next quote from a peer. symbolIndex is where the symbol was when it arrived,
+    // the table may have been reordered since.
+    bool Receive(PeerQuote *quote, size_t *symbolIndex, TickType_t wait);
+
+    // Announce and expire peers, called from loop().
+    void Process();
+
+    // Follows a change of the symbol table, called with the SymbolTableLock held.
+    void SetWatchlist(const std::vector<String> &watchlist);
+
+    // True when this device should fetch the symbol itself.
+    bool ShouldFetch(size_t symbolIndex);
+
+    void Publish(size_t symbolIndex, const Quote &quote);
+
+    size_t PeerCount();
+
+    bool Enabled()
+    {
+        return enabled;
+    }
+
+private:
+    struct Peer
+    {
+        uint32_t id;
+        unsigned long lastSeen;
+        std::vector<uint32_t> symbolHashes; // Sorted.
+    };
+
+    void OnPacket(AsyncUDPPacket &packet);
+    void OnAnnounce(uint32_t id, const uint8_t *data, size_t length);
+    void OnQuote(const uint8_t *data, size_t length);
+
+    struct QueuedQuote
+    {
+        PeerQuote quote;
+        size_t symbolIndex;
+    };
+    void SendAnnounce();
+
+    AsyncUDP udp;
+    IPAddress groupAddress;
+    uint16_t port = 0;
+    bool enabled = false;
+    uint32_t deviceId = 0;
+    unsigned long staleMs = 0;
+    unsigned long lastAnnounce = 0;
+    std::vector<String> symbols;
+    std::vector<uint32_t> symbolHashes;
+    std::vector<unsigned long> lastPeerQuote; // millis() of the last quote from a peer, 0 for never.
+    std::vector<Peer> peers;
+    SemaphoreHandle_t mutex = NULL; // Peers are updated by the AsyncUDP task and read by the fetch task.
+    QueueHandle_t quotes = NULL;    // Decoded on the AsyncUDP task for Receive(), dropped when full.
+};
+
+extern PeerSync peerSync;
+
+#endif
@@ -0,0 +1,154 @@
+#include "priceAlerts.h"
+#include "fixedPoint.h"
+#include "logger.h"
+#include <algorithm>
+#include <math.h>
+
+static const char *const alertEventText[] = {"rose to", "fell to", "moved", "near 52w high", "near 52w low"};
+
+void CompileAlerts(std::vector<SymbolData> &symbols, const std::vector<AlertRule> &rules)
+{
+  // Sorted view of the table, each rule finds its symbol with a binary search.
+  std::vector<size_t> order(symbols.size());
+  for (size_t i = 0; i < order.size(); i++)
+  {
+    order[i] = i;
+    symbols[i].alerts = AlertSlots();
+  }
+  std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return strcasecmp(symbols[a].symbol.c_str(), symbols[b].symbol.c_str()) < 0; });
+
+  size_t compiled = 0;
+  for (auto &rule : rules)
+  {
+    auto found = std::lower_bound(order.begin(), order.end(), rule.symbol,
+                                  [&](size_t index, const String &symbol) { return strcasecmp(symbols[index].symbol.c_str(), symbol.c_str()) < 0; });
+    if (found == order.end() || !symbols[*found].symbol.equalsIgnoreCase(rule.symbol))
+    {
+      LOG_WARN("ALERT: %s is not in the watchlist, its %s rule is ignored.", rule.symbol.c_str(), alertKindText[int(rule.kind)]);
+      continue;
+    }
+
+    SymbolData &symbolData = symbols[*found];
+    uint8_t bit = 1 << int(rule.kind);
+    if (symbolData.alerts.rules & bit)
+    {
+      LOG_WARN("ALERT: %s has more than one %s rule, the last one applies.", rule.symbol.c_str(), alertKindText[int(rule.kind)]);
+    }
+
+    bool price = rule.kind == AlertKind::Above || rule.kind == AlertKind::Below;
+    symbolData.alerts.thresholds[int(rule.kind)] = llround(rule.value * FixedPow10(price ? fixedMaxDecimals : 2));
+    symbolData.alerts.rules |= bit;
+    compiled++;
+  }
+
+  LOG_INFO("ALERT: %u of %u rules compiled.", compiled, rules.size());
+}
+
+// Price at distance hundredths of a percent from reference.
+static int64_t Offset(int64_t reference, int64_t distance)
+{
+  return reference * distance / 10000;
+}
+
+uint8_t EvaluateAlerts(SymbolData *symbolData, int32_t hysteresis)
+{
+  AlertSlots &slots = symbolData->alerts;
+  uint8_t fired = 0;
+  if (slots.rules == 0 || symbolData->currentPrice <= 0)
+  {
+    return 0;
+  }
+
+  for (size_t kind = 0; kind < alertKindCount; kind++)
+  {
+    uint8_t bit = 1 << kind;
+    if (!(slots.rules & bit))
+    {
+      continue;
+    }
+
+    // Every kind is a value reaching a threshold from below (rising) or above.
+    int64_t setting = slots.thresholds[kind];
+    int64_t value = symbolData->currentPrice;
+    int64_t threshold = setting;
+    bool rising = true;
+    switch (AlertKind(kind))
+    {
+    case AlertKind::Above:
+      value *= FixedPow10(fixedMaxDecimals - symbolData->decimals);
+      break;
+    case AlertKind::Below:
+      value *= FixedPow10(fixedMaxDecimals - symbolData->decimals);
+      rising = false;
+      break;
+    case AlertKind::MovePercent:
+      value = abs(symbolData->changePercent);
+      break;
+    case AlertKind::Near52WeekHigh:
+      threshold = symbolData->week52High - Offset(symbolData->week52High, setting);
+      break;
+    case AlertKind::Near52WeekLow:
+      threshold = symbolData->week52Low + Offset(symbolData->week52Low, setting);
+      rising = false;
+      break;
+    }
+    if (threshold <= 0 && AlertKind(kind) != AlertKind::MovePercent)
+    {
+      continue; // No 52 week range yet.
+    }
+
+    int64_t band = AlertKind(kind) == AlertKind::MovePercent ? hysteresis : max(Offset(threshold, hysteresis), (int64_t)1);
+    bool enter = rising ? value >= threshold : value <= threshold;
+    bool leave = rising ? value < threshold - band : value > threshold + band;
+
+    if (!(slots.known & bit))
+    {
+      slots.known |= bit;
+      slots.inZone |= enter ? bit : 0;
+    }
+    else if (slots.inZone & bit)
+    {
+      if (leave)
+      {
+        slots.inZone &= ~bit;
+      }
+    }
+    else if (enter)
+    {
+      slots.inZone |= bit;
+      fired |= bit;
+    }
+  }
+  return fired;
+}
+
+void MakeAlertEvent(const SymbolData &symbolData, AlertKind kind, uint32_t epoch, AlertEvent *event)
+{
+  strlcpy(event->symbol, symbolData.symbol.c_str(), sizeof(event->symbol));
+  event->kind = kind;
+  event->epoch = epoch;
+  if (kind == AlertKind::MovePercent)
+  {
+    event->value = symbolData.changePercent;
+    event->decimals = 2;
+  }
+  else
+  {
+    event->value = symbolData.currentPrice;
+    event->decimals = symbolData.decimals;
+  }
+}
+
+String AlertText(const AlertEvent &event)
+{
+  char value[16];
+  FormatFixed(value, sizeof(value), event.value, event.decimals, min(event.decimals, (uint8_t)4));
+  String text = String(event.symbol) + " " + alertEventText[int(event.kind)] + " " + value;
+  return event.kind == AlertKind::MovePercent ? text + "%" : text;
+}
+
+bool AlertRise(const AlertEvent &event)
+{
+  return event.kind == AlertKind::Above || event.kind == AlertKind::Near52WeekHigh ||
+         (event.kind == AlertKind::MovePercent && event.value > 0);
+}
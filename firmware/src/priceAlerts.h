@@ -0,0 +1,49 @@
+/*
+    priceAlerts.h
+
+    Per symbol alert rules ("alertRules" in parameters.json) compiled into
+    threshold slots kept with each symbol, so an ingested quote is checked
+    with a few integer comparisons however many rules are configured.
+
+    A rule fires when its condition starts to hold, and is armed again
+    only once the quote moves back past the hysteresis band, a price
+    hovering at a threshold fires once. The first quote after compiling
+    only sets the starting side, a boot or reload does not replay alerts
+    that already hold.
+*/
+
+#ifndef PRICEALERTS_H
+#define PRICEALERTS_H
+
+#include <Arduino.h>
+#include <vector>
+#include "main.h"
+
+struct AlertEvent
+{
+    char symbol[12];
+    AlertKind kind;
+    uint8_t decimals; // Of value.
+    int32_t value;    // Price, or change percent for MovePercent.
+    uint32_t epoch;
+};
+
+// Replaces every symbol's slots with its rules. Price thresholds are kept at the finest scale
+// a quote can have, so a change of the symbol's scale never rounds them.
+// Caller holds the SymbolLock.
+void CompileAlerts(std::vector<SymbolData> &symbols, const std::vector<AlertRule> &rules);
+
+// Checks the symbol's current quote, returns a bit per AlertKind that fired.
+// hysteresis is in hundredths of a percent.
+uint8_t EvaluateAlerts(SymbolData *symbolData, int32_t hysteresis);
+
+// Fills event for a kind EvaluateAlerts returned.
+void MakeAlertEvent(const SymbolData &symbolData, AlertKind kind, uint32_t epoch, AlertEvent *event);
+
+// "NEM rose to 45.62", for the banner and the log.
+String AlertText(const AlertEvent &event);
+
+// Above, near the 52 week high or a move up, for the colour of the alert.
+bool AlertRise(const AlertEvent &event);
+
+#endif
@@ -0,0 +1,293 @@
+#include "providerManager.h"
+#include "iexCloudProvider.h"
+#include "finnhubProvider.h"
+#include "logger.h"
+#include "backoff.h"
+
+// Consecutive transient failures before a provider is put in cooldown.
+static const uint8_t failoverThreshold = 3;
+
+// Cooldown per error class in milliseconds, a rejected key is usually fixed by a person, a network fault by itself.
+static const BackoffPolicy transientBackoff = {60000, 30 * 60000};
+static const BackoffPolicy rateLimitBackoff = {15 * 60000, 60 * 60000};
+static const BackoffPolicy forbiddenBackoff = {15 * 60000, 6 * 3600000};
+static const BackoffPolicy invalidKeyBackoff = {60 * 60000, 24 * 3600000};
+
+// Ordered by severity, see Fault().
+static const FetchResult faultSeverity[] = {FetchResult::InvalidKey, FetchResult::Forbidden, FetchResult::RateLimited,
+                                            FetchResult::ServerError, FetchResult::NetworkError, FetchResult::Timeout,
+                                            FetchResult::ParseError};
+
+class ManagerLock
+{
+public:
+  ManagerLock(SemaphoreHandle_t mutex) : mutex(mutex)
+  {
+    xSemaphoreTake(mutex, portMAX_DELAY);
+  }
+
+  ~ManagerLock()
+  {
+    xSemaphoreGive(mutex);
+  }
+
+private:
+  SemaphoreHandle_t mutex;
+};
+
+QuoteProvider *CreateProvider(const ProviderParameters &parameters, bool sandbox)
+{
+  if (parameters.name.equalsIgnoreCase("IEXCLOUD"))
+  {
+    return new IexCloudProvider(parameters, sandbox);
+  }
+  else if (parameters.name.equalsIgnoreCase("FINNHUB"))
+  {
+    return new FinnhubProvider(parameters, sandbox);
+  }
+
+  return NULL;
+}
+
+ProviderManager::~ProviderManager()
+{
+  for (auto &entry : entries)
+  {
+    delete entry.provider;
+  }
+}
+
+void ProviderManager::Add(QuoteProvider *provider)
+{
+  if (mutex == NULL)
+  {
+    mutex = xSemaphoreCreateMutex();
+  }
+
+  Entry entry = {};
+  entry.provider = provider;
+  entry.fault = FetchResult::Ok;
+  entry.budgetDay = -1;
+  entries.push_back(entry);
+}
+
+ProviderManager::Entry *ProviderManager::Find(QuoteProvider *provider)
+{
+  for (auto &entry : entries)
+  {
+    if (entry.provider == provider)
+    {
+      return &entry;
+    }
+  }
+  return NULL;
+}
+
+bool ProviderManager::IsUsable(Entry &entry, int dayOfYear)
+{
+  if (entry.budgetDay != dayOfYear)
+  {
+    entry.budgetDay = dayOfYear;
+    entry.stats.requestsToday = 0;
+  }
+
+  if (BudgetSpent(entry))
+  {
+    return false;
+  }
+
+  if (entry.cooldownMs > 0)
+  {
+    if (millis() - entry.cooldownStart < entry.cooldownMs)
+    {
+      return false;
+    }
+
+    // Cooldown expired, the next request is a probe.
+    entry.cooldownMs = 0;
+    entry.probing = true;
+  }
+
+  return true;
+}
+
+bool ProviderManager::BudgetSpent(Entry &entry)
+{
+  return entry.stats.requestsToday >= entry.provider->MaxRequestsPerDay();
+}
+
+QuoteProvider *ProviderManager::Select(int dayOfYear)
+{
+  ManagerLock lock(mutex);
+  QuoteProvider *selected = NULL;
+  Entry *selectedEntry = NULL;
+
+  for (auto &entry : entries)
+  {
+    if (IsUsable(entry, dayOfYear))
+    {
+      selected = entry.provider;
+      selectedEntry = &entry;
+      break;
+    }
+  }
+
+  if (selected != active)
+  {
+    // Entries are in priority order. Falling back is a failover, returning to a recovered
+    // provider or the first selection is not.
+    Entry *activeEntry = Find(active);
+    if (activeEntry != NULL && (selectedEntry == NULL || selectedEntry > activeEntry))
+    {
+      activeEntry->stats.failovers++;
+      LOG_WARN("API: switching provider from %s to %s.", active->Name().c_str(), selected ? selected->Name().c_str() : "none");
+    }
+    else
+    {
+      LOG_INFO("API: using provider %s.", selected->Name().c_str());
+    }
+    active = selected;
+  }
+
+  return selected;
+}
+
+void ProviderManager::StartCooldown(Entry &entry, const BackoffPolicy &policy, FetchResult fault, uint8_t failures)
+{
+  entry.fault = fault;
+  entry.probing = false;
+  entry.cooldownStart = millis();
+  entry.cooldownMs = BackoffDelay(policy, failures);
+  LOG_WARN("API: %s cooling down for %lu seconds.", entry.provider->Name().c_str(), entry.cooldownMs / 1000);
+}
+
+void ProviderManager::Report(QuoteProvider *provider, FetchResult result, uint32_t latencyMs)
+{
+  ManagerLock lock(mutex);
+  Entry *entry = Find(provider);
+  if (entry == NULL)
+  {
+    return;
+  }
+
+  ProviderStats &stats = entry->stats;
+  stats.requests++;
+  stats.requestsToday++;
+  stats.lastLatencyMs = latencyMs;
+  stats.maxLatencyMs = max(stats.maxLatencyMs, latencyMs);
+  stats.totalLatencyMs += latencyMs;
+
+  if (result == FetchResult::Ok || result == FetchResult::UnknownSymbol) // The provider works, the symbol may not.
+  {
+    stats.successes++;
+    if (entry->probing)
+    {
+      LOG_INFO("API: %s recovered.", provider->Name().c_str());
+    }
+    entry->consecutiveFailures = 0;
+    entry->fault = FetchResult::Ok;
+    entry->probing = false;
+    return;
+  }
+
+  stats.failures++;
+  if (entry->consecutiveFailures < UINT8_MAX)
+  {
+    entry->consecutiveFailures++;
+  }
+
+  switch (result)
+  {
+  case FetchResult::InvalidKey:
+    LOG_ERROR("API: %s key rejected.", provider->Name().c_str());
+    StartCooldown(*entry, invalidKeyBackoff, result, entry->consecutiveFailures);
+    return;
+
+  case FetchResult::Forbidden:
+    StartCooldown(*entry, forbiddenBackoff, result, entry->consecutiveFailures);
+    return;
+
+  case FetchResult::RateLimited:
+    StartCooldown(*entry, rateLimitBackoff, result, entry->consecutiveFailures);
+    return;
+
+  case FetchResult::Timeout:
+    stats.timeouts++;
+    // Fall through.
+  default:
+    // A failed probe goes straight back to cooling down.
+    if (entry->probing || entry->consecutiveFailures >= failoverThreshold)
+    {
+      uint8_t failures = entry->consecutiveFailures;
+      StartCooldown(*entry, transientBackoff, result, failures - min(failures, (uint8_t)(failoverThreshold - 1)));
+    }
+    return;
+  }
+}
+
+bool ProviderManager::Probing(QuoteProvider *provider)
+{
+  ManagerLock lock(mutex);
+  Entry *entry = Find(provider);
+  return entry != NULL && entry->probing;
+}
+
+FetchResult ProviderManager::Fault()
+{
+  ManagerLock lock(mutex);
+  for (FetchResult fault : faultSeverity)
+  {
+    for (auto &entry : entries)
+    {
+      if (entry.cooldownMs > 0 && entry.fault == fault)
+      {
+        return fault;
+      }
+    }
+  }
+  for (auto &entry : entries)
+  {
+    if (BudgetSpent(entry))
+    {
+      return FetchResult::BudgetExhausted;
+    }
+  }
+  return FetchResult::Ok;
+}
+
+unsigned long ProviderManager::RetryInMs(unsigned long nextDayInMs)
+{
+  ManagerLock lock(mutex);
+  unsigned long retryIn = 0;
+  for (auto &entry : entries)
+  {
+    unsigned long remaining = 0;
+    if (BudgetSpent(entry))
+    {
+      remaining = nextDayInMs; // Cooldowns end on their own, the budget only with the day.
+    }
+    else if (entry.cooldownMs > 0)
+    {
+      unsigned long elapsed = millis() - entry.cooldownStart;
+      remaining = elapsed < entry.cooldownMs ? entry.cooldownMs - elapsed : 0;
+    }
+    if (remaining == 0)
+    {
+      return 0;
+    }
+    retryIn = retryIn == 0 ? remaining : min(retryIn, remaining);
+  }
+  return retryIn;
+}
+
+ProviderStats ProviderManager::Stats(size_t index)
+{
+  ManagerLock lock(mutex);
+  return entries[index].stats;
+}
+
+QuoteProvider *ProviderManager::Active()
+{
+  ManagerLock lock(mutex);
+  return active;
+}
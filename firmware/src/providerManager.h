@@ -0,0 +1,103 @@
+/*
+    providerManager.h
+
+    Holds the configured quote providers in priority order, tracks their
+    daily request budget, health and latency, and picks the provider for
+    the next request. Providers that fail, are rate limited or run out of
+    budget are skipped until their cooldown expires. Cooldowns back off per
+    error class, and a provider coming out of one is probed with a single
+    symbol before it is trusted with full batches again.
+
+    The fetch and stream tasks select and report, /metrics reads the
+    stats, every member is used under the manager's mutex.
+*/
+
+#ifndef PROVIDERMANAGER_H
+#define PROVIDERMANAGER_H
+
+#include <Arduino.h>
+#include <vector>
+#include "quoteProvider.h"
+#include "backoff.h"
+
+struct ProviderStats
+{
+    uint32_t requests;
+    uint32_t successes;
+    uint32_t failures;
+    uint32_t timeouts;
+    uint32_t failovers; // Times this provider was abandoned for the next one.
+    uint32_t lastLatencyMs;
+    uint32_t maxLatencyMs;
+    uint64_t totalLatencyMs;
+    int requestsToday;
+};
+
+// Returns NULL for unknown provider names.
+QuoteProvider *CreateProvider(const ProviderParameters &parameters, bool sandbox);
+
+class ProviderManager
+{
+public:
+    ~ProviderManager();
+
+    // Providers are added at setup, before any task uses the manager.
+    void Add(QuoteProvider *provider);
+
+    // Highest priority usable provider, NULL when none is.
+    QuoteProvider *Select(int dayOfYear);
+
+    void Report(QuoteProvider *provider, FetchResult result, uint32_t latencyMs);
+
+    // True while provider is on trial after a cooldown, its requests should be kept small.
+    bool Probing(QuoteProvider *provider);
+
+    // Most severe failure among the providers in cooldown, BudgetExhausted when the others have
+    // used up today's budget, Ok when a provider is usable.
+    FetchResult Fault();
+
+    // Milliseconds until a provider is usable again, the first cooldown to expire or the day rolling
+    // over in nextDayInMs for a spent budget. 0 when a provider is usable.
+    unsigned long RetryInMs(unsigned long nextDayInMs);
+
+    size_t Size()
+    {
+        return entries.size();
+    }
+
+    // Fixed after setup.
+    QuoteProvider *Provider(size_t index)
+    {
+        return entries[index].provider;
+    }
+
+    ProviderStats Stats(size_t index);
+
+    QuoteProvider *Active();
+
+private:
+    struct Entry
+    {
+        QuoteProvider *provider;
+        ProviderStats stats;
+        FetchResult fault; // Failure that started the cooldown.
+        bool probing;
+        uint8_t consecutiveFailures;
+        unsigned long cooldownStart;
+        unsigned long cooldownMs;
+        int budgetDay;
+    };
+
+    Entry *Find(QuoteProvider *provider);
+    bool IsUsable(Entry &entry, int dayOfYear);
+    bool BudgetSpent(Entry &entry);
+    void StartCooldown(Entry &entry, const BackoffPolicy &policy, FetchResult fault, uint8_t failures);
+
+    std::vector<Entry> entries;
+    QuoteProvider *active = NULL;
+    SemaphoreHandle_t mutex = NULL;
+};
+
+extern ProviderManager providerManager;
+
+#endif
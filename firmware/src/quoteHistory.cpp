@@ -0,0 +1,88 @@
+#include "quoteHistory.h"
+#include "fixedPoint.h"
+
+void QuoteHistory::Begin(size_t maxSymbols, size_t pointsPerSymbol)
+{
+  series.clear();
+  series.resize(maxSymbols);
+  points = pointsPerSymbol;
+}
+
+void QuoteHistory::Add(size_t symbolIndex, uint32_t epoch, int32_t price, uint8_t decimals)
+{
+  if (symbolIndex >= series.size() || points == 0 || epoch == 0)
+  {
+    return;
+  }
+
+  Series &s = series[symbolIndex];
+  uint32_t minute = epoch - epoch % 60;
+
+  // Allocated on first use, symbols that never quote cost nothing.
+  if (s.ring.size() == 0)
+  {
+    s.ring.resize(points);
+    s.decimals = decimals;
+  }
+
+  if (s.decimals != decimals)
+  {
+    for (auto &point : s.ring)
+    {
+      point.price = FixedRescale(point.price, s.decimals, decimals);
+    }
+    s.decimals = decimals;
+  }
+
+  size_t last = (s.head + points - 1) % points;
+  if (s.count > 0 && s.ring[last].epoch == minute)
+  {
+    s.ring[last].price = price;
+    return;
+  }
+  if (s.count > 0 && s.ring[last].epoch > minute)
+  {
+    return; // Out of order, e.g. a replayed older quote.
+  }
+
+  s.ring[s.head].epoch = minute;
+  s.ring[s.head].price = price;
+  s.head = (s.head + 1) % points;
+  s.count = min(s.count + 1, points);
+}
+
+uint8_t QuoteHistory::Copy(size_t symbolIndex, std::vector<HistoryPoint> *out)
+{
+  out->clear();
+  if (symbolIndex >= series.size())
+  {
+    return 0;
+  }
+
+  Series &s = series[symbolIndex];
+  out->reserve(s.count);
+  size_t start = (s.head + points - s.count) % max(points, (size_t)1);
+  for (size_t i = 0; i < s.count; i++)
+  {
+    out->push_back(s.ring[(start + i) % points]);
+  }
+  return s.decimals;
+}
+
+size_t QuoteHistory::Count(size_t symbolIndex)
+{
+  return symbolIndex < series.size() ? series[symbolIndex].count : 0;
+}
+
+void QuoteHistory::Remap(const std::vector<int> &sourceIndex)
+{
+  std::vector<Series> remapped(series.size());
+  for (size_t i = 0; i < min(remapped.size(), sourceIndex.size()); i++)
+  {
+    if (sourceIndex[i] >= 0 && size_t(sourceIndex[i]) < series.size())
+    {
+      remapped[i] = std::move(series[sourceIndex[i]]);
+    }
+  }
+  series.swap(remapped);
+}
@@ -0,0 +1,55 @@
+/*
+    quoteHistory.h
+
+    Locally collected intraday history: one closing price per minute per
+    symbol, kept in a fixed ring per symbol. Memory is bounded by
+    maxSymbols * points * sizeof(HistoryPoint); symbols past maxSymbols have no history.
+
+    Not thread safe, callers hold the SymbolLock.
+*/
+
+#ifndef QUOTEHISTORY_H
+#define QUOTEHISTORY_H
+
+#include <Arduino.h>
+#include <vector>
+
+struct HistoryPoint
+{
+    uint32_t epoch; // Start of the minute.
+    int32_t price;  // Scaled by the series decimals.
+};
+
+class QuoteHistory
+{
+public:
+    void Begin(size_t maxSymbols, size_t points);
+
+    // Record the latest price, replacing the point of the current minute.
+    void Add(size_t symbolIndex, uint32_t epoch, int32_t price, uint8_t decimals);
+
+    // Oldest first. Returns the decimals of the copied prices.
+    uint8_t Copy(size_t symbolIndex, std::vector<HistoryPoint> *points);
+
+    size_t Count(size_t symbolIndex);
+
+    // Follows a change of the symbol table: series i takes the old series
+    // sourceIndex[i], or starts empty when that is -1.
+    void Remap(const std::vector<int> &sourceIndex);
+
+private:
+    struct Series
+    {
+        std::vector<HistoryPoint> ring;
+        size_t head = 0; // Next write position.
+        size_t count = 0;
+        uint8_t decimals = 0;
+    };
+
+    std::vector<Series> series;
+    size_t points = 0;
+};
+
+extern QuoteHistory quoteHistory; // Guarded by the SymbolLock.
+
+#endif
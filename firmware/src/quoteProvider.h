@@ -0,0 +1,127 @@
+/*
+    quoteProvider.h
+
+    Interface implemented by every quote API. A provider knows how to build
+    request URLs, extract quotes from a streaming response body and classify
+    errors. Transport, budgeting and failover are handled by ProviderManager.
+*/
+
+#ifndef QUOTEPROVIDER_H
+#define QUOTEPROVIDER_H
+
+#include <Arduino.h>
+#include <functional>
+#include "main.h"
+
+enum class FetchResult
+{
+    Ok,
+    UnknownSymbol,
+    InvalidKey,
+    Forbidden,
+    RateLimited,
+    ServerError,
+    NetworkError,
+    Timeout,
+    ParseError,
+    BudgetExhausted // Every provider has used its requests for the day.
+};
+
+static const char *const fetchResultText[] = {"Ok", "Unknown symbol", "Invalid key", "Forbidden", "Rate limited",
+                                              "Server error", "Network error", "Timeout", "Parse error", "Budget exhausted"};
+
+class QuoteProvider
+{
+public:
+    typedef std::function<void(const char *symbol, const Quote &quote)> StreamQuoteHandler;
+
+    QuoteProvider(const ProviderParameters &parameters, bool sandbox)
+    {
+        name = parameters.name;
+        this->sandbox = sandbox;
+        key = sandbox ? parameters.sandboxKey : parameters.key;
+        maxRequestsPerDay = sandbox ? parameters.sandboxMaxRequestsPerDay : parameters.maxRequestsPerDay;
+        batchSize = max(parameters.batchSize, 1);
+    }
+
+    virtual ~QuoteProvider() {}
+
+    // URL requesting quotes for count symbols, count never exceeds MaxBatchSize().
+    virtual String BuildUrl(const String *symbols, size_t count) = 0;
+
+    // Extract quotes from a 200 response body as it is received.
+    // found[i] is cleared for symbols missing from the body.
+    virtual bool ParseQuotes(Stream &body, const String *symbols, size_t count, Quote *quotes, bool *found) = 0;
+
+    // Classify a non 200 response.
+    virtual FetchResult MapError(int httpCode, const String &body)
+    {
+        return MapHttpCode(httpCode);
+    }
+
+    virtual size_t MaxBatchSize()
+    {
+        return 1;
+    }
+
+    // Server-sent events endpoint streaming count symbols, empty when not supported.
+    virtual String BuildStreamUrl(const String *symbols, size_t count)
+    {
+        return "";
+    }
+
+    // Extract every quote carried by one streamed event.
+    virtual bool ParseStreamEvent(const String &data, const StreamQuoteHandler &handler)
+    {
+        return false;
+    }
+
+    // URL of a JSON document naming the symbol's logo image, empty when not supported.
+    virtual String BuildLogoUrl(const String &symbol)
+    {
+        return "";
+    }
+
+    // Image URL from a 200 logo document, empty when the symbol has no logo.
+    virtual String ParseLogoUrl(const String &body)
+    {
+        return "";
+    }
+
+    const String &Name()
+    {
+        return name;
+    }
+
+    int MaxRequestsPerDay()
+    {
+        return maxRequestsPerDay;
+    }
+
+    // Ask only for the QuoteField bits the device consumes, where the API can filter.
+    // The latest price is always requested, it sets the price scale.
+    void SetFields(uint16_t quoteFields)
+    {
+        fields = quoteFields | QuoteFieldLatestPrice;
+    }
+
+protected:
+    static FetchResult MapHttpCode(int httpCode)
+    {
+        return httpCode == 401   ? FetchResult::InvalidKey
+               : httpCode == 402 ? FetchResult::RateLimited
+               : httpCode == 429 ? FetchResult::RateLimited
+               : httpCode == 403 ? FetchResult::Forbidden
+               : httpCode == 404 ? FetchResult::UnknownSymbol
+                                 : FetchResult::ServerError;
+    }
+
+    String name;
+    String key;
+    bool sandbox;
+    int maxRequestsPerDay;
+    int batchSize;
+    uint16_t fields = QuoteFieldAll;
+};
+
+#endif
@@ -0,0 +1,175 @@
+#include "quoteRecorder.h"
+#include "sdLock.h"
+#include "logger.h"
+
+static const char recorderMagic[4] = {'Q', 'B', 'R', '3'};
+static const char recorderMagicV2[4] = {'Q', 'B', 'R', '2'};
+static const char recorderMagicV1[4] = {'Q', 'B', 'R', '1'};
+
+bool QuoteRecorder::Begin(const char *filePath)
+{
+  SdLock lock;
+
+  path = filePath;
+
+  if (!SD.exists(filePath))
+  {
+    File file = SD.open(filePath, FILE_WRITE);
+    if (!file)
+    {
+      LOG_ERROR("RECORD: Failed to create %s", filePath);
+      return false;
+    }
+    file.write((const uint8_t *)recorderMagic, sizeof(recorderMagic));
+    file.close();
+  }
+  else
+  {
+    File file = SD.open(filePath);
+    char magic[4];
+    bool current = file && file.readBytes(magic, sizeof(magic)) == sizeof(magic) && memcmp(magic, recorderMagic, sizeof(magic)) == 0;
+    file.close();
+    if (!current)
+    {
+      LOG_ERROR("RECORD: %s is not a current capture file, move it away to capture.", filePath);
+      return false;
+    }
+  }
+
+  LOG_INFO("RECORD: Capturing responses to %s", filePath);
+  return true;
+}
+
+bool QuoteRecorder::Append(uint32_t epoch, uint16_t milliseconds, int httpCode, const String &symbol, Stream &payload, size_t length)
+{
+  // A cut list would replay against the wrong symbols.
+  if (symbol.length() > 0xFFFF)
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 60000, "RECORD: Symbol list of %u characters not captured.", symbol.length());
+    return false;
+  }
+
+  SdLock lock;
+
+  File file = SD.open(path.c_str(), FILE_APPEND);
+  if (!file)
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 60000, "RECORD: Failed to open %s", path.c_str());
+    return false;
+  }
+
+  uint8_t header[10];
+  int16_t code = httpCode;
+  uint16_t symbolLength = symbol.length();
+  uint32_t payloadLength = length;
+
+  memcpy(header, &epoch, 4);
+  memcpy(header + 4, &milliseconds, 2);
+  memcpy(header + 6, &code, 2);
+  memcpy(header + 8, &symbolLength, 2);
+
+  file.write(header, sizeof(header));
+  file.write((const uint8_t *)symbol.c_str(), symbolLength);
+  file.write((const uint8_t *)&payloadLength, 4);
+  uint8_t chunk[128];
+  size_t remaining = payloadLength;
+  while (remaining > 0)
+  {
+    size_t count = payload.readBytes((char *)chunk, min(remaining, sizeof(chunk)));
+    if (count == 0)
+    {
+      memset(chunk, ' ', sizeof(chunk)); // Keeps the record length, JSON ignores the padding.
+      count = min(remaining, sizeof(chunk));
+    }
+    file.write(chunk, count);
+    remaining -= count;
+  }
+  file.close();
+
+  count++;
+  return true;
+}
+
+bool QuoteReplayer::Begin(const char *filePath)
+{
+  SdLock lock;
+
+  file = SD.open(filePath);
+  if (!file)
+  {
+    LOG_ERROR("REPLAY: Failed to open %s", filePath);
+    return false;
+  }
+
+  char magic[4];
+  bool read = file.readBytes(magic, sizeof(magic)) == sizeof(magic);
+  bool v1 = read && memcmp(magic, recorderMagicV1, sizeof(magic)) == 0;
+  bool v2 = read && memcmp(magic, recorderMagicV2, sizeof(magic)) == 0;
+  symbolLengthSize = v1 || v2 ? 1 : 2;
+  lengthSize = v1 ? 2 : 4;
+  if (!read || (memcmp(magic, recorderMagic, sizeof(magic)) != 0 && !v1 && !v2))
+  {
+    LOG_ERROR("REPLAY: %s is not a capture file", filePath);
+    file.close();
+    return false;
+  }
+
+  return true;
+}
+
+bool QuoteReplayer::Next(RecordedResponse *response)
+{
+  SdLock lock;
+
+  uint8_t header[8];
+  if (!file || file.read(header, sizeof(header)) != sizeof(header))
+  {
+    return false;
+  }
+
+  memcpy(&response->epoch, header, 4);
+  memcpy(&response->milliseconds, header + 4, 2);
+  memcpy(&response->httpCode, header + 6, 2);
+
+  uint16_t symbolLength = 0;
+  uint32_t payloadLength = 0;
+  return file.read((uint8_t *)&symbolLength, symbolLengthSize) == symbolLengthSize &&
+         ReadText(symbolLength, &response->symbol) &&
+         file.read((uint8_t *)&payloadLength, lengthSize) == lengthSize &&
+         ReadText(payloadLength, &response->payload);
+}
+
+// Chunked reads keep the stack small, payloads can be several KB. Caller holds the SdLock.
+bool QuoteReplayer::ReadText(size_t length, String *text)
+{
+  *text = "";
+  if (!text->reserve(length))
+  {
+    return false;
+  }
+  while (length > 0)
+  {
+    char chunk[128];
+    size_t read = file.read((uint8_t *)chunk, min(length, sizeof(chunk) - 1));
+    if (read == 0)
+    {
+      return false;
+    }
+    chunk[read] = 0;
+    text->concat(chunk);
+    length -= read;
+  }
+  return true;
+}
+
+bool QuoteReplayer::Rewind()
+{
+  SdLock lock;
+  return file && file.seek(sizeof(recorderMagic));
+}
+
+void QuoteReplayer::End()
+{
+  SdLock lock;
+  file.close();
+}
@@ -0,0 +1,72 @@
+/*
+    quoteRecorder.h
+
+    Capture of raw provider responses to the SD card, and playback of a
+    capture through the same response handling path as live data.
+
+    File format (little endian):
+      "QBR3"
+      repeated records:
+        uint32 epoch seconds, uint16 milliseconds, int16 HTTP code,
+        uint16 symbol length, symbol, uint32 payload length, payload
+
+    The symbol is the comma separated list of a batch request. "QBR2"
+    captures, with a uint8 symbol length, and "QBR1" captures, with a uint8
+    symbol length and a uint16 payload length, still replay. New records
+    are never appended to them.
+*/
+
+#ifndef QUOTERECORDER_H
+#define QUOTERECORDER_H
+
+#include <Arduino.h>
+#include <SD.h>
+
+struct RecordedResponse
+{
+    uint32_t epoch;
+    uint16_t milliseconds;
+    int16_t httpCode;
+    String symbol;
+    String payload;
+
+    // Milliseconds since the epoch, for pacing playback.
+    uint64_t Timestamp() const
+    {
+        return (uint64_t)epoch * 1000 + milliseconds;
+    }
+};
+
+class QuoteRecorder
+{
+public:
+    bool Begin(const char *path);
+    // Copies length bytes of payload, a spooled body is not loaded into RAM.
+    bool Append(uint32_t epoch, uint16_t milliseconds, int httpCode, const String &symbol, Stream &payload, size_t length);
+    uint32_t Count()
+    {
+        return count;
+    }
+
+private:
+    String path;
+    uint32_t count = 0;
+};
+
+class QuoteReplayer
+{
+public:
+    bool Begin(const char *path);
+    bool Next(RecordedResponse *response);
+    bool Rewind();
+    void End();
+
+private:
+    bool ReadText(size_t length, String *text);
+
+    File file;
+    size_t symbolLengthSize = 2; // 1 in a QBR1 or QBR2 capture.
+    size_t lengthSize = 4;       // Of the payload length, 2 in a QBR1 capture.
+};
+
+#endif
@@ -0,0 +1,28 @@
+/*
+    quoteTile.h
+
+    The few quote fields the multi-symbol pages show, copied out of the
+    symbol table only when the symbol's quote version moved on.
+*/
+
+#ifndef QUOTETILE_H
+#define QUOTETILE_H
+
+#include <Arduino.h>
+#include <functional>
+
+struct QuoteTile
+{
+    String symbol;
+    int32_t price;
+    int32_t change;
+    int32_t changePercent; // Hundredths of a percent.
+    uint8_t decimals;
+    bool valid;
+    uint32_t version;
+};
+
+// Fills tile and returns true when repaint is set or the symbol's quote version differs from knownVersion.
+typedef std::function<bool(size_t symbolIndex, uint32_t knownVersion, bool repaint, QuoteTile *tile)> QuoteTileSource;
+
+#endif
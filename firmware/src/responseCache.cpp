@@ -0,0 +1,242 @@
+#include "responseCache.h"
+#include <SD.h>
+#include "sdLock.h"
+#include "logger.h"
+
+static const char cacheMagic[4] = {'Q', 'B', 'C', '1'};
+
+uint32_t ResponseCache::Hash(const char *data, size_t length)
+{
+  uint32_t hash = 2166136261u;
+  for (size_t i = 0; i < length; i++)
+  {
+    hash = (hash ^ (uint8_t)data[i]) * 16777619u;
+  }
+  return hash ? hash : 1; // Zero marks an empty slot.
+}
+
+bool ResponseSpool::Begin(const char *spoolPath)
+{
+  SdLock lock;
+  path = spoolPath;
+  file = SD.open(path, FILE_WRITE);
+  failed = !file;
+  return !failed;
+}
+
+void ResponseSpool::End()
+{
+  Flush();
+  SdLock lock;
+  file.close();
+}
+
+size_t ResponseSpool::write(uint8_t c)
+{
+  return write(&c, 1);
+}
+
+size_t ResponseSpool::write(const uint8_t *data, size_t size)
+{
+  size_t written = size;
+  length += size;
+  for (size_t i = 0; i < size; i++)
+  {
+    hash.write(data[i]);
+  }
+  while (size > 0)
+  {
+    size_t count = min(size, sizeof(buffer) - buffered);
+    memcpy(buffer + buffered, data, count);
+    buffered += count;
+    data += count;
+    size -= count;
+    if (buffered == sizeof(buffer))
+    {
+      Flush();
+    }
+  }
+  return written;
+}
+
+// The card is taken only per block, the log and the display are not held up for a whole body.
+void ResponseSpool::Flush()
+{
+  if (buffered > 0 && !failed)
+  {
+    SdLock lock;
+    failed = file.write(buffer, buffered) != buffered;
+  }
+  buffered = 0;
+}
+
+bool ResponseCache::Begin(const char *cacheDirectory, size_t capacity)
+{
+  SdLock lock;
+
+  directory = cacheDirectory;
+  slots.assign(capacity, CacheSlot());
+  lastUsed.assign(capacity, 0);
+
+  if (!SD.exists(directory.c_str()) && !SD.mkdir(directory.c_str()))
+  {
+    LOG_ERROR("CACHE: Failed to create %s", directory.c_str());
+    return false;
+  }
+
+  String indexPath = directory + "/index.bin";
+  File file = SD.open(indexPath);
+  char magic[4];
+  size_t loaded = 0;
+
+  if (file && file.read((uint8_t *)magic, 4) == 4 && memcmp(magic, cacheMagic, 4) == 0)
+  {
+    while (loaded < capacity && file.read((uint8_t *)&slots[loaded], sizeof(CacheSlot)) == sizeof(CacheSlot))
+    {
+      slots[loaded].etag[sizeof(slots[loaded].etag) - 1] = 0;
+      slots[loaded].lastModified[sizeof(slots[loaded].lastModified) - 1] = 0;
+      loaded++;
+    }
+    file.close();
+  }
+  else
+  {
+    // Missing or from another version, start over with empty slots.
+    file.close();
+    file = SD.open(indexPath, FILE_WRITE);
+    if (!file)
+    {
+      LOG_ERROR("CACHE: Failed to create %s", indexPath.c_str());
+      return false;
+    }
+    file.write((const uint8_t *)cacheMagic, 4);
+    for (auto &slot : slots)
+    {
+      file.write((const uint8_t *)&slot, sizeof(slot));
+    }
+    file.close();
+  }
+
+  enabled = true;
+  LOG_INFO("CACHE: %u of %u response slots restored from %s", loaded, capacity, directory.c_str());
+  return true;
+}
+
+const CacheSlot *ResponseCache::Find(const String &url)
+{
+  if (!enabled)
+  {
+    return NULL;
+  }
+
+  uint32_t urlHash = Hash(url.c_str(), url.length());
+  for (size_t i = 0; i < slots.size(); i++)
+  {
+    if (slots[i].urlHash == urlHash)
+    {
+      lastUsed[i] = ++useCounter;
+      return &slots[i];
+    }
+  }
+  return NULL;
+}
+
+bool ResponseCache::Store(const String &url, const String &etag, const String &lastModified, const ResponseSpool &body)
+{
+  if (!enabled)
+  {
+    return true;
+  }
+
+  uint32_t urlHash = Hash(url.c_str(), url.length());
+  uint32_t contentHash = body.Hash();
+
+  // The entry for this URL, else an empty slot, else the least recently used one.
+  size_t index = 0;
+  for (size_t i = 0; i < slots.size(); i++)
+  {
+    if (slots[i].urlHash == urlHash)
+    {
+      index = i;
+      break;
+    }
+    if (lastUsed[i] < lastUsed[index] || (slots[i].urlHash == 0 && slots[index].urlHash != 0))
+    {
+      index = i;
+    }
+  }
+
+  CacheSlot &slot = slots[index];
+  bool changed = slot.urlHash != urlHash || slot.contentHash != contentHash || slot.bodyLength != body.Length();
+  bool validatorsChanged = strcmp(slot.etag, etag.c_str()) != 0 || strcmp(slot.lastModified, lastModified.c_str()) != 0;
+  lastUsed[index] = ++useCounter;
+
+  if (!changed && !validatorsChanged)
+  {
+    return false;
+  }
+
+  slot.urlHash = urlHash;
+  slot.contentHash = contentHash;
+  slot.bodyLength = body.Length();
+  strlcpy(slot.etag, etag.c_str(), sizeof(slot.etag));
+  strlcpy(slot.lastModified, lastModified.c_str(), sizeof(slot.lastModified));
+
+  SdLock lock;
+  if (changed)
+  {
+    // Renamed into place, the body is not copied again.
+    SD.remove(BodyPath(urlHash));
+    if (!SD.rename(body.Path(), BodyPath(urlHash)))
+    {
+      LOG_RATE_LIMITED(LOG_LEVEL_WARN, 60000, "CACHE: Failed to write %s", BodyPath(urlHash).c_str());
+    }
+  }
+  WriteSlot(index);
+
+  return changed;
+}
+
+bool ResponseCache::LoadBody(const CacheSlot &slot, String *body)
+{
+  SdLock lock;
+
+  File file = SD.open(BodyPath(slot.urlHash));
+  if (!file || file.size() != slot.bodyLength)
+  {
+    file.close();
+    return false;
+  }
+
+  body->reserve(slot.bodyLength);
+  while (file.available())
+  {
+    char buf[128];
+    size_t length = file.read((uint8_t *)buf, sizeof(buf));
+    body->concat(buf, length);
+  }
+  file.close();
+
+  return Hash(body->c_str(), body->length()) == slot.contentHash;
+}
+
+// Rewrite a single slot in place, the index never needs a full rewrite.
+void ResponseCache::WriteSlot(size_t index)
+{
+  File file = SD.open(directory + "/index.bin", "r+");
+  if (!file || !file.seek(sizeof(cacheMagic) + index * sizeof(CacheSlot)))
+  {
+    LOG_RATE_LIMITED(LOG_LEVEL_WARN, 60000, "CACHE: Failed to update index in %s", directory.c_str());
+    file.close();
+    return;
+  }
+  file.write((const uint8_t *)&slots[index], sizeof(CacheSlot));
+  file.close();
+}
+
+String ResponseCache::BodyPath(uint32_t urlHash)
+{
+  char name[16];
+  snprintf(name, sizeof(name), "/%08X.bin", urlHash);
+  return directory + name;
+}
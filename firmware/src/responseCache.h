@@ -0,0 +1,114 @@
+/*
+    responseCache.h
+
+    Provider responses keyed by request URL, persisted on the SD card.
+
+    Each entry keeps the validators the server sent (ETag, Last-Modified)
+    for conditional requests, and a hash of the body so a byte identical
+    response can skip parsing and ingestion. The last body is kept in its
+    own file, a 304 after a reboot still has data to show.
+
+    Index file: "QBC1", then fixed size slots (see CacheSlot), rewritten
+    slot by slot as entries change.
+
+    A body is never held in RAM whole. It is copied into a ResponseSpool
+    while the parser reads it, and a changed body's spool file becomes
+    the cached body.
+*/
+
+#ifndef RESPONSECACHE_H
+#define RESPONSECACHE_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <vector>
+#include "hashPrint.h"
+
+struct __attribute__((packed)) CacheSlot
+{
+    uint32_t urlHash; // 0 for an empty slot.
+    uint32_t contentHash;
+    uint32_t bodyLength;
+    char etag[48];
+    char lastModified[32];
+};
+
+// A response body being received, hashed and written to a file on the card in blocks.
+class ResponseSpool : public Print
+{
+public:
+    // Truncates path.
+    bool Begin(const char *path);
+
+    // Flush and close, before the file is read or stored.
+    void End();
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t *data, size_t length) override;
+
+    const String &Path() const
+    {
+        return path;
+    }
+    uint32_t Length() const
+    {
+        return length;
+    }
+    uint32_t Hash() const
+    {
+        return hash.hash ? hash.hash : 1; // As ResponseCache::Hash().
+    }
+    // A write to the card failed, the file is incomplete.
+    bool Failed() const
+    {
+        return failed;
+    }
+
+private:
+    void Flush();
+
+    String path;
+    File file;
+    HashPrint hash;
+    uint8_t buffer[512];
+    size_t buffered = 0;
+    uint32_t length = 0;
+    bool failed = false;
+};
+
+class ResponseCache
+{
+public:
+    bool Begin(const char *directory, size_t capacity);
+
+    // NULL when the URL has no entry.
+    const CacheSlot *Find(const String &url);
+
+    // Store a 200 response, a changed body takes over the spool's file.
+    // Returns false when the body is identical to the cached one.
+    bool Store(const String &url, const String &etag, const String &lastModified, const ResponseSpool &body);
+
+    // Body of the cached response, for a 304 with nothing ingested yet.
+    bool LoadBody(const CacheSlot &slot, String *body);
+
+    static uint32_t Hash(const char *data, size_t length);
+
+    bool Enabled()
+    {
+        return enabled;
+    }
+
+private:
+    void WriteSlot(size_t index);
+    String BodyPath(uint32_t urlHash);
+
+    bool enabled = false;
+    String directory;
+    std::vector<CacheSlot> slots;
+    std::vector<uint32_t> lastUsed; // In RAM only, for eviction.
+    uint32_t useCounter = 0;
+};
+
+extern ResponseCache responseCache;
+
+#endif
@@ -0,0 +1,32 @@
+/*
+    sdLock.h
+
+    The SD library is not thread safe. Any task touching the card holds
+    an SdLock for the duration of the file operation.
+*/
+
+#ifndef SDLOCK_H
+#define SDLOCK_H
+
+#include <Arduino.h>
+
+extern SemaphoreHandle_t sdMutex; // Recursive, created at the start of setup().
+
+class SdLock
+{
+public:
+    SdLock()
+    {
+        xSemaphoreTakeRecursive(sdMutex, portMAX_DELAY);
+    }
+
+    ~SdLock()
+    {
+        xSemaphoreGiveRecursive(sdMutex);
+    }
+
+    SdLock(const SdLock &) = delete;
+    SdLock &operator=(const SdLock &) = delete;
+};
+
+#endif
@@ -0,0 +1,317 @@
+#include "sseClient.h"
+#include "logger.h"
+
+bool SseClient::Connect(const String &url, const String &resumeId, uint32_t timeoutMs)
+{
+  Stop();
+
+  // Split scheme://host[:port]/path.
+  bool secure = url.startsWith("https://");
+  int hostStart = url.indexOf("://");
+  if (hostStart < 0)
+  {
+    LOG_ERROR("SSE: Invalid URL.");
+    return false;
+  }
+  hostStart += 3;
+  int pathStart = url.indexOf('/', hostStart);
+  String host = pathStart < 0 ? url.substring(hostStart) : url.substring(hostStart, pathStart);
+  String path = pathStart < 0 ? "/" : url.substring(pathStart);
+  uint16_t port = secure ? 443 : 80;
+  int portStart = host.indexOf(':');
+  if (portStart >= 0)
+  {
+    port = host.substring(portStart + 1).toInt();
+    host = host.substring(0, portStart);
+  }
+
+  if (secure)
+  {
+    WiFiClientSecure *secureClient = new WiFiClientSecure();
+    secureClient->setInsecure();
+    client.reset(secureClient);
+  }
+  else
+  {
+    client.reset(new WiFiClient());
+  }
+
+  if (!client->connect(host.c_str(), port))
+  {
+    LOG_WARN("SSE: Connection to %s:%u failed.", host.c_str(), port);
+    client.reset();
+    return false;
+  }
+
+  String request = "GET " + path + " HTTP/1.1\r\nHost: " + host +
+                   "\r\nAccept: text/event-stream\r\nCache-Control: no-cache\r\nConnection: keep-alive\r\n";
+  if (resumeId.length() > 0)
+  {
+    request += "Last-Event-ID: " + resumeId + "\r\n";
+  }
+  request += "\r\n";
+  client->print(request);
+
+  lastEventId = resumeId;
+  line = "";
+  data = "";
+  eventName = "";
+  discarding = false;
+  lineTooLong = false;
+
+  return ReadHeaders(timeoutMs);
+}
+
+bool SseClient::ReadHeaders(uint32_t timeoutMs)
+{
+  unsigned long start = millis();
+  String header;
+  bool statusLine = true;
+  chunked = false;
+  chunkState = ChunkState::Size;
+  chunkRemaining = 0;
+
+  while (millis() - start < timeoutMs)
+  {
+    if (!client->connected())
+    {
+      break;
+    }
+    if (!client->available())
+    {
+      vTaskDelay(pdMS_TO_TICKS(10));
+      continue;
+    }
+
+    char c = client->read();
+    if (c == '\r')
+    {
+      continue;
+    }
+    if (c != '\n')
+    {
+      header += c;
+      continue;
+    }
+
+    if (statusLine)
+    {
+      statusLine = false;
+      // "HTTP/1.1 200 OK"
+      int code = header.substring(header.indexOf(' ') + 1).toInt();
+      if (code != 200)
+      {
+        LOG_WARN("SSE: Server answered %i.", code);
+        Stop();
+        return false;
+      }
+    }
+    else if (header.length() == 0)
+    {
+      return true;
+    }
+    else
+    {
+      header.toLowerCase();
+      if (header.startsWith("transfer-encoding:") && header.indexOf("chunked") > 0)
+      {
+        chunked = true;
+      }
+    }
+    header = "";
+  }
+
+  LOG_WARN("SSE: No response headers.");
+  Stop();
+  return false;
+}
+
+bool SseClient::Poll(const EventHandler &handler, size_t *bytesRead)
+{
+  if (!client)
+  {
+    return false;
+  }
+
+  uint8_t buffer[256];
+  size_t total = 0;
+  int available;
+
+  while ((available = client->available()) > 0)
+  {
+    int length = client->read(buffer, min((size_t)available, sizeof(buffer)));
+    if (length <= 0)
+    {
+      break;
+    }
+    Feed(buffer, length, handler);
+    total += length;
+  }
+
+  if (bytesRead != NULL)
+  {
+    *bytesRead = total;
+  }
+
+  return client->connected() || client->available() > 0;
+}
+
+void SseClient::Stop()
+{
+  if (client)
+  {
+    client->stop();
+    client.reset();
+  }
+}
+
+// Strip chunked transfer framing, passing body bytes on.
+void SseClient::Feed(const uint8_t *buffer, size_t length, const EventHandler &handler)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    char c = buffer[i];
+
+    if (!chunked)
+    {
+      FeedBody(c, handler);
+      continue;
+    }
+
+    switch (chunkState)
+    {
+    case ChunkState::Size:
+      if (isxdigit(c))
+      {
+        chunkRemaining = chunkRemaining * 16 + (isdigit(c) ? c - '0' : (tolower(c) - 'a' + 10));
+      }
+      else if (c == '\n')
+      {
+        chunkState = chunkRemaining > 0 ? ChunkState::Data : ChunkState::DataEnd;
+      }
+      else if (c != '\r')
+      {
+        // Chunk extensions, ignored up to the end of the line.
+        chunkState = ChunkState::SizeLineEnd;
+      }
+      break;
+
+    case ChunkState::SizeLineEnd:
+      if (c == '\n')
+      {
+        chunkState = chunkRemaining > 0 ? ChunkState::Data : ChunkState::DataEnd;
+      }
+      break;
+
+    case ChunkState::Data:
+      FeedBody(c, handler);
+      if (--chunkRemaining == 0)
+      {
+        chunkState = ChunkState::DataEnd;
+      }
+      break;
+
+    case ChunkState::DataEnd:
+      if (c == '\n')
+      {
+        chunkState = ChunkState::Size;
+        chunkRemaining = 0;
+      }
+      break;
+    }
+  }
+}
+
+void SseClient::FeedBody(char c, const EventHandler &handler)
+{
+  if (c == '\r')
+  {
+    return;
+  }
+
+  if (c == '\n')
+  {
+    if (lineTooLong)
+    {
+      // Its event is dropped, whatever field the line held.
+      if (!discarding)
+      {
+        oversized++;
+      }
+      discarding = true;
+      data = "";
+      lineTooLong = false;
+    }
+    else
+    {
+      ProcessLine(handler);
+    }
+    line = "";
+    return;
+  }
+
+  // A line never holds more than an event may, the rest is dropped up to its end.
+  if (line.length() >= maxEventSize)
+  {
+    lineTooLong = true;
+    return;
+  }
+  line += c;
+}
+
+// https://html.spec.whatwg.org/multipage/server-sent-events.html#event-stream-interpretation
+void SseClient::ProcessLine(const EventHandler &handler)
+{
+  if (line.length() == 0)
+  {
+    // Blank line dispatches the event.
+    if (data.length() > 0 && !discarding)
+    {
+      handler(eventName.length() > 0 ? eventName : String("message"), data);
+    }
+    data = "";
+    eventName = "";
+    discarding = false;
+    return;
+  }
+
+  if (line[0] == ':')
+  {
+    return; // Comment, used by servers as a keep alive.
+  }
+
+  int colon = line.indexOf(':');
+  String field = colon < 0 ? line : line.substring(0, colon);
+  String value = colon < 0 ? String("") : line.substring(colon + (line.length() > (unsigned int)colon + 1 && line[colon + 1] == ' ' ? 2 : 1));
+
+  if (field == "data")
+  {
+    if (data.length() + value.length() + 1 > maxEventSize)
+    {
+      if (!discarding)
+      {
+        oversized++;
+      }
+      discarding = true;
+      data = "";
+      return;
+    }
+    if (data.length() > 0)
+    {
+      data += '\n';
+    }
+    data += value;
+  }
+  else if (field == "event")
+  {
+    eventName = value;
+  }
+  else if (field == "id")
+  {
+    lastEventId = value;
+  }
+  else if (field == "retry")
+  {
+    retryMs = value.toInt();
+  }
+}
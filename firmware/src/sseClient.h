@@ -0,0 +1,86 @@
+/*
+    sseClient.h
+
+    Minimal server-sent events client over a single long lived HTTP
+    connection. Handles chunked transfer encoding, event ids for resuming
+    after a reconnect and the server's retry hint. Events are dispatched as
+    soon as their terminating blank line arrives.
+
+    Plain http:// URLs are accepted so a local stand-in server can be used.
+*/
+
+#ifndef SSECLIENT_H
+#define SSECLIENT_H
+
+#include <Arduino.h>
+#include <WiFiClientSecure.h>
+#include <functional>
+#include <memory>
+
+class SseClient
+{
+public:
+    typedef std::function<void(const String &event, const String &data)> EventHandler;
+
+    // Connects and checks the response headers. lastEventId is sent when not empty.
+    bool Connect(const String &url, const String &lastEventId, uint32_t timeoutMs);
+
+    // Consume everything currently readable, dispatching complete events.
+    // Returns false once the connection is gone.
+    bool Poll(const EventHandler &handler, size_t *bytesRead = NULL);
+
+    void Stop();
+
+    const String &LastEventId()
+    {
+        return lastEventId;
+    }
+
+    // Reconnect delay requested by the server, 0 when none was sent.
+    uint32_t RetryMs()
+    {
+        return retryMs;
+    }
+
+    // Events larger than this are discarded and counted.
+    void SetMaxEventSize(size_t size)
+    {
+        maxEventSize = size;
+    }
+
+    uint32_t Oversized()
+    {
+        return oversized;
+    }
+
+private:
+    enum class ChunkState
+    {
+        Size,
+        SizeLineEnd,
+        Data,
+        DataEnd
+    };
+
+    bool ReadHeaders(uint32_t timeoutMs);
+    void Feed(const uint8_t *buffer, size_t length, const EventHandler &handler);
+    void FeedBody(char c, const EventHandler &handler);
+    void ProcessLine(const EventHandler &handler);
+
+    std::unique_ptr<WiFiClient> client;
+    bool chunked = false;
+    ChunkState chunkState = ChunkState::Size;
+    size_t chunkRemaining = 0;
+
+    String line;
+    String eventName;
+    String data;
+    bool discarding = false;
+    bool lineTooLong = false;
+    String lastEventId;
+    uint32_t retryMs = 0;
+    size_t maxEventSize = 8192;
+    uint32_t oversized = 0;
+};
+
+#endif
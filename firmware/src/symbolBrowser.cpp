@@ -0,0 +1,124 @@
+#include "symbolBrowser.h"
+#include "layout.h"
+
+static const int titleHeight = frameLayout.titleHeight;
+static const int buttonTop = frameLayout.footerTop;
+static const int rowHeight = (buttonTop - titleHeight) / SymbolBrowser::rows;
+static const char *const buttonText[] = {"<", "", ">", "Done"};
+static const int buttonCount = 4;
+
+void SymbolBrowser::Open(SymbolPickHandler handler)
+{
+  onPick = handler;
+  active = true;
+  message = "";
+  Load(top);
+}
+
+void SymbolBrowser::Touch(uint16_t x, uint16_t y)
+{
+  if (y >= buttonTop)
+  {
+    int button = x / (tft.width() / buttonCount);
+    if (button == 0)
+    {
+      Load(top >= rows ? top - rows : 0);
+    }
+    else if (button == 1)
+    {
+      // Cycle A-Z then 0-9, landing on the first symbol at or after the letter.
+      letter = letter == 'Z' ? '0' : letter == '9' ? 'A' : letter + 1;
+      char prefix[2] = {letter, 0};
+      Load(min(index.LowerBound(prefix), index.Size() > 0 ? index.Size() - 1 : 0));
+    }
+    else if (button == 2)
+    {
+      if (top + rows < index.Size())
+      {
+        Load(top + rows);
+      }
+    }
+    else
+    {
+      Close();
+    }
+    return;
+  }
+
+  if (y > titleHeight)
+  {
+    size_t row = (y - titleHeight) / rowHeight;
+    if (row < pageLength && onPick != NULL)
+    {
+      message = onPick(page[row]);
+      DrawTitle();
+    }
+  }
+}
+
+void SymbolBrowser::Load(size_t first)
+{
+  top = first;
+  pageLength = index.Read(top, page, rows);
+  if (pageLength > 0)
+  {
+    letter = page[0].symbol[0];
+  }
+  message = "";
+  Draw();
+}
+
+void SymbolBrowser::DrawTitle()
+{
+  char buf[48];
+  tft.fillRect(1, 1, tft.width() - 2, titleHeight - 1, TFT_BLACK);
+  tft.setTextFont(0);
+  tft.setTextSize(2);
+  tft.setTextPadding(0);
+  tft.setTextDatum(ML_DATUM);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  snprintf(buf, sizeof(buf), "%u-%u of %u", top + 1, top + pageLength, index.Size());
+  tft.drawString(buf, 8, titleHeight / 2);
+
+  tft.setTextDatum(MR_DATUM);
+  tft.setTextColor(TFT_GREEN, TFT_BLACK);
+  tft.drawString(message, tft.width() - 8, titleHeight / 2);
+}
+
+void SymbolBrowser::Draw()
+{
+  tft.fillScreen(TFT_BLACK);
+  tft.drawRect(0, 0, tft.width(), tft.height(), TFT_WHITE);
+  tft.drawFastHLine(0, titleHeight, tft.width(), TFT_WHITE);
+  tft.drawFastHLine(0, buttonTop, tft.width(), TFT_WHITE);
+  DrawTitle();
+
+  tft.setTextSize(browserLayout.textSize);
+  tft.setTextPadding(0);
+  tft.setTextDatum(ML_DATUM);
+  for (size_t i = 0; i < pageLength; i++)
+  {
+    char name[sizeof(page[i].name) + 1] = {};
+    memcpy(name, page[i].name, sizeof(page[i].name));
+    name[min((size_t)browserLayout.nameChars, sizeof(page[i].name))] = 0; // What fits beside the symbol.
+
+    int y = titleHeight + i * rowHeight + rowHeight / 2 + 1;
+    tft.setTextColor(TFT_YELLOW, TFT_BLACK);
+    tft.drawString(page[i].symbol, browserLayout.symbolX, y);
+    tft.setTextColor(TFT_WHITE, TFT_BLACK);
+    tft.drawString(name, browserLayout.nameX, y);
+  }
+
+  int buttonWidth = tft.width() / buttonCount;
+  tft.setTextDatum(MC_DATUM);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  for (int i = 0; i < buttonCount; i++)
+  {
+    char label[2] = {letter, 0};
+    tft.drawString(i == 1 ? label : buttonText[i], buttonWidth * i + buttonWidth / 2, (buttonTop + tft.height()) / 2);
+    if (i > 0)
+    {
+      tft.drawFastVLine(buttonWidth * i, buttonTop, tft.height() - buttonTop, TFT_WHITE);
+    }
+  }
+}
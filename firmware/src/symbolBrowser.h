@@ -0,0 +1,49 @@
+/*
+    symbolBrowser.h
+
+    Touch driven, paged list of the symbol index. A page of rows sits
+    between a title bar and a button bar: previous page, jump to the next
+    starting letter, next page and done. Tapping a row hands the symbol
+    to the pick handler, which adds it to the watchlist.
+*/
+
+#ifndef SYMBOLBROWSER_H
+#define SYMBOLBROWSER_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include "symbolIndex.h"
+
+// Returns a short status shown in the title bar, e.g. "Added".
+typedef const char *(*SymbolPickHandler)(const SymbolRecord &record);
+
+class SymbolBrowser
+{
+public:
+    static const size_t rows = 8;
+
+    SymbolBrowser(TFT_eSPI &tft, SymbolIndex &index) : tft(tft), index(index) {}
+
+    void Open(SymbolPickHandler handler);
+    void Close() { active = false; }
+    bool Active() { return active; }
+
+    void Touch(uint16_t x, uint16_t y);
+
+private:
+    void Load(size_t first);
+    void Draw();
+    void DrawTitle();
+
+    TFT_eSPI &tft;
+    SymbolIndex &index;
+    SymbolPickHandler onPick = NULL;
+    SymbolRecord page[rows];
+    size_t pageLength = 0;
+    size_t top = 0;
+    char letter = 'A';
+    const char *message = "";
+    bool active = false;
+};
+
+#endif
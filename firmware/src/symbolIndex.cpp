@@ -0,0 +1,109 @@
+#include "symbolIndex.h"
+#include <algorithm>
+#include <memory>
+#include "sdLock.h"
+#include "logger.h"
+
+static const size_t headerSize = 12;
+static const size_t symbolSize = sizeof(SymbolRecord::symbol);
+
+// Records are NUL padded, so byte order over the whole field matches the file's sort order.
+static int CompareSymbol(const char *a, const char *b)
+{
+  return strncmp(a, b, symbolSize);
+}
+
+static void MakeKey(const char *text, char *key)
+{
+  memset(key, 0, symbolSize);
+  for (size_t i = 0; i < symbolSize - 1 && text[i]; i++)
+  {
+    key[i] = toupper(text[i]);
+  }
+}
+
+bool SymbolIndex::Begin(const char *path)
+{
+  SdLock lock;
+  file = SD.open(path, FILE_READ);
+  if (!file)
+  {
+    LOG_INFO("INDEX: No symbol index at %s.", path);
+    return false;
+  }
+
+  uint8_t header[headerSize];
+  uint32_t records;
+  uint16_t recordSize;
+  if (file.read(header, headerSize) != headerSize || memcmp(header, "QBS1", 4) != 0)
+  {
+    LOG_ERROR("INDEX: %s is not a symbol index.", path);
+    file.close();
+    return false;
+  }
+  memcpy(&records, header + 4, sizeof(records));
+  memcpy(&recordSize, header + 8, sizeof(recordSize));
+  if (recordSize != sizeof(SymbolRecord) || file.size() < headerSize + records * sizeof(SymbolRecord))
+  {
+    LOG_ERROR("INDEX: %s has an unexpected record size or is truncated.", path);
+    file.close();
+    return false;
+  }
+
+  directory.resize((records + pageSize - 1) / pageSize);
+  for (size_t page = 0; page < directory.size(); page++)
+  {
+    file.seek(headerSize + page * pageSize * sizeof(SymbolRecord));
+    file.read((uint8_t *)directory[page].data(), symbolSize);
+  }
+  count = records;
+
+  LOG_INFO("INDEX: %u symbols, %u byte directory.", count, directory.size() * symbolSize);
+  return true;
+}
+
+size_t SymbolIndex::LowerBound(const char *prefix)
+{
+  if (count == 0)
+  {
+    return 0;
+  }
+
+  char key[symbolSize];
+  MakeKey(prefix, key);
+
+  // Last page starting at or before the key, the answer is in it or starts the next one.
+  auto next = std::upper_bound(directory.begin(), directory.end(), key,
+                               [](const char *k, const std::array<char, symbolSize> &first) { return CompareSymbol(k, first.data()) < 0; });
+  size_t page = next == directory.begin() ? 0 : next - directory.begin() - 1;
+  size_t start = page * pageSize;
+
+  std::unique_ptr<SymbolRecord[]> records(new SymbolRecord[pageSize]);
+  size_t length = Read(start, records.get(), pageSize);
+  SymbolRecord *found = std::lower_bound(records.get(), records.get() + length, key,
+                                         [](const SymbolRecord &record, const char *k) { return CompareSymbol(record.symbol, k) < 0; });
+
+  return min(start + (found - records.get()), count);
+}
+
+bool SymbolIndex::Find(const char *symbol, SymbolRecord *record)
+{
+  char key[symbolSize];
+  MakeKey(symbol, key);
+
+  size_t index = LowerBound(key);
+  return Read(index, record, 1) == 1 && CompareSymbol(record->symbol, key) == 0;
+}
+
+size_t SymbolIndex::Read(size_t index, SymbolRecord *records, size_t maxRecords)
+{
+  if (index >= count)
+  {
+    return 0;
+  }
+
+  SdLock lock;
+  size_t length = min(maxRecords, count - index);
+  file.seek(headerSize + index * sizeof(SymbolRecord));
+  return file.read((uint8_t *)records, length * sizeof(SymbolRecord)) / sizeof(SymbolRecord);
+}
@@ -0,0 +1,57 @@
+/*
+    symbolIndex.h
+
+    Sorted listing of every tradable symbol kept on the SD card, too large
+    to hold in RAM. Only every pageSize'th symbol is kept in memory, a
+    lookup binary searches that directory then the one page on the card.
+
+    File layout (little endian), built by tools/buildSymbolIndex.py:
+
+        char     magic[4]      "QBS1"
+        uint32_t count
+        uint16_t recordSize    sizeof(SymbolRecord)
+        uint16_t reserved
+        SymbolRecord records[count], sorted by symbol (byte order)
+*/
+
+#ifndef SYMBOLINDEX_H
+#define SYMBOLINDEX_H
+
+#include <Arduino.h>
+#include <SD.h>
+#include <vector>
+#include <array>
+
+struct __attribute__((packed)) SymbolRecord
+{
+    char symbol[12]; // Upper case, NUL padded.
+    char name[36];   // NUL padded, truncated.
+};
+
+class SymbolIndex
+{
+public:
+    static const size_t pageSize = 64; // Records per directory entry.
+
+    bool Begin(const char *path);
+    bool Enabled() { return count > 0; }
+    size_t Size() { return count; }
+
+    // First record not less than prefix, Size() when there is none.
+    size_t LowerBound(const char *prefix);
+
+    // Exact, case insensitive lookup.
+    bool Find(const char *symbol, SymbolRecord *record);
+
+    // Reads up to maxRecords starting at index, returns the number read.
+    size_t Read(size_t index, SymbolRecord *records, size_t maxRecords);
+
+private:
+    File file;
+    size_t count = 0;
+    std::vector<std::array<char, sizeof(SymbolRecord::symbol)>> directory; // First symbol of each page.
+};
+
+extern SymbolIndex symbolIndex;
+
+#endif
@@ -0,0 +1,58 @@
+/*
+    taskConfig.h
+
+    Where every task runs. Networking and parsing share the protocol core
+    with the WiFi stack and AsyncTCP (pinned in platformio.ini), rendering,
+    the matrix and touch stay on the application core with loop().
+
+    Priorities sit well below the WiFi (23) and lwIP (18) tasks, which
+    preempt us whenever a packet arrives.
+
+    Task            Core  Prio  Stack  Role
+    loop()          1     1     8192   Display, matrix, touch, housekeeping (Arduino loopTask).
+    FetchQuotes     0     3     8192   Budgeted polling, woken early through fetchQueue.
+    StreamQuotes    0     3     8192   Server-sent events, conflated ingest.
+    ReplayCapture   0     2     8192   Captured responses through the parse path.
+    DemoMarket      0     2     4096   Synthetic quotes.
+    PeerQuotes      0     2     4096   Quotes from other QuoteBots, queued by the AsyncUDP task.
+    Log             0     1     3072   UART and SD log mirror.
+*/
+
+#ifndef TASKCONFIG_H
+#define TASKCONFIG_H
+
+#include <Arduino.h>
+
+const BaseType_t coreProtocol = 0;
+const BaseType_t coreApplication = 1;
+
+struct TaskConfig
+{
+    const char *name;
+    uint32_t stackBytes;
+    UBaseType_t priority;
+    BaseType_t core;
+};
+
+const TaskConfig loopTaskConfig = {"loop", 8192, 1, coreApplication}; // Created by the Arduino core, listed for reporting.
+const TaskConfig fetchTaskConfig = {"FetchQuotes", 8192, 3, coreProtocol};
+const TaskConfig streamTaskConfig = {"StreamQuotes", 8192, 3, coreProtocol};
+const TaskConfig replayTaskConfig = {"ReplayCapture", 8192, 2, coreProtocol};
+const TaskConfig demoTaskConfig = {"DemoMarket", 4096, 2, coreProtocol};
+const TaskConfig peerTaskConfig = {"PeerQuotes", 4096, 2, coreProtocol};
+const TaskConfig logTaskConfig = {"Log", 3072, tskIDLE_PRIORITY + 1, coreProtocol};
+
+inline BaseType_t StartTask(TaskFunction_t function, const TaskConfig &config, void *parameter = NULL, TaskHandle_t *handle = NULL)
+{
+    return xTaskCreatePinnedToCore(function, config.name, config.stackBytes, parameter, config.priority, handle, config.core);
+}
+
+// Requests to the fetch task, queued by the application core.
+enum class FetchRequest : uint8_t
+{
+    NewSymbols // Symbols without a quote were listed, fetch without waiting for the budget slot.
+};
+
+extern QueueHandle_t fetchQueue;
+
+#endif
@@ -0,0 +1,52 @@
+#include "teeStream.h"
+
+// Bytes still allowed, one more is read past the limit to tell a full body from a long one.
+size_t TeeStream::Room()
+{
+  if (length >= maxLength && !overflowed && source.peek() >= 0)
+  {
+    overflowed = true;
+  }
+  return overflowed ? 0 : maxLength - length;
+}
+
+int TeeStream::available()
+{
+  return min((size_t)source.available(), Room());
+}
+
+int TeeStream::read()
+{
+  if (Room() == 0)
+  {
+    return -1;
+  }
+  int c = source.read();
+  if (c >= 0)
+  {
+    copy.write((uint8_t)c);
+    length++;
+  }
+  return c;
+}
+
+int TeeStream::peek()
+{
+  return Room() == 0 ? -1 : source.peek();
+}
+
+size_t TeeStream::readBytes(char *buffer, size_t size)
+{
+  size_t count = source.readBytes(buffer, min(size, Room()));
+  copy.write((const uint8_t *)buffer, count);
+  length += count;
+  return count;
+}
+
+void TeeStream::Drain()
+{
+  char buffer[128];
+  while (readBytes(buffer, sizeof(buffer)) > 0)
+  {
+  }
+}
@@ -0,0 +1,53 @@
+/*
+    teeStream.h
+
+    Read side Stream that hands every byte taken from its source to a copy,
+    so a response body is parsed straight off the socket while it is hashed
+    and spooled to the SD card. Reading stops after maxLength bytes, a body
+    that long is never complete.
+*/
+
+#ifndef TEESTREAM_H
+#define TEESTREAM_H
+
+#include <Arduino.h>
+
+class TeeStream : public Stream
+{
+public:
+    TeeStream(Stream &source, Print &copy, size_t maxLength) : source(source), copy(copy), maxLength(maxLength) {}
+
+    // The source had more than maxLength bytes.
+    bool Overflowed()
+    {
+        return overflowed;
+    }
+
+    size_t Length()
+    {
+        return length;
+    }
+
+    // Read what the parser left behind, so the copy holds the whole body.
+    void Drain();
+
+    int available() override;
+    int read() override;
+    int peek() override;
+    size_t readBytes(char *buffer, size_t length) override;
+    size_t write(uint8_t) override
+    {
+        return 0;
+    }
+
+private:
+    size_t Room();
+
+    Stream &source;
+    Print &copy;
+    size_t maxLength;
+    size_t length = 0;
+    bool overflowed = false;
+};
+
+#endif
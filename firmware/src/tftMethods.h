@@ -6,6 +6,7 @@
 #include "FS.h"
 #include <TFT_eSPI.h>
 #include <SPIFFS.h>
+#include "logger.h"
 
 #define CALIBRATION_FILE "/TouchCalData"
 
@@ -16,11 +17,11 @@ void CheckTouchCalibration(TFT_eSPI *tft, bool forceCalibrationFlag)
 
     if (SPIFFS.begin())
     {
-        Serial.println("SPIFFS: Exists.");
+        LOG_INFO("SPIFFS: Exists.");
     }
     else
     {
-        Serial.println("SPIFFS: Formating file system.");
+        LOG_INFO("SPIFFS: Formating file system.");
         SPIFFS.format();
         SPIFFS.begin();
     }
@@ -28,7 +29,7 @@ void CheckTouchCalibration(TFT_eSPI *tft, bool forceCalibrationFlag)
     // check if calibration file exists and size is correct
     if (SPIFFS.exists(CALIBRATION_FILE))
     {
-        Serial.println("SPIFFS: Getting calibration file.");
+        LOG_INFO("SPIFFS: Getting calibration file.");
         File f = SPIFFS.open(CALIBRATION_FILE, "r");
         if (f)
         {
@@ -41,19 +42,19 @@ void CheckTouchCalibration(TFT_eSPI *tft, bool forceCalibrationFlag)
     }
     else
     {
-        Serial.println("SPIFFS: calibration files does not exist.");
+        LOG_INFO("SPIFFS: calibration files does not exist.");
     }
 
     if (calDataOK && !forceCalibrationFlag)
     {
         // calibration data valid
-        Serial.println("TFT: calibration data valid.");
+        LOG_INFO("TFT: calibration data valid.");
         tft->setTouch(calData);
     }
     else
     {
-        Serial.println("TFT: calibration data invalid.");
-        Serial.println("TFT: Start calibration.");
+        LOG_INFO("TFT: calibration data invalid.");
+        LOG_INFO("TFT: Start calibration.");
 
         // data not valid so recalibrate
         tft->fillScreen(TFT_BLACK);
@@ -75,6 +76,6 @@ void CheckTouchCalibration(TFT_eSPI *tft, bool forceCalibrationFlag)
             f.write((const unsigned char *)calData, 14);
             f.close();
         }
-        Serial.println("TFT: calibration complete.");
+        LOG_INFO("TFT: calibration complete.");
     }
 }
\ No newline at end of file
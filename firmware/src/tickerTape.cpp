@@ -0,0 +1,143 @@
+#include "tickerTape.h"
+#include "fixedPoint.h"
+#include "layout.h"
+
+static const int titleHeight = frameLayout.titleHeight;
+static const int bandLeft = 1;
+static const int bandWidth = screen.width - 2;
+static const int bandHeight = tapeLayout.bandHeight;
+static const int bandTop = tapeLayout.bandTop;
+static const int textTop = tapeLayout.textTop;
+static const size_t entryGap = 36; // Blank columns after each symbol.
+
+void TickerTape::Open(size_t symbolCount)
+{
+  active = true;
+  entries.clear();
+  entries.resize(symbolCount);
+  frame.assign(bandWidth * bandHeight, TFT_BLACK);
+  renderer.SetTextSize(tapeLayout.textSize);
+  tapeWidth = 0;
+  position = 0;
+  lastFrame = millis();
+
+  tft.fillRect(1, 1, tft.width() - 2, titleHeight - 1, TFT_BLACK); // Also clears the symbol box divider.
+  tft.fillRect(1, frameLayout.centerTop, tft.width() - 2, frameLayout.centerHeight, TFT_BLACK);
+  tft.setTextFont(0);
+  tft.setTextSize(2);
+  tft.setTextPadding(0);
+  tft.setTextDatum(ML_DATUM);
+  tft.setTextColor(TFT_WHITE, TFT_BLACK);
+  tft.drawString("Ticker tape", 8, titleHeight / 2);
+  tft.drawFastHLine(1, bandTop - 2, tft.width() - 2, TFT_DARKGREY);
+  tft.drawFastHLine(1, bandTop + bandHeight + 1, tft.width() - 2, TFT_DARKGREY);
+}
+
+void TickerTape::Close()
+{
+  active = false;
+  entries.clear();
+  entries.shrink_to_fit();
+  frame.clear();
+  frame.shrink_to_fit();
+}
+
+// Symbol in white, price and change in the colour of the change.
+void TickerTape::Build(Entry &entry, const QuoteTile &tile)
+{
+  char price[16];
+  char percent[16];
+  uint16_t color = !tile.valid ? TFT_DARKGREY : tile.change > 0 ? TFT_GREEN : tile.change < 0 ? TFT_RED : TFT_WHITE;
+
+  entry.run.Clear();
+  renderer.Append(&entry.run, tile.symbol.c_str(), TFT_WHITE);
+  renderer.AppendGap(&entry.run, 12);
+  if (tile.valid)
+  {
+    FormatFixed(price, sizeof(price), tile.price, tile.decimals, tile.decimals);
+    percent[0] = tile.changePercent > 0 ? '+' : 0;
+    size_t length = FormatFixed(percent + (percent[0] ? 1 : 0), sizeof(percent) - 2, tile.changePercent, 2, 2) + (percent[0] ? 1 : 0);
+    percent[length] = '%';
+    percent[length + 1] = 0;
+    renderer.Append(&entry.run, price, color);
+    renderer.AppendGap(&entry.run, 12);
+    renderer.Append(&entry.run, percent, color);
+  }
+  else
+  {
+    renderer.Append(&entry.run, "--", color);
+  }
+  renderer.AppendGap(&entry.run, entryGap);
+
+  entry.version = tile.version;
+  entry.built = true;
+}
+
+bool TickerTape::Update(const QuoteTileSource &source, uint32_t pixelsPerSecond)
+{
+  unsigned long now = millis();
+  if (now - lastFrame < frameIntervalMs)
+  {
+    return false;
+  }
+
+  // Runs change width with their text, the tape width is summed again after a rebuild.
+  QuoteTile tile;
+  bool rebuilt = false;
+  for (size_t i = 0; i < entries.size(); i++)
+  {
+    if (source(i, entries[i].version, !entries[i].built, &tile))
+    {
+      Build(entries[i], tile);
+      rebuilt = true;
+    }
+  }
+  if (rebuilt)
+  {
+    tapeWidth = 0;
+    for (auto &entry : entries)
+    {
+      tapeWidth += entry.run.Width();
+    }
+  }
+  if (tapeWidth == 0)
+  {
+    return false;
+  }
+
+  position += (now - lastFrame) * pixelsPerSecond / 1000.0f;
+  position = fmodf(position, tapeWidth);
+  lastFrame = now;
+
+  Render();
+  return true;
+}
+
+// Copies the visible columns of consecutive runs into the band, wrapping around the tape.
+void TickerTape::Render()
+{
+  std::fill(frame.begin(), frame.end(), TFT_BLACK);
+
+  size_t column = size_t(position);
+  size_t entry = 0;
+  while (column >= entries[entry].run.Width())
+  {
+    column -= entries[entry].run.Width();
+    entry = (entry + 1) % entries.size();
+  }
+
+  int x = 0;
+  while (x < bandWidth)
+  {
+    const GlyphRun &run = entries[entry].run;
+    size_t count = min(run.Width() - column, (size_t)(bandWidth - x));
+    BlitGlyphRun(run, column, count, frame.data(), bandWidth, x, textTop);
+    x += count;
+    column = 0;
+    entry = (entry + 1) % entries.size();
+  }
+
+  tft.setSwapBytes(true);
+  tft.pushImage(bandLeft, bandTop, bandWidth, bandHeight, frame.data());
+  tft.setSwapBytes(false);
+}
@@ -0,0 +1,57 @@
+/*
+    tickerTape.h
+
+    Ticker tape page: every watchlist symbol with its price and change
+    scrolls right to left through a band across the center area. Each
+    symbol's text is rasterized into a glyph run (see glyphRun.h) when its
+    quote changes, a frame only copies the visible columns of the runs into
+    the band buffer and pushes it. The scroll position follows the clock,
+    so the speed stays steady when a frame is late.
+*/
+
+#ifndef TICKERTAPE_H
+#define TICKERTAPE_H
+
+#include <Arduino.h>
+#include <TFT_eSPI.h>
+#include <vector>
+#include "glyphRun.h"
+#include "quoteTile.h"
+
+class TickerTape
+{
+public:
+    static const unsigned long frameIntervalMs = 25; // 40 frames per second.
+
+    TickerTape(TFT_eSPI &tft) : tft(tft), renderer(tft) {}
+
+    void Open(size_t symbolCount);
+    void Close();
+    bool Active() { return active; }
+
+    // Rebuilds the runs of changed quotes, then pushes a frame when one is due.
+    // Returns true when a frame was pushed.
+    bool Update(const QuoteTileSource &source, uint32_t pixelsPerSecond);
+
+private:
+    struct Entry
+    {
+        GlyphRun run;
+        uint32_t version = 0;
+        bool built = false;
+    };
+
+    void Build(Entry &entry, const QuoteTile &tile);
+    void Render();
+
+    TFT_eSPI &tft;
+    GlyphRunRenderer renderer;
+    bool active = false;
+    std::vector<Entry> entries;
+    std::vector<uint16_t> frame; // Band buffer, row major.
+    size_t tapeWidth = 0;        // Sum of the run widths.
+    float position = 0;          // Tape column at the left edge of the band.
+    unsigned long lastFrame = 0;
+};
+
+#endif
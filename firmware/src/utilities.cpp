@@ -1,10 +1,16 @@
 #include <Arduino.h>
 
-float mapFloat(float x, float in_min, float in_max, float out_min, float out_max)
+// Integer map() over scaled prices, 64 bit intermediates avoid overflow.
+int mapFixed(int32_t x, int32_t in_min, int32_t in_max, int out_min, int out_max)
 {
-  const float dividend = out_max - out_min;
-  const float divisor = in_max - in_min;
-  const float delta = x - in_min;
+  const int64_t dividend = out_max - out_min;
+  const int64_t divisor = (int64_t)in_max - in_min;
+  const int64_t delta = (int64_t)x - in_min;
+
+  if (divisor == 0)
+  {
+    return out_min;
+  }
 
   return (delta * dividend + (divisor / 2)) / divisor + out_min;
 }
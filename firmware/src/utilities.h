@@ -4,5 +4,7 @@
     Helper methods.
 */
 
-float mapFloat(float x, float in_min, float in_max, float out_min, float out_max);
+#include <stdint.h>
+
+int mapFixed(int32_t x, int32_t in_min, int32_t in_max, int out_min, int out_max);
 int rotateMatrix(unsigned int i);
\ No newline at end of file
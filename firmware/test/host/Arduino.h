@@ -0,0 +1,231 @@
+/*
+    Arduino.h
+
+    Host stand-in for the parts of the Arduino core used by the modules
+    built in the native test environment (see platformio.ini): String,
+    Print, Stream, the clock and the few FreeRTOS calls. It is only as
+    complete as those modules and their tests need. Tests run on one
+    thread, time stands still unless a test moves it with delay() or a
+    module waits with vTaskDelay() or a semaphore timeout.
+*/
+
+#ifndef HOST_ARDUINO_H
+#define HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <time.h>
+#include <algorithm>
+#include <string>
+
+using std::max;
+using std::min;
+
+inline unsigned long &HostMillis()
+{
+    static unsigned long now = 0;
+    return now;
+}
+
+inline unsigned long millis()
+{
+    return HostMillis();
+}
+
+inline void delay(uint32_t ms)
+{
+    HostMillis() += ms;
+}
+
+// FreeRTOS at a 1 kHz tick. A semaphore is a count, taking an empty one waits out its timeout.
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY 0xffffffffUL
+#define pdMS_TO_TICKS(ms) ((TickType_t)(ms))
+
+struct HostSemaphore
+{
+    int count;
+};
+typedef HostSemaphore *SemaphoreHandle_t;
+
+inline SemaphoreHandle_t xSemaphoreCreateMutex()
+{
+    return new HostSemaphore{1};
+}
+
+inline SemaphoreHandle_t xSemaphoreCreateBinary()
+{
+    return new HostSemaphore{0};
+}
+
+inline BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t ticks)
+{
+    if (semaphore->count > 0)
+    {
+        semaphore->count--;
+        return pdTRUE;
+    }
+    if (ticks != portMAX_DELAY) // Nothing else runs to give it, it would never return.
+    {
+        delay(ticks);
+    }
+    return pdFALSE;
+}
+
+inline BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore)
+{
+    semaphore->count = 1;
+    return pdTRUE;
+}
+
+inline void vTaskDelay(TickType_t ticks)
+{
+    delay(ticks);
+}
+
+// In newlib, not in glibc before 2.38.
+#if defined(__GLIBC__) && (__GLIBC__ < 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ < 38))
+inline size_t strlcpy(char *destination, const char *source, size_t size)
+{
+    size_t length = strlen(source);
+    if (size > 0)
+    {
+        size_t copied = min(length, size - 1);
+        memcpy(destination, source, copied);
+        destination[copied] = 0;
+    }
+    return length;
+}
+#endif
+
+class String
+{
+public:
+    String(const char *text = "") : text(text != NULL ? text : "") {}
+    String(const std::string &text) : text(text) {}
+    explicit String(char c) : text(1, c) {}
+
+    const char *c_str() const { return text.c_str(); }
+    unsigned int length() const { return text.length(); }
+    bool reserve(unsigned int size)
+    {
+        text.reserve(size);
+        return true;
+    }
+
+    char operator[](unsigned int index) const { return index < text.length() ? text[index] : 0; }
+    char &operator[](unsigned int index) { return text[index]; }
+
+    String &operator+=(const String &other)
+    {
+        text += other.text;
+        return *this;
+    }
+    String &operator+=(const char *other)
+    {
+        text += other;
+        return *this;
+    }
+    String &operator+=(char c)
+    {
+        text += c;
+        return *this;
+    }
+    bool concat(const char *other, unsigned int length)
+    {
+        text.append(other, length);
+        return true;
+    }
+
+    bool operator==(const String &other) const { return text == other.text; }
+    bool operator==(const char *other) const { return text == other; }
+    bool operator!=(const String &other) const { return text != other.text; }
+    bool equalsIgnoreCase(const String &other) const { return strcasecmp(text.c_str(), other.text.c_str()) == 0; }
+    bool startsWith(const String &prefix) const { return text.compare(0, prefix.text.length(), prefix.text) == 0; }
+
+    int indexOf(char c, unsigned int from = 0) const
+    {
+        size_t found = text.find(c, from);
+        return found == std::string::npos ? -1 : (int)found;
+    }
+    int indexOf(const char *other, unsigned int from = 0) const
+    {
+        size_t found = text.find(other, from);
+        return found == std::string::npos ? -1 : (int)found;
+    }
+    String substring(unsigned int from, unsigned int to) const
+    {
+        return from < to && from < text.length() ? String(text.substr(from, to - from)) : String();
+    }
+    String substring(unsigned int from) const { return substring(from, text.length()); }
+
+    void toCharArray(char *buffer, unsigned int size) const { strlcpy(buffer, text.c_str(), size); }
+    long toInt() const { return atol(text.c_str()); }
+
+private:
+    std::string text;
+};
+
+inline String operator+(const String &a, const String &b)
+{
+    String sum = a;
+    sum += b;
+    return sum;
+}
+
+inline String operator+(const String &a, const char *b)
+{
+    return a + String(b);
+}
+
+class Print
+{
+public:
+    virtual ~Print() {}
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buffer, size_t size)
+    {
+        size_t written = 0;
+        while (size-- > 0)
+        {
+            written += write(*buffer++);
+        }
+        return written;
+    }
+    size_t write(const char *text) { return write((const uint8_t *)text, strlen(text)); }
+    size_t print(const char *text) { return write(text); }
+    size_t print(const String &text) { return write(text.c_str()); }
+};
+
+// Reads never wait, a host source has all its data or ends.
+class Stream : public Print
+{
+public:
+    virtual int available() = 0;
+    virtual int read() = 0;
+    virtual int peek() = 0;
+    virtual size_t readBytes(char *buffer, size_t length)
+    {
+        size_t count = 0;
+        int c;
+        while (count < length && (c = read()) >= 0)
+        {
+            buffer[count++] = c;
+        }
+        return count;
+    }
+    size_t readBytes(uint8_t *buffer, size_t length) { return readBytes((char *)buffer, length); }
+    void setTimeout(unsigned long) {}
+};
+
+#endif
@@ -0,0 +1,12 @@
+/*
+    Stream.h
+
+    Host stand-in, Stream is declared with the rest of the core in Arduino.h.
+*/
+
+#ifndef HOST_STREAM_H
+#define HOST_STREAM_H
+
+#include "Arduino.h"
+
+#endif
@@ -0,0 +1,41 @@
+/*
+    WiFi.h
+
+    Host stand-in for the WiFi library: a WiFiClient whose reads a test
+    overrides to script a connection, and IPAddress literals. There is no
+    network behind them.
+*/
+
+#ifndef HOST_WIFI_H
+#define HOST_WIFI_H
+
+#include <Arduino.h>
+#include <arpa/inet.h>
+
+class IPAddress
+{
+public:
+    bool fromString(const char *text)
+    {
+        return inet_pton(AF_INET, text, &address) == 1;
+    }
+
+private:
+    in_addr address;
+};
+
+class WiFiClient : public Stream
+{
+public:
+    virtual uint8_t connected() { return 0; }
+    int available() override { return 0; }
+    int read() override { return -1; }
+    int peek() override { return -1; }
+    size_t write(uint8_t) override { return 0; }
+    int fd() const { return socket; }
+
+protected:
+    int socket = -1;
+};
+
+#endif
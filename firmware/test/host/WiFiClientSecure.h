@@ -0,0 +1,33 @@
+/*
+    WiFiClientSecure.h
+
+    Host stand-in for the TLS client, only the session context holding
+    the socket that httpDeadline.h reaches into.
+*/
+
+#ifndef HOST_WIFICLIENTSECURE_H
+#define HOST_WIFICLIENTSECURE_H
+
+#include "WiFi.h"
+
+struct sslclient_context
+{
+    int socket = -1;
+};
+
+class WiFiClientSecure : public WiFiClient
+{
+public:
+    WiFiClientSecure() : sslclient(new sslclient_context) {}
+    ~WiFiClientSecure() { delete sslclient; }
+    WiFiClientSecure(const WiFiClientSecure &) = delete;
+    WiFiClientSecure &operator=(const WiFiClientSecure &) = delete;
+
+    void setInsecure() {}
+    void setHandshakeTimeout(unsigned long) {}
+
+protected:
+    sslclient_context *sslclient;
+};
+
+#endif
@@ -0,0 +1,30 @@
+/*
+    dns.h
+
+    Host stand-in for the lwIP resolver. Only literal addresses resolve,
+    every name lookup fails at once.
+*/
+
+#ifndef HOST_LWIP_DNS_H
+#define HOST_LWIP_DNS_H
+
+#include <stdint.h>
+
+typedef int8_t err_t;
+#define ERR_OK 0
+#define ERR_INPROGRESS -5
+#define ERR_VAL -6
+
+struct ip_addr_t
+{
+    uint32_t addr;
+};
+
+typedef void (*dns_found_callback)(const char *name, const ip_addr_t *address, void *arg);
+
+inline err_t dns_gethostbyname(const char *, ip_addr_t *, dns_found_callback, void *)
+{
+    return ERR_VAL;
+}
+
+#endif
@@ -0,0 +1,12 @@
+/*
+    sockets.h
+
+    Host stand-in for the lwIP socket calls, the host's own.
+*/
+
+#ifndef HOST_LWIP_SOCKETS_H
+#define HOST_LWIP_SOCKETS_H
+
+#include <sys/socket.h>
+
+#endif
@@ -0,0 +1,79 @@
+/*
+    miniz.h
+
+    Host stand-in for the tinfl inflater in the ESP32 ROM, built on zlib
+    (link with -lz). Same calls, flags and status codes as far as
+    GzipStream uses them. zlib keeps its own history, so the caller's
+    circular window only receives the output. The zlib state is not
+    released, the owner frees the decompressor with free() as it does on
+    the device, which is acceptable in a short lived test.
+*/
+
+#ifndef HOST_MINIZ_H
+#define HOST_MINIZ_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <zlib.h>
+
+#define TINFL_LZ_DICT_SIZE 32768
+
+enum
+{
+    TINFL_FLAG_PARSE_ZLIB_HEADER = 1,
+    TINFL_FLAG_HAS_MORE_INPUT = 2,
+    TINFL_FLAG_USING_NON_WRAPPING_OUTPUT_BUF = 4,
+    TINFL_FLAG_COMPUTE_ADLER32 = 8
+};
+
+typedef enum
+{
+    TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS = -4,
+    TINFL_STATUS_BAD_PARAM = -3,
+    TINFL_STATUS_ADLER32_MISMATCH = -2,
+    TINFL_STATUS_FAILED = -1,
+    TINFL_STATUS_DONE = 0,
+    TINFL_STATUS_NEEDS_MORE_INPUT = 1,
+    TINFL_STATUS_HAS_MORE_OUTPUT = 2
+} tinfl_status;
+
+struct tinfl_decompressor
+{
+    z_stream stream;
+};
+
+inline void tinfl_init(tinfl_decompressor *r)
+{
+    r->stream = z_stream();
+    inflateInit2(&r->stream, -MAX_WBITS); // Raw deflate, the caller parses the gzip header.
+}
+
+inline tinfl_status tinfl_decompress(tinfl_decompressor *r, const uint8_t *in, size_t *inSize, uint8_t *outStart,
+                                     uint8_t *outNext, size_t *outSize, uint32_t flags)
+{
+    z_stream &stream = r->stream;
+    stream.next_in = (Bytef *)in;
+    stream.avail_in = *inSize;
+    stream.next_out = outNext;
+    stream.avail_out = *outSize;
+
+    int result = inflate(&stream, Z_NO_FLUSH);
+    *inSize -= stream.avail_in;
+    *outSize -= stream.avail_out;
+
+    if (result == Z_STREAM_END)
+    {
+        return TINFL_STATUS_DONE;
+    }
+    if (result != Z_OK && result != Z_BUF_ERROR)
+    {
+        return TINFL_STATUS_FAILED;
+    }
+    if (stream.avail_out == 0)
+    {
+        return TINFL_STATUS_HAS_MORE_OUTPUT;
+    }
+    return flags & TINFL_FLAG_HAS_MORE_INPUT ? TINFL_STATUS_NEEDS_MORE_INPUT : TINFL_STATUS_FAILED_CANNOT_MAKE_PROGRESS;
+}
+
+#endif
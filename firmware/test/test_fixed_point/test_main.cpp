@@ -0,0 +1,172 @@
+#include <unity.h>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "fixedPoint.h"
+
+void setUp() {}
+void tearDown() {}
+
+static void AssertFormat(const char *expected, int32_t value, uint8_t decimals, uint8_t precision, char thousandsSeparator = 0)
+{
+  char buf[32];
+  size_t length = FormatFixed(buf, sizeof(buf), value, decimals, precision, thousandsSeparator);
+  TEST_ASSERT_EQUAL_STRING(expected, buf);
+  TEST_ASSERT_EQUAL_size_t(strlen(expected), length);
+}
+
+void test_format_scales()
+{
+  AssertFormat("123.45", 12345, 2, 2);
+  AssertFormat("0.0005", 5, 4, 4);
+  AssertFormat("-1.50", -150, 2, 2);
+  AssertFormat("0.00", 0, 2, 2);
+  AssertFormat("42", 42, 0, 0);
+  AssertFormat("2147.483647", INT32_MAX, 6, 6);
+  AssertFormat("-2147483648", INT32_MIN, 0, 0);
+}
+
+void test_format_rounds_half_away_from_zero()
+{
+  AssertFormat("12.35", 12345, 3, 2);
+  AssertFormat("-12.35", -12345, 3, 2);
+  AssertFormat("12.34", 12344, 3, 2);
+  AssertFormat("13", 1250, 2, 0);
+  AssertFormat("1.00", 9995, 4, 2);
+  AssertFormat("-0.00", -4, 3, 2);
+}
+
+void test_format_pads_missing_decimals()
+{
+  AssertFormat("5.00", 5, 0, 2);
+  AssertFormat("1.230000", 123, 2, 6);
+}
+
+void test_format_thousands_separator()
+{
+  AssertFormat("1,234,567.89", 123456789, 2, 2, ',');
+  AssertFormat("1,000.00", 100000, 2, 2, ',');
+  AssertFormat("999.99", 99999, 2, 2, ',');
+  AssertFormat("-12'345", -12345, 0, 0, '\'');
+}
+
+void test_format_buffer_too_small()
+{
+  char buf[7];
+  TEST_ASSERT_EQUAL_size_t(6, FormatFixed(buf, sizeof(buf), 12345, 2, 2));
+  TEST_ASSERT_EQUAL_STRING("123.45", buf);
+  TEST_ASSERT_EQUAL_size_t(0, FormatFixed(buf, 6, 12345, 2, 2));
+  TEST_ASSERT_EQUAL_STRING("", buf);
+  TEST_ASSERT_EQUAL_size_t(0, FormatFixed(buf, 0, 12345, 2, 2));
+}
+
+void test_format_clamps_decimals()
+{
+  AssertFormat("0.000001", 1, 9, 9);
+}
+
+// Where no digit is dropped the result is the same as printf's, character for character.
+void test_format_matches_printf()
+{
+  uint32_t seed = 12345;
+  char fixed[32];
+  char printed[32];
+  for (int i = 0; i < 100000; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    int32_t value = (int32_t)seed >> (seed % 24);
+    uint8_t decimals = seed % (fixedMaxDecimals + 1);
+    uint8_t precision = decimals + (seed >> 8) % (fixedMaxDecimals + 1 - decimals);
+
+    FormatFixed(fixed, sizeof(fixed), value, decimals, precision);
+    snprintf(printed, sizeof(printed), "%.*f", precision, (double)value / FixedPow10(decimals));
+    TEST_ASSERT_EQUAL_STRING(printed, fixed);
+  }
+}
+
+void test_from_double()
+{
+  TEST_ASSERT_EQUAL_INT32(12345, FixedFromDouble(123.45, 2));
+  TEST_ASSERT_EQUAL_INT32(5, FixedFromDouble(0.0005, 4));
+  TEST_ASSERT_EQUAL_INT32(13, FixedFromDouble(0.125, 2));
+  TEST_ASSERT_EQUAL_INT32(-13, FixedFromDouble(-0.125, 2));
+  TEST_ASSERT_EQUAL_INT32(INT32_MAX, FixedFromDouble(1e12, 2));
+  TEST_ASSERT_EQUAL_INT32(-INT32_MAX, FixedFromDouble(-1e12, 2));
+}
+
+// A price parsed from JSON prints back as written.
+void test_from_double_round_trip()
+{
+  const char *prices[] = {"0.0001", "0.0123", "1.05", "19.99", "123.45", "4321.1", "99999.99"};
+  char formatted[32];
+  for (const char *price : prices)
+  {
+    double value = atof(price);
+    uint8_t decimals = strlen(strchr(price, '.') + 1);
+    FormatFixed(formatted, sizeof(formatted), FixedFromDouble(value, decimals), decimals, decimals);
+    TEST_ASSERT_EQUAL_STRING(price, formatted);
+  }
+}
+
+void test_rescale()
+{
+  TEST_ASSERT_EQUAL_INT32(1234500, FixedRescale(12345, 2, 4));
+  TEST_ASSERT_EQUAL_INT32(123, FixedRescale(12345, 4, 2));
+  TEST_ASSERT_EQUAL_INT32(124, FixedRescale(12350, 4, 2));
+  TEST_ASSERT_EQUAL_INT32(-124, FixedRescale(-12350, 4, 2));
+  TEST_ASSERT_EQUAL_INT32(INT32_MAX, FixedRescale(INT32_MAX / 10, 0, 2));
+}
+
+void test_decimals_for_price()
+{
+  TEST_ASSERT_EQUAL_UINT8(fixedSubDollarDecimals, FixedDecimalsForPrice(0.0123));
+  TEST_ASSERT_EQUAL_UINT8(fixedDefaultDecimals, FixedDecimalsForPrice(123.45));
+}
+
+// FormatFixed against the snprintf it replaced, the same prices at the same precision.
+void test_benchmark_against_snprintf()
+{
+  const int rounds = 200000;
+  char buf[32];
+  volatile size_t sink = 0;
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++)
+  {
+    sink += FormatFixed(buf, sizeof(buf), 1234567 + i, 2, 2);
+  }
+  auto fixed = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++)
+  {
+    sink += snprintf(buf, sizeof(buf), "%.2f", (1234567 + i) / 100.0);
+  }
+  auto printed = std::chrono::steady_clock::now() - start;
+
+  long fixedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(fixed).count() / rounds;
+  long printedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(printed).count() / rounds;
+  char message[96];
+  snprintf(message, sizeof(message), "FormatFixed %ld ns, snprintf %ld ns per price", fixedNs, printedNs);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_THAN(printed.count(), fixed.count());
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_format_scales);
+  RUN_TEST(test_format_rounds_half_away_from_zero);
+  RUN_TEST(test_format_pads_missing_decimals);
+  RUN_TEST(test_format_thousands_separator);
+  RUN_TEST(test_format_buffer_too_small);
+  RUN_TEST(test_format_clamps_decimals);
+  RUN_TEST(test_format_matches_printf);
+  RUN_TEST(test_from_double);
+  RUN_TEST(test_from_double_round_trip);
+  RUN_TEST(test_rescale);
+  RUN_TEST(test_decimals_for_price);
+  RUN_TEST(test_benchmark_against_snprintf);
+  return UNITY_END();
+}
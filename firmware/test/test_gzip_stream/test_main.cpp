@@ -0,0 +1,272 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <ArduinoJson.h>
+#include <zlib.h>
+#include <chrono>
+#include <string>
+#include <vector>
+#include "gzipStream.h"
+
+void setUp() {}
+void tearDown() {}
+
+// In memory source handing out at most chunk bytes per read, as a socket would.
+class MemoryStream : public Stream
+{
+public:
+  MemoryStream(const std::vector<uint8_t> &data, size_t chunk = 512) : data(data), chunk(chunk) {}
+
+  int available() override { return data.size() - position; }
+  int read() override { return position < data.size() ? data[position++] : -1; }
+  int peek() override { return position < data.size() ? data[position] : -1; }
+  size_t readBytes(char *buffer, size_t length) override
+  {
+    size_t count = min(min(length, chunk), data.size() - position);
+    memcpy(buffer, data.data() + position, count);
+    position += count;
+    return count;
+  }
+  size_t write(uint8_t) override { return 0; }
+
+private:
+  const std::vector<uint8_t> &data;
+  size_t chunk;
+  size_t position = 0;
+};
+
+// windowBits 15 + 16 writes the gzip header and trailer, -15 raw deflate only.
+static std::vector<uint8_t> Deflate(const std::string &text, int windowBits)
+{
+  z_stream stream = z_stream();
+  deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+  std::vector<uint8_t> out(deflateBound(&stream, text.size()) + 32);
+  stream.next_in = (Bytef *)text.data();
+  stream.avail_in = text.size();
+  stream.next_out = out.data();
+  stream.avail_out = out.size();
+  deflate(&stream, Z_FINISH);
+  out.resize(stream.total_out);
+  deflateEnd(&stream);
+  return out;
+}
+
+static std::vector<uint8_t> Gzip(const std::string &text)
+{
+  return Deflate(text, 15 + 16);
+}
+
+static std::string ReadAll(Stream &stream)
+{
+  std::string text;
+  char buf[300]; // Not a divisor of the window, reads straddle its wrap.
+  size_t count;
+  while ((count = stream.readBytes(buf, sizeof(buf))) > 0)
+  {
+    text.append(buf, count);
+  }
+  return text;
+}
+
+// Repetitive like a quote batch, with enough variation not to collapse into a few matches.
+static std::string QuoteText(size_t length)
+{
+  std::string text;
+  char entry[96];
+  for (int i = 0; text.size() < length; i++)
+  {
+    snprintf(entry, sizeof(entry), "{\"symbol\":\"S%d\",\"latestPrice\":%d.%02d,\"change\":%d},", i, 10 + i * 7 % 990, i % 100, i % 13 - 6);
+    text += entry;
+  }
+  text.resize(length);
+  return text;
+}
+
+void test_inflates_small_body()
+{
+  std::string text = "{\"symbol\":\"AG\",\"latestPrice\":16.36}";
+  std::vector<uint8_t> body = Gzip(text);
+  MemoryStream source(body);
+  GzipStream gzip(source);
+  TEST_ASSERT_TRUE(gzip.Begin());
+  TEST_ASSERT_EQUAL_STRING(text.c_str(), ReadAll(gzip).c_str());
+  TEST_ASSERT_FALSE(gzip.Failed());
+  TEST_ASSERT_EQUAL(-1, gzip.read());
+}
+
+void test_read_and_peek_byte_by_byte()
+{
+  std::string text = QuoteText(5000);
+  std::vector<uint8_t> body = Gzip(text);
+  MemoryStream source(body, 7);
+  GzipStream gzip(source);
+  TEST_ASSERT_TRUE(gzip.Begin());
+
+  std::string read;
+  int c;
+  while ((c = gzip.peek()) >= 0)
+  {
+    TEST_ASSERT_EQUAL(c, gzip.read());
+    read += (char)c;
+  }
+  TEST_ASSERT_EQUAL_STRING(text.c_str(), read.c_str());
+  TEST_ASSERT_FALSE(gzip.Failed());
+}
+
+// Several times the 32 KB window, fed a few bytes at a time.
+void test_inflates_across_window_wraps()
+{
+  std::string text = QuoteText(200000);
+  std::vector<uint8_t> body = Gzip(text);
+  MemoryStream source(body, 61);
+  GzipStream gzip(source);
+  TEST_ASSERT_TRUE(gzip.Begin());
+  std::string inflated = ReadAll(gzip);
+  TEST_ASSERT_EQUAL_size_t(text.size(), inflated.size());
+  TEST_ASSERT_TRUE(inflated == text);
+  TEST_ASSERT_FALSE(gzip.Failed());
+}
+
+// Extra field, file name, comment and header CRC are skipped.
+void test_skips_optional_header_fields()
+{
+  std::string text = QuoteText(1000);
+  std::vector<uint8_t> body = {0x1f, 0x8b, 8, 0x02 | 0x04 | 0x08 | 0x10, 0, 0, 0, 0, 0, 3};
+  body.insert(body.end(), {4, 0, 'a', 'b', 'c', 'd'});
+  body.insert(body.end(), {'q', '.', 'j', 's', 'o', 'n', 0});
+  body.insert(body.end(), {'h', 'i', 0});
+  body.insert(body.end(), {0x12, 0x34});
+  std::vector<uint8_t> deflated = Deflate(text, -15);
+  body.insert(body.end(), deflated.begin(), deflated.end());
+
+  MemoryStream source(body);
+  GzipStream gzip(source);
+  TEST_ASSERT_TRUE(gzip.Begin());
+  TEST_ASSERT_TRUE(ReadAll(gzip) == text);
+  TEST_ASSERT_FALSE(gzip.Failed());
+}
+
+void test_rejects_plain_body()
+{
+  std::string text = "{\"symbol\":\"AG\",\"latestPrice\":16.36}";
+  std::vector<uint8_t> body(text.begin(), text.end());
+  MemoryStream source(body);
+  GzipStream gzip(source);
+  TEST_ASSERT_FALSE(gzip.Begin());
+  TEST_ASSERT_TRUE(gzip.Failed());
+  TEST_ASSERT_EQUAL(-1, gzip.read());
+}
+
+void test_rejects_empty_and_short_header()
+{
+  std::vector<uint8_t> empty;
+  MemoryStream emptySource(empty);
+  GzipStream emptyGzip(emptySource);
+  TEST_ASSERT_FALSE(emptyGzip.Begin());
+  TEST_ASSERT_TRUE(emptyGzip.Failed());
+
+  std::vector<uint8_t> header = {0x1f, 0x8b, 8, 0};
+  MemoryStream headerSource(header);
+  GzipStream headerGzip(headerSource);
+  TEST_ASSERT_FALSE(headerGzip.Begin());
+  TEST_ASSERT_TRUE(headerGzip.Failed());
+}
+
+// Block type 3 is reserved, the inflater stops with an error.
+void test_fails_on_corrupt_data()
+{
+  std::vector<uint8_t> body = Gzip(QuoteText(4000));
+  body[10] = 0x07;
+  MemoryStream source(body);
+  GzipStream gzip(source);
+  TEST_ASSERT_TRUE(gzip.Begin());
+  ReadAll(gzip);
+  TEST_ASSERT_TRUE(gzip.Failed());
+  TEST_ASSERT_EQUAL(-1, gzip.read());
+}
+
+// A body cut short hands out what was inflated, then reports the failure.
+void test_fails_on_truncated_data()
+{
+  std::string text = QuoteText(100000);
+  std::vector<uint8_t> body = Gzip(text);
+  body.resize(body.size() / 2);
+  MemoryStream source(body, 100);
+  GzipStream gzip(source);
+  TEST_ASSERT_TRUE(gzip.Begin());
+  std::string inflated = ReadAll(gzip);
+  TEST_ASSERT_TRUE(gzip.Failed());
+  TEST_ASSERT_GREATER_THAN(0, inflated.size());
+  TEST_ASSERT_LESS_THAN(text.size(), inflated.size());
+  TEST_ASSERT_TRUE(text.compare(0, inflated.size(), inflated) == 0);
+}
+
+// An IEX batch of 100 quotes, parsed plain and through the inflater as the fetch path does.
+void test_benchmark_inflate_and_parse()
+{
+  const char *quote =
+    "{\"quote\":{\"symbol\":\"S%03d\",\"companyName\":\"First Majestic Silver Corporation\","
+    "\"primaryExchange\":\"NEW YORK STOCK EXCHANGE, INC.\",\"calculationPrice\":\"close\",\"open\":null,"
+    "\"close\":null,\"high\":null,\"highTime\":1615409996440,\"low\":null,\"lowTime\":1615390845491,"
+    "\"latestPrice\":%d.%02d,\"latestSource\":\"Close\",\"latestTime\":\"March 10, 2021\","
+    "\"latestUpdate\":1615410000481,\"latestVolume\":null,\"previousClose\":16.44,\"change\":-0.08,"
+    "\"changePercent\":-0.00487,\"marketCap\":3662304848,\"peRatio\":-1117.85,\"week52High\":24.08,"
+    "\"week52Low\":4.06,\"ytdChange\":0.175926,\"isUSMarketOpen\":false}}";
+  const int symbols = 100;
+  const int rounds = 50;
+
+  std::string text = "{";
+  char entry[1024];
+  for (int i = 0; i < symbols; i++)
+  {
+    int length = snprintf(entry, sizeof(entry), "\"S%03d\":", i);
+    snprintf(entry + length, sizeof(entry) - length, quote, i, 10 + i, i % 100);
+    text += (i > 0 ? "," : "") + std::string(entry);
+  }
+  text += "}";
+  std::vector<uint8_t> plain(text.begin(), text.end());
+  std::vector<uint8_t> body = Gzip(text);
+
+  DynamicJsonDocument doc(64 * 1024);
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++)
+  {
+    MemoryStream source(plain);
+    TEST_ASSERT_FALSE(deserializeJson(doc, source));
+  }
+  auto parse = std::chrono::steady_clock::now() - start;
+
+  start = std::chrono::steady_clock::now();
+  for (int i = 0; i < rounds; i++)
+  {
+    MemoryStream source(body);
+    GzipStream gzip(source);
+    TEST_ASSERT_TRUE(gzip.Begin());
+    TEST_ASSERT_FALSE(deserializeJson(doc, gzip));
+    TEST_ASSERT_FALSE(gzip.Failed());
+  }
+  auto inflateParse = std::chrono::steady_clock::now() - start;
+
+  double parseMs = std::chrono::duration<double, std::milli>(parse).count() / rounds;
+  double inflateParseMs = std::chrono::duration<double, std::milli>(inflateParse).count() / rounds;
+  char message[160];
+  snprintf(message, sizeof(message), "%u bytes gzipped to %u (%.1f%%), parse %.3f ms, inflate and parse %.3f ms, %.1f MB/s inflated",
+             (unsigned)plain.size(), (unsigned)body.size(), 100.0 * body.size() / plain.size(), parseMs, inflateParseMs,
+             plain.size() / inflateParseMs / 1000.0);
+  TEST_MESSAGE(message);
+  TEST_ASSERT_LESS_THAN(plain.size() / 4, body.size());
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_inflates_small_body);
+  RUN_TEST(test_read_and_peek_byte_by_byte);
+  RUN_TEST(test_inflates_across_window_wraps);
+  RUN_TEST(test_skips_optional_header_fields);
+  RUN_TEST(test_rejects_plain_body);
+  RUN_TEST(test_rejects_empty_and_short_header);
+  RUN_TEST(test_fails_on_corrupt_data);
+  RUN_TEST(test_fails_on_truncated_data);
+  RUN_TEST(test_benchmark_inflate_and_parse);
+  return UNITY_END();
+}
@@ -0,0 +1,318 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <limits.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+#include "httpDeadline.h"
+
+// Scripted connection: data arrives at set times, the peer can hang up and the
+// request can be cancelled at a set time. Time moves only while the stream waits.
+class FakeClient : public WiFiClient
+{
+public:
+  struct Arrival
+  {
+    unsigned long at;
+    std::string data;
+  };
+
+  std::vector<Arrival> arrivals;
+  unsigned long disconnectAt = ULONG_MAX;
+  unsigned long cancelAt = ULONG_MAX;
+  std::atomic<bool> *cancel = NULL;
+  SocketWatch *watch = NULL;
+  bool waitedUnwatched = false;
+
+  void SetSocket(int fd) { socket = fd; }
+
+  uint8_t connected() override
+  {
+    Advance();
+    return millis() < disconnectAt || !buffer.empty();
+  }
+
+  int available() override
+  {
+    Advance();
+    return buffer.size();
+  }
+
+  int read() override
+  {
+    Advance();
+    if (buffer.empty())
+    {
+      return -1;
+    }
+    int c = (uint8_t)buffer[0];
+    buffer.erase(0, 1);
+    return c;
+  }
+
+  int peek() override
+  {
+    Advance();
+    return buffer.empty() ? -1 : (uint8_t)buffer[0];
+  }
+
+  size_t readBytes(char *out, size_t length) override
+  {
+    Advance();
+    size_t count = min(length, buffer.size());
+    memcpy(out, buffer.data(), count);
+    buffer.erase(0, count);
+    return count;
+  }
+
+private:
+  void Advance()
+  {
+    if (watch != NULL && !watch->Waiting())
+    {
+      waitedUnwatched = true;
+    }
+    while (!arrivals.empty() && arrivals.front().at <= millis())
+    {
+      buffer += arrivals.front().data;
+      arrivals.erase(arrivals.begin());
+    }
+    if (cancel != NULL && millis() >= cancelAt)
+    {
+      *cancel = true;
+    }
+  }
+
+  std::string buffer;
+};
+
+// Exposes the TLS session's socket to the test.
+class FakeClientSecure : public WatchedClientSecure
+{
+public:
+  void SetSocket(int fd) { sslclient->socket = fd; }
+};
+
+static std::atomic<bool> cancel(false);
+
+void setUp()
+{
+  HostMillis() = 1000;
+  cancel = false;
+}
+
+void tearDown() {}
+
+static std::string ReadAll(DeadlineStream &stream)
+{
+  std::string text;
+  char buf[16];
+  size_t count;
+  while ((count = stream.readBytes(buf, sizeof(buf))) > 0)
+  {
+    text.append(buf, count);
+  }
+  return text;
+}
+
+void test_reads_body_within_deadline()
+{
+  FakeClient client;
+  client.arrivals = {{1000, "{\"symbol\":"}, {1200, "\"AG\"}"}};
+  client.disconnectAt = 1300;
+  DeadlineStream stream(client, 5000, cancel);
+
+  TEST_ASSERT_EQUAL_STRING("{\"symbol\":\"AG\"}", ReadAll(stream).c_str());
+  TEST_ASSERT_FALSE(stream.Expired());
+  TEST_ASSERT_FALSE(stream.Cancelled());
+  TEST_ASSERT_LESS_THAN(1310, millis());
+}
+
+// The server stops sending but keeps the connection open.
+void test_stalled_body_expires_at_deadline()
+{
+  FakeClient client;
+  client.arrivals = {{1000, "{\"symbol\":"}, {60000, "\"AG\"}"}};
+  DeadlineStream stream(client, 2000, cancel);
+
+  TEST_ASSERT_EQUAL_STRING("{\"symbol\":", ReadAll(stream).c_str());
+  TEST_ASSERT_TRUE(stream.Expired());
+  TEST_ASSERT_GREATER_OR_EQUAL(3000, millis());
+  TEST_ASSERT_LESS_THAN(3010, millis());
+  TEST_ASSERT_EQUAL(-1, stream.read());
+  TEST_ASSERT_EQUAL(-1, stream.peek());
+  TEST_ASSERT_EQUAL(0, stream.available());
+}
+
+// Data trickling in does not extend the deadline.
+void test_trickle_does_not_extend_deadline()
+{
+  FakeClient client;
+  for (unsigned long at = 1000; at < 20000; at += 500)
+  {
+    client.arrivals.push_back({at, "x"});
+  }
+  DeadlineStream stream(client, 3000, cancel);
+
+  std::string body = ReadAll(stream);
+  TEST_ASSERT_TRUE(stream.Expired());
+  TEST_ASSERT_EQUAL_size_t(7, body.size()); // 1000 to 4000, the last one on the deadline.
+  TEST_ASSERT_LESS_THAN(4010, millis());
+}
+
+void test_cancel_while_waiting()
+{
+  FakeClient client;
+  client.arrivals = {{1000, "{\"sym"}, {9000, "bol\"}"}};
+  client.cancel = &cancel;
+  client.cancelAt = 1500;
+  DeadlineStream stream(client, 10000, cancel);
+
+  TEST_ASSERT_EQUAL_STRING("{\"sym", ReadAll(stream).c_str());
+  TEST_ASSERT_TRUE(stream.Cancelled());
+  TEST_ASSERT_FALSE(stream.Expired());
+  TEST_ASSERT_LESS_THAN(1510, millis());
+}
+
+// Data already received is not handed out once the request is cancelled.
+void test_cancel_before_read()
+{
+  FakeClient client;
+  client.arrivals = {{1000, "{\"symbol\":\"AG\"}"}};
+  DeadlineStream stream(client, 10000, cancel);
+  cancel = true;
+
+  TEST_ASSERT_EQUAL(0, stream.available());
+  TEST_ASSERT_EQUAL(-1, stream.read());
+  TEST_ASSERT_EQUAL(-1, stream.peek());
+  TEST_ASSERT_EQUAL_size_t(0, ReadAll(stream).size());
+}
+
+// The peer hanging up ends the body at once, it is not a timeout.
+void test_disconnect_ends_body()
+{
+  FakeClient client;
+  client.arrivals = {{1000, "{\"symbol\":"}};
+  client.disconnectAt = 1100;
+  DeadlineStream stream(client, 10000, cancel);
+
+  TEST_ASSERT_EQUAL_STRING("{\"symbol\":", ReadAll(stream).c_str());
+  TEST_ASSERT_FALSE(stream.Expired());
+  TEST_ASSERT_FALSE(stream.Cancelled());
+  TEST_ASSERT_LESS_THAN(1110, millis());
+}
+
+// Every wait and read on the client happens inside a watched call.
+void test_reads_are_watched()
+{
+  SocketWatch watch;
+  watch.Begin();
+  FakeClient client;
+  client.arrivals = {{1000, "ab"}, {1500, "cd"}};
+  client.disconnectAt = 1600;
+  client.watch = &watch;
+  DeadlineStream stream(client, 5000, cancel, &watch);
+
+  TEST_ASSERT_EQUAL('a', stream.peek());
+  TEST_ASSERT_EQUAL('a', stream.read());
+  TEST_ASSERT_EQUAL_STRING("bcd", ReadAll(stream).c_str());
+  TEST_ASSERT_FALSE(client.waitedUnwatched);
+  TEST_ASSERT_FALSE(watch.Waiting());
+}
+
+void test_abort_shuts_the_socket_down()
+{
+  int fds[2];
+  TEST_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+  SocketWatch watch;
+  watch.Begin();
+  TEST_ASSERT_FALSE(watch.Abort());
+
+  FakeClient client;
+  watch.Attach(client, false);
+  TEST_ASSERT_FALSE(watch.Abort()); // Not connected yet.
+
+  client.SetSocket(fds[0]);
+  TEST_ASSERT_TRUE(watch.Abort());
+  char c;
+  TEST_ASSERT_EQUAL(0, recv(fds[1], &c, 1, 0)); // The peer sees the connection closed.
+
+  watch.Detach();
+  TEST_ASSERT_FALSE(watch.Abort());
+  close(fds[0]);
+  close(fds[1]);
+}
+
+void test_abort_reaches_the_tls_socket()
+{
+  int fds[2];
+  TEST_ASSERT_EQUAL(0, socketpair(AF_UNIX, SOCK_STREAM, 0, fds));
+
+  SocketWatch watch;
+  watch.Begin();
+  FakeClientSecure client;
+  watch.Attach(client, true);
+  TEST_ASSERT_FALSE(watch.Abort());
+
+  client.SetSocket(fds[0]);
+  TEST_ASSERT_TRUE(watch.Abort());
+  char c;
+  TEST_ASSERT_EQUAL(0, recv(fds[1], &c, 1, 0));
+  watch.Detach();
+  close(fds[0]);
+  close(fds[1]);
+}
+
+void test_watched_call_and_reset()
+{
+  SocketWatch watch;
+  watch.Begin();
+  {
+    WatchedCall call(&watch);
+    TEST_ASSERT_TRUE(watch.Waiting());
+  }
+  TEST_ASSERT_FALSE(watch.Waiting());
+
+  FakeClient client;
+  watch.Attach(client, false);
+  watch.Enter();
+  watch.Reset();
+  TEST_ASSERT_FALSE(watch.Waiting());
+  TEST_ASSERT_FALSE(watch.Abort());
+
+  WatchedCall unwatched(NULL);
+}
+
+void test_host_from_url()
+{
+  TEST_ASSERT_EQUAL_STRING("cloud.iexapis.com", HostFromUrl("https://cloud.iexapis.com/stable/stock/market/batch?token=x").c_str());
+  TEST_ASSERT_EQUAL_STRING("192.168.1.20", HostFromUrl("http://192.168.1.20:8080/quotes").c_str());
+  TEST_ASSERT_EQUAL_STRING("example.com", HostFromUrl("example.com?a=1").c_str());
+}
+
+void test_resolve_literal_address()
+{
+  bool timedOut = true;
+  TEST_ASSERT_TRUE(ResolveHost("192.168.1.20", 1000, &timedOut));
+  TEST_ASSERT_FALSE(timedOut);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_reads_body_within_deadline);
+  RUN_TEST(test_stalled_body_expires_at_deadline);
+  RUN_TEST(test_trickle_does_not_extend_deadline);
+  RUN_TEST(test_cancel_while_waiting);
+  RUN_TEST(test_cancel_before_read);
+  RUN_TEST(test_disconnect_ends_body);
+  RUN_TEST(test_reads_are_watched);
+  RUN_TEST(test_abort_shuts_the_socket_down);
+  RUN_TEST(test_abort_reaches_the_tls_socket);
+  RUN_TEST(test_watched_call_and_reset);
+  RUN_TEST(test_host_from_url);
+  RUN_TEST(test_resolve_literal_address);
+  return UNITY_END();
+}
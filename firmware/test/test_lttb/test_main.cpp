@@ -0,0 +1,131 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <vector>
+#include "lttb.h"
+
+void setUp() {}
+void tearDown() {}
+
+static const uint32_t sessionStart = 1615386600; // 09:30 New York, a real epoch keeps the times large.
+
+// A session of one minute points, a random walk around price.
+static std::vector<HistoryPoint> Session(size_t count, int32_t price)
+{
+  std::vector<HistoryPoint> points;
+  uint32_t seed = 42;
+  for (size_t i = 0; i < count; i++)
+  {
+    seed = seed * 1103515245 + 12345;
+    price += (int32_t)(seed >> 16) % 21 - 10;
+    points.push_back({sessionStart + (uint32_t)i * 60, price});
+  }
+  return points;
+}
+
+static bool Contains(const std::vector<HistoryPoint> &points, const HistoryPoint &point)
+{
+  for (auto &p : points)
+  {
+    if (p.epoch == point.epoch && p.price == point.price)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+void test_short_series_is_copied()
+{
+  std::vector<HistoryPoint> points = Session(100, 1636);
+  std::vector<HistoryPoint> out = {{1, 2}};
+  LttbDownsample(points.data(), points.size(), 320, &out);
+  TEST_ASSERT_EQUAL_size_t(101, out.size());
+  TEST_ASSERT_EQUAL_UINT32(1, out[0].epoch); // Appended, what was there stays.
+  TEST_ASSERT_EQUAL_MEMORY(points.data(), out.data() + 1, points.size() * sizeof(HistoryPoint));
+
+  out.clear();
+  LttbDownsample(points.data(), points.size(), 100, &out);
+  TEST_ASSERT_EQUAL_size_t(100, out.size());
+
+  out.clear();
+  LttbDownsample(points.data(), 0, 320, &out);
+  TEST_ASSERT_EQUAL_size_t(0, out.size());
+}
+
+// Fewer than three points cannot hold the ends and a bucket, the series is copied.
+void test_tiny_threshold_copies()
+{
+  std::vector<HistoryPoint> points = Session(50, 1636);
+  std::vector<HistoryPoint> out;
+  LttbDownsample(points.data(), points.size(), 2, &out);
+  TEST_ASSERT_EQUAL_size_t(50, out.size());
+}
+
+// A full session into the chart width: the ends are kept, one point per bucket in time order.
+void test_session_to_chart_width()
+{
+  std::vector<HistoryPoint> points = Session(390, 1636);
+  std::vector<HistoryPoint> out;
+  LttbDownsample(points.data(), points.size(), 320, &out);
+
+  TEST_ASSERT_EQUAL_size_t(320, out.size());
+  TEST_ASSERT_EQUAL_UINT32(points.front().epoch, out.front().epoch);
+  TEST_ASSERT_EQUAL_UINT32(points.back().epoch, out.back().epoch);
+  for (size_t i = 0; i < out.size(); i++)
+  {
+    TEST_ASSERT_TRUE(Contains(points, out[i]));
+    if (i > 0)
+    {
+      TEST_ASSERT_GREATER_THAN(out[i - 1].epoch, out[i].epoch);
+    }
+  }
+}
+
+// Plain decimation would step over a one minute spike, LTTB keeps it.
+void test_keeps_peaks_and_troughs()
+{
+  std::vector<HistoryPoint> points;
+  for (uint32_t i = 0; i < 390; i++)
+  {
+    points.push_back({sessionStart + i * 60, 1636});
+  }
+  points[101].price = 1900;
+  points[257].price = 1400;
+
+  std::vector<HistoryPoint> out;
+  LttbDownsample(points.data(), points.size(), 40, &out);
+  TEST_ASSERT_EQUAL_size_t(40, out.size());
+  TEST_ASSERT_TRUE(Contains(out, points[101]));
+  TEST_ASSERT_TRUE(Contains(out, points[257]));
+}
+
+// Worked by hand: two buckets of four, each keeps the point furthest off the line
+// from the last kept point to the next bucket's average.
+void test_small_series_by_hand()
+{
+  const int32_t prices[] = {10, 11, 30, 12, 10, 9, -5, 11, 10, 10};
+  std::vector<HistoryPoint> points;
+  for (uint32_t i = 0; i < 10; i++)
+  {
+    points.push_back({sessionStart + i * 60, prices[i]});
+  }
+
+  std::vector<HistoryPoint> out;
+  LttbDownsample(points.data(), points.size(), 4, &out);
+  TEST_ASSERT_EQUAL_size_t(4, out.size());
+  TEST_ASSERT_EQUAL_INT32(10, out[0].price);
+  TEST_ASSERT_EQUAL_INT32(30, out[1].price);
+  TEST_ASSERT_EQUAL_INT32(-5, out[2].price);
+  TEST_ASSERT_EQUAL_INT32(10, out[3].price);
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_short_series_is_copied);
+  RUN_TEST(test_tiny_threshold_copies);
+  RUN_TEST(test_session_to_chart_width);
+  RUN_TEST(test_keeps_peaks_and_troughs);
+  RUN_TEST(test_small_series_by_hand);
+  return UNITY_END();
+}
@@ -0,0 +1,198 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <string.h>
+#include <vector>
+#include "peerDatagram.h"
+#include "fixedPoint.h"
+
+void setUp() {}
+void tearDown() {}
+
+static const uint32_t deviceId = 0xA1B2C3D4;
+
+static Quote SampleQuote()
+{
+  Quote quote;
+  quote.fields = QuoteFieldAll;
+  quote.companyName = "Newmont Corporation";
+  quote.decimals = 2;
+  quote.openPrice = 4512;
+  quote.currentPrice = 4562;
+  quote.change = 50;
+  quote.changePercent = 111;
+  quote.peRatio = 1834;
+  quote.week52High = 7266;
+  quote.week52Low = -1; // Signed fields survive the trip.
+  quote.latestUpdate = 1615386600123ull;
+  return quote;
+}
+
+void test_hash_symbol()
+{
+  TEST_ASSERT_EQUAL_UINT32(2166136261u, PeerHashSymbol("")); // FNV-1a offset basis.
+  TEST_ASSERT_EQUAL_UINT32(0xC40BF6CCu, PeerHashSymbol("A"));
+  TEST_ASSERT_EQUAL_UINT32(PeerHashSymbol("BRK.B"), PeerHashSymbol("brk.b"));
+  TEST_ASSERT_TRUE(PeerHashSymbol("NEM") != PeerHashSymbol("MEN"));
+}
+
+void test_header()
+{
+  uint8_t buf[peerMaxDatagramSize];
+  size_t length = PeerEncodeAnnounce(buf, sizeof(buf), deviceId, {});
+  TEST_ASSERT_EQUAL_size_t(peerHeaderSize + 2, length);
+
+  const uint8_t expected[] = {'Q', 'B', 'P', '1', peerMessageAnnounce, 0xD4, 0xC3, 0xB2, 0xA1, 0, 0};
+  TEST_ASSERT_EQUAL_MEMORY(expected, buf, sizeof(expected)); // Little endian on the wire.
+
+  uint8_t type = 0;
+  uint32_t id = 0;
+  TEST_ASSERT_TRUE(PeerDecodeHeader(buf, length, &type, &id));
+  TEST_ASSERT_EQUAL_UINT8(peerMessageAnnounce, type);
+  TEST_ASSERT_EQUAL_UINT32(deviceId, id);
+
+  TEST_ASSERT_FALSE(PeerDecodeHeader(buf, peerHeaderSize - 1, &type, &id));
+  buf[3] = '2';
+  TEST_ASSERT_FALSE(PeerDecodeHeader(buf, length, &type, &id));
+}
+
+void test_announce_round_trip()
+{
+  std::vector<uint32_t> hashes = {PeerHashSymbol("NEM"), PeerHashSymbol("AAPL"), 0, 0xFFFFFFFF};
+  uint8_t buf[peerMaxDatagramSize];
+  size_t length = PeerEncodeAnnounce(buf, sizeof(buf), deviceId, hashes);
+  TEST_ASSERT_EQUAL_size_t(peerHeaderSize + 2 + 4 * 4, length);
+
+  std::vector<uint32_t> decoded = {1, 2};
+  TEST_ASSERT_TRUE(PeerDecodeAnnounce(buf, length, &decoded));
+  TEST_ASSERT_TRUE(hashes == decoded);
+
+  for (size_t cut = 0; cut < length; cut++)
+  {
+    TEST_ASSERT_FALSE(PeerDecodeAnnounce(buf, cut, &decoded));
+  }
+}
+
+// A watchlist too long for one datagram announces what fits.
+void test_announce_fits_datagram()
+{
+  std::vector<uint32_t> hashes(500);
+  for (size_t i = 0; i < hashes.size(); i++)
+  {
+    hashes[i] = i;
+  }
+  uint8_t buf[peerMaxDatagramSize];
+  size_t length = PeerEncodeAnnounce(buf, sizeof(buf), deviceId, hashes);
+  TEST_ASSERT_GREATER_THAN(0, length);
+  TEST_ASSERT_LESS_OR_EQUAL(peerMaxDatagramSize, length);
+
+  std::vector<uint32_t> decoded;
+  TEST_ASSERT_TRUE(PeerDecodeAnnounce(buf, length, &decoded));
+  TEST_ASSERT_EQUAL_size_t((length - peerHeaderSize - 2) / 4, decoded.size());
+  TEST_ASSERT_EQUAL_UINT32(decoded.size() - 1, decoded.back());
+
+  TEST_ASSERT_EQUAL_size_t(0, PeerEncodeAnnounce(buf, length - 1, deviceId, hashes));
+}
+
+void test_quote_round_trip()
+{
+  Quote quote = SampleQuote();
+  uint8_t buf[peerMaxDatagramSize];
+  size_t length = PeerEncodeQuote(buf, sizeof(buf), deviceId, "NEM", quote);
+  TEST_ASSERT_EQUAL_size_t(peerHeaderSize + 1 + 3 + 2 + 1 + 7 * 4 + 8 + 1 + quote.companyName.length(), length);
+
+  uint8_t type = 0;
+  uint32_t id = 0;
+  TEST_ASSERT_TRUE(PeerDecodeHeader(buf, length, &type, &id));
+  TEST_ASSERT_EQUAL_UINT8(peerMessageQuote, type);
+
+  PeerQuote peerQuote;
+  TEST_ASSERT_TRUE(PeerDecodeQuote(buf, length, &peerQuote));
+  TEST_ASSERT_EQUAL_STRING("NEM", peerQuote.symbol);
+
+  Quote decoded;
+  PeerQuoteToQuote(peerQuote, &decoded);
+  TEST_ASSERT_EQUAL_UINT16(quote.fields, decoded.fields);
+  TEST_ASSERT_EQUAL_STRING(quote.companyName.c_str(), decoded.companyName.c_str());
+  TEST_ASSERT_EQUAL_UINT8(quote.decimals, decoded.decimals);
+  TEST_ASSERT_EQUAL_INT32(quote.openPrice, decoded.openPrice);
+  TEST_ASSERT_EQUAL_INT32(quote.currentPrice, decoded.currentPrice);
+  TEST_ASSERT_EQUAL_INT32(quote.change, decoded.change);
+  TEST_ASSERT_EQUAL_INT32(quote.changePercent, decoded.changePercent);
+  TEST_ASSERT_EQUAL_INT32(quote.peRatio, decoded.peRatio);
+  TEST_ASSERT_EQUAL_INT32(quote.week52High, decoded.week52High);
+  TEST_ASSERT_EQUAL_INT32(quote.week52Low, decoded.week52Low);
+  TEST_ASSERT_EQUAL_UINT64(quote.latestUpdate, decoded.latestUpdate);
+}
+
+// The company name is only sent with its field, long texts are cut to what a peer accepts.
+void test_quote_texts()
+{
+  Quote quote = SampleQuote();
+  quote.fields = QuoteFieldLatestPrice;
+  uint8_t buf[peerMaxDatagramSize];
+  PeerQuote peerQuote;
+  size_t length = PeerEncodeQuote(buf, sizeof(buf), deviceId, "NEM", quote);
+  TEST_ASSERT_TRUE(PeerDecodeQuote(buf, length, &peerQuote));
+  TEST_ASSERT_EQUAL_STRING("", peerQuote.companyName);
+
+  quote.fields = QuoteFieldAll;
+  quote.companyName = "";
+  for (int i = 0; i < 100; i++)
+  {
+    quote.companyName += 'N';
+  }
+  length = PeerEncodeQuote(buf, sizeof(buf), deviceId, "ABCDEFGHIJKLMNOPQRST", quote);
+  TEST_ASSERT_TRUE(PeerDecodeQuote(buf, length, &peerQuote));
+  TEST_ASSERT_EQUAL_STRING("ABCDEFGHIJKLMNOP", peerQuote.symbol);
+  TEST_ASSERT_EQUAL_size_t(peerMaxCompanyNameLength, strlen(peerQuote.companyName));
+}
+
+void test_quote_truncated()
+{
+  uint8_t buf[peerMaxDatagramSize];
+  PeerQuote peerQuote;
+  size_t length = PeerEncodeQuote(buf, sizeof(buf), deviceId, "NEM", SampleQuote());
+  for (size_t cut = 0; cut < length; cut++)
+  {
+    TEST_ASSERT_FALSE(PeerDecodeQuote(buf, cut, &peerQuote));
+  }
+
+  for (size_t size = 0; size < length; size++)
+  {
+    TEST_ASSERT_EQUAL_size_t(0, PeerEncodeQuote(buf, size, deviceId, "NEM", SampleQuote()));
+  }
+}
+
+// Datagrams from a misbehaving peer are refused rather than ingested.
+void test_quote_out_of_range()
+{
+  uint8_t buf[peerMaxDatagramSize];
+  PeerQuote peerQuote;
+  Quote quote = SampleQuote();
+
+  size_t length = PeerEncodeQuote(buf, sizeof(buf), deviceId, "", quote);
+  TEST_ASSERT_FALSE(PeerDecodeQuote(buf, length, &peerQuote));
+
+  quote.decimals = fixedMaxDecimals + 1;
+  length = PeerEncodeQuote(buf, sizeof(buf), deviceId, "NEM", quote);
+  TEST_ASSERT_FALSE(PeerDecodeQuote(buf, length, &peerQuote));
+
+  // A symbol longer than any this codec sends is rejected, not cut.
+  length = PeerEncodeQuote(buf, sizeof(buf), deviceId, "NEM", SampleQuote());
+  buf[peerHeaderSize] = peerMaxSymbolLength + 1;
+  TEST_ASSERT_FALSE(PeerDecodeQuote(buf, length, &peerQuote));
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_hash_symbol);
+  RUN_TEST(test_header);
+  RUN_TEST(test_announce_round_trip);
+  RUN_TEST(test_announce_fits_datagram);
+  RUN_TEST(test_quote_round_trip);
+  RUN_TEST(test_quote_texts);
+  RUN_TEST(test_quote_truncated);
+  RUN_TEST(test_quote_out_of_range);
+  return UNITY_END();
+}
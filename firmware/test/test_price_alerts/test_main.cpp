@@ -0,0 +1,183 @@
+#include <unity.h>
+#include <Arduino.h>
+#include <vector>
+#include "priceAlerts.h"
+
+static const int32_t hysteresis = 50; // 0.5 %, hundredths of a percent.
+static const uint8_t above = 1 << int(AlertKind::Above);
+static const uint8_t below = 1 << int(AlertKind::Below);
+static const uint8_t movePercent = 1 << int(AlertKind::MovePercent);
+static const uint8_t near52WeekHigh = 1 << int(AlertKind::Near52WeekHigh);
+static const uint8_t near52WeekLow = 1 << int(AlertKind::Near52WeekLow);
+
+static std::vector<SymbolData> symbols;
+
+void setUp()
+{
+  symbols.assign(3, SymbolData());
+  symbols[0].symbol = "NEM";
+  symbols[1].symbol = "AAPL";
+  symbols[2].symbol = "OTC";
+  symbols[2].decimals = 4;
+}
+
+void tearDown() {}
+
+static void Compile(const std::vector<AlertRule> &rules)
+{
+  CompileAlerts(symbols, rules);
+}
+
+// Ingests a price at the symbol's scale and returns what fired.
+static uint8_t Quote(SymbolData &symbolData, int32_t price)
+{
+  symbolData.currentPrice = price;
+  return EvaluateAlerts(&symbolData, hysteresis);
+}
+
+void test_compile_scales_thresholds()
+{
+  Compile({{"nem", AlertKind::Above, 45.62}, {"AAPL", AlertKind::MovePercent, 5}, {"AAPL", AlertKind::Near52WeekHigh, 1.5},
+           {"MSFT", AlertKind::Above, 300}});
+
+  TEST_ASSERT_EQUAL_UINT8(above, symbols[0].alerts.rules); // Symbols match whatever their case.
+  TEST_ASSERT_EQUAL_INT64(45620000, symbols[0].alerts.thresholds[int(AlertKind::Above)]);
+  TEST_ASSERT_EQUAL_UINT8(movePercent | near52WeekHigh, symbols[1].alerts.rules);
+  TEST_ASSERT_EQUAL_INT64(500, symbols[1].alerts.thresholds[int(AlertKind::MovePercent)]);
+  TEST_ASSERT_EQUAL_INT64(150, symbols[1].alerts.thresholds[int(AlertKind::Near52WeekHigh)]);
+  TEST_ASSERT_EQUAL_UINT8(0, symbols[2].alerts.rules);
+
+  // Compiling again starts over, nothing fired or known is kept.
+  Quote(symbols[0], 4600);
+  Compile({{"OTC", AlertKind::Below, 0.0005}});
+  TEST_ASSERT_EQUAL_UINT8(0, symbols[0].alerts.rules);
+  TEST_ASSERT_EQUAL_UINT8(0, symbols[0].alerts.known);
+  TEST_ASSERT_EQUAL_UINT8(below, symbols[2].alerts.rules);
+}
+
+// A rule that already holds at boot or after a reload is not replayed.
+void test_first_quote_sets_side()
+{
+  Compile({{"NEM", AlertKind::Above, 45}});
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4600));
+  TEST_ASSERT_EQUAL_UINT8(above, symbols[0].alerts.known);
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4610));
+
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4450)); // Back past the band, armed.
+  TEST_ASSERT_EQUAL_UINT8(above, Quote(symbols[0], 4500));
+}
+
+// A price hovering at the threshold fires once, the band is 0.5 % of 45.00.
+void test_hysteresis()
+{
+  Compile({{"NEM", AlertKind::Above, 45}});
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4400));
+  TEST_ASSERT_EQUAL_UINT8(above, Quote(symbols[0], 4501));
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4499));
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4478)); // 45.00 - 0.225, still in the band.
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4502));
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4477));
+  TEST_ASSERT_EQUAL_UINT8(above, Quote(symbols[0], 4500));
+}
+
+void test_below()
+{
+  Compile({{"NEM", AlertKind::Below, 40}});
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4100));
+  TEST_ASSERT_EQUAL_UINT8(below, Quote(symbols[0], 4000));
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 3990));
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4010));
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4021)); // Past 40.00 + 0.20.
+  TEST_ASSERT_EQUAL_UINT8(below, Quote(symbols[0], 3999));
+}
+
+// Moves either way reach the threshold, the band is hysteresis itself.
+void test_move_percent()
+{
+  Compile({{"NEM", AlertKind::MovePercent, 5}});
+  symbols[0].changePercent = 120;
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4600));
+  symbols[0].changePercent = -510;
+  TEST_ASSERT_EQUAL_UINT8(movePercent, Quote(symbols[0], 4300));
+  symbols[0].changePercent = -460;
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4320));
+  symbols[0].changePercent = 449;
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4710));
+  symbols[0].changePercent = 500;
+  TEST_ASSERT_EQUAL_UINT8(movePercent, Quote(symbols[0], 4720));
+}
+
+// Until the provider reports a 52 week range the rules are skipped, not evaluated against zero.
+void test_near_52_week_range()
+{
+  Compile({{"NEM", AlertKind::Near52WeekHigh, 2}, {"NEM", AlertKind::Near52WeekLow, 2}});
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4600));
+  TEST_ASSERT_EQUAL_UINT8(0, symbols[0].alerts.known);
+
+  symbols[0].week52High = 5000; // Near from 49.00.
+  symbols[0].week52Low = 3000;  // Near up to 30.60.
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4600));
+  TEST_ASSERT_EQUAL_UINT8(near52WeekHigh | near52WeekLow, symbols[0].alerts.known);
+  TEST_ASSERT_EQUAL_UINT8(near52WeekHigh, Quote(symbols[0], 4900));
+  TEST_ASSERT_EQUAL_UINT8(near52WeekLow, Quote(symbols[0], 3060));
+}
+
+// Sub-dollar thresholds keep their digits, and a change of the symbol's scale does not move them.
+void test_thresholds_below_a_cent()
+{
+  Compile({{"OTC", AlertKind::Above, 0.0005}, {"OTC", AlertKind::Below, 0.0003}});
+  TEST_ASSERT_EQUAL_INT64(500, symbols[2].alerts.thresholds[int(AlertKind::Above)]);
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[2], 4));
+  TEST_ASSERT_EQUAL_UINT8(above, Quote(symbols[2], 5));
+  TEST_ASSERT_EQUAL_UINT8(below, Quote(symbols[2], 3));
+
+  Compile({{"NEM", AlertKind::Above, 45.625}});
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4562));
+  symbols[0].decimals = 4;
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 456249));
+  TEST_ASSERT_EQUAL_UINT8(above, Quote(symbols[0], 456250));
+}
+
+void test_no_rules_or_price()
+{
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 4600));
+  Compile({{"NEM", AlertKind::Below, 40}});
+  TEST_ASSERT_EQUAL_UINT8(0, Quote(symbols[0], 0)); // No quote yet.
+  TEST_ASSERT_EQUAL_UINT8(0, symbols[0].alerts.known);
+}
+
+void test_alert_text()
+{
+  AlertEvent event;
+  symbols[0].currentPrice = 4562;
+  MakeAlertEvent(symbols[0], AlertKind::Above, 1615386600, &event);
+  TEST_ASSERT_EQUAL_STRING("NEM rose to 45.62", AlertText(event).c_str());
+  TEST_ASSERT_EQUAL_UINT32(1615386600, event.epoch);
+  TEST_ASSERT_TRUE(AlertRise(event));
+
+  symbols[0].changePercent = -525;
+  MakeAlertEvent(symbols[0], AlertKind::MovePercent, 0, &event);
+  TEST_ASSERT_EQUAL_STRING("NEM moved -5.25%", AlertText(event).c_str());
+  TEST_ASSERT_FALSE(AlertRise(event));
+
+  symbols[2].decimals = 6;
+  symbols[2].currentPrice = 1234;
+  MakeAlertEvent(symbols[2], AlertKind::Near52WeekLow, 0, &event);
+  TEST_ASSERT_EQUAL_STRING("OTC near 52w low 0.0012", AlertText(event).c_str()); // At most 4 decimals.
+  TEST_ASSERT_FALSE(AlertRise(event));
+}
+
+int main(int argc, char **argv)
+{
+  UNITY_BEGIN();
+  RUN_TEST(test_compile_scales_thresholds);
+  RUN_TEST(test_first_quote_sets_side);
+  RUN_TEST(test_hysteresis);
+  RUN_TEST(test_below);
+  RUN_TEST(test_move_percent);
+  RUN_TEST(test_near_52_week_range);
+  RUN_TEST(test_thresholds_below_a_cent);
+  RUN_TEST(test_no_rules_or_price);
+  RUN_TEST(test_alert_text);
+  return UNITY_END();
+}
@@ -0,0 +1,42 @@
+#!/usr/bin/env python3
+"""
+    buildSymbolIndex.py
+
+    Builds symbols.idx for the SD card from a CSV listing of symbol,name
+    rows (a header row is skipped). See firmware/src/symbolIndex.h for
+    the file layout.
+
+    Usage: buildSymbolIndex.py listing.csv symbols.idx
+"""
+
+import csv
+import struct
+import sys
+
+SYMBOL_SIZE = 12
+NAME_SIZE = 36
+
+
+def main(source, destination):
+    records = {}
+    with open(source, newline="", encoding="utf-8") as f:
+        for row in csv.reader(f):
+            if len(row) < 2:
+                continue
+            symbol = row[0].strip().upper()
+            if symbol in ("SYMBOL", "TICKER") or not 0 < len(symbol) < SYMBOL_SIZE:
+                continue
+            records[symbol.encode("ascii", "ignore")] = row[1].strip().encode("ascii", "ignore")[:NAME_SIZE]
+
+    with open(destination, "wb") as f:
+        f.write(struct.pack("<4sIHH", b"QBS1", len(records), SYMBOL_SIZE + NAME_SIZE, 0))
+        for symbol in sorted(records):
+            f.write(struct.pack("<%ds%ds" % (SYMBOL_SIZE, NAME_SIZE), symbol, records[symbol]))
+
+    print("%u symbols written to %s" % (len(records), destination))
+
+
+if __name__ == "__main__":
+    if len(sys.argv) != 3:
+        sys.exit(__doc__)
+    main(sys.argv[1], sys.argv[2])